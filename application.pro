@@ -14,7 +14,16 @@ HEADERS += \
     sources/model.h \
     sources/pluginhandler.h \
     sources/shortcuthandler.h \
+    sources/postprocessing.h \
+    sources/renderscheduler.h \
+    sources/renderstatistics.h \
+    sources/renderstatisticsdialog.h \
     sources/rendertask.h \
+    sources/tilecache.h \
+    sources/disktilecache.h \
+    sources/memorymonitor.h \
+    sources/scrollpredictor.h \
+    sources/idleprerenderer.h \
     sources/tileitem.h \
     sources/pageitem.h \
     sources/thumbnailitem.h \
@@ -24,6 +33,8 @@ HEADERS += \
     sources/searchtask.h \
     sources/miscellaneous.h \
     sources/documentlayout.h \
+    sources/documentloader.h \
+    sources/lazypage.h \
     sources/documentview.h \
     sources/printdialog.h \
     sources/settingsdialog.h \
@@ -42,7 +53,16 @@ SOURCES += \
     sources/settings.cpp \
     sources/pluginhandler.cpp \
     sources/shortcuthandler.cpp \
+    sources/postprocessing.cpp \
+    sources/renderscheduler.cpp \
+    sources/renderstatistics.cpp \
+    sources/renderstatisticsdialog.cpp \
     sources/rendertask.cpp \
+    sources/tilecache.cpp \
+    sources/disktilecache.cpp \
+    sources/memorymonitor.cpp \
+    sources/scrollpredictor.cpp \
+    sources/idleprerenderer.cpp \
     sources/tileitem.cpp \
     sources/pageitem.cpp \
     sources/thumbnailitem.cpp \
@@ -52,6 +72,8 @@ SOURCES += \
     sources/searchtask.cpp \
     sources/miscellaneous.cpp \
     sources/documentlayout.cpp \
+    sources/documentloader.cpp \
+    sources/lazypage.cpp \
     sources/documentview.cpp \
     sources/printdialog.cpp \
     sources/settingsdialog.cpp \
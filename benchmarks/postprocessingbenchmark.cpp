@@ -0,0 +1,290 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QImage>
+#include <QPainter>
+
+#include "postprocessing.h"
+
+using namespace qpdfview;
+
+namespace
+{
+
+// The scalar implementations used by RenderTask before the post-processing kernels were introduced
+
+namespace Legacy
+{
+
+const QRgb alphaMask = 0xffu << 24;
+
+bool columnHasPaperColor(int x, QRgb paperColor, const QImage& image)
+{
+    const int height = image.height();
+
+    for(int y = 0; y < height; ++y)
+    {
+        const QRgb color = image.pixel(x, y);
+
+        if(qAlpha(color) != 0 && paperColor != (color | alphaMask))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool rowHasPaperColor(int y, QRgb paperColor, const QImage& image)
+{
+    const int width = image.width();
+
+    for(int x = 0; x < width; ++x)
+    {
+        const QRgb color = image.pixel(x, y);
+
+        if(qAlpha(color) != 0 && paperColor != (color | alphaMask))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+QRectF trimMargins(QRgb paperColor, const QImage& image)
+{
+    const int width = image.width();
+    const int height = image.height();
+
+    int left;
+    for(left = 0; left < width; ++left)
+    {
+        if(!columnHasPaperColor(left, paperColor, image))
+        {
+            break;
+        }
+    }
+    left = std::min(left, width / 3);
+
+    int right;
+    for(right = width - 1; right >= left; --right)
+    {
+        if(!columnHasPaperColor(right, paperColor, image))
+        {
+            break;
+        }
+    }
+    right = std::max(right, 2 * width / 3);
+
+    int top;
+    for(top = 0; top < height; ++top)
+    {
+        if(!rowHasPaperColor(top, paperColor, image))
+        {
+            break;
+        }
+    }
+    top = std::min(top, height / 3);
+
+    int bottom;
+    for(bottom = height - 1; bottom >= top; --bottom)
+    {
+        if(!rowHasPaperColor(bottom, paperColor, image))
+        {
+            break;
+        }
+    }
+    bottom = std::max(bottom, 2 * height / 3);
+
+    left = std::max(left - width / 100, 0);
+    top = std::max(top - height / 100, 0);
+
+    right = std::min(right + width / 100, width);
+    bottom = std::min(bottom + height / 100, height);
+
+    return {static_cast< qreal >(left) / width,
+            static_cast< qreal >(top) / height,
+            static_cast< qreal >(right - left) / width,
+            static_cast< qreal >(bottom - top) / height};
+}
+
+void convertToGrayscale(QImage& image)
+{
+    auto const begin = reinterpret_cast< QRgb* >(image.bits());
+    auto const end = reinterpret_cast< QRgb* >(image.bits() + image.sizeInBytes());
+
+    for(QRgb* pointer = begin; pointer != end; ++pointer)
+    {
+        const int gray = qGray(*pointer);
+        const int alpha = qAlpha(*pointer);
+
+        *pointer = qRgba(gray, gray, gray, alpha);
+    }
+}
+
+void composeWithColor(QPainter::CompositionMode mode, const QColor& color, QImage& image)
+{
+    QPainter painter(&image);
+
+    painter.setCompositionMode(mode);
+    painter.fillRect(image.rect(), color);
+}
+
+} // Legacy
+
+const int tileWidth = 3840;
+const int tileHeight = 2160;
+
+const QRgb paperColor = 0xffffffffu;
+const QRgb darkenColor = 0xfff5deb3u;
+
+// A page-like tile with wide margins and dense "text" in its body
+QImage createTile(QImage::Format format)
+{
+    QImage image(tileWidth, tileHeight, format);
+    image.fill(paperColor);
+
+    quint32 state = 0x12345678u;
+
+    for(int y = tileHeight / 8; y < tileHeight - tileHeight / 8; ++y)
+    {
+        auto const row = reinterpret_cast< QRgb* >(image.scanLine(y));
+
+        for(int x = tileWidth / 10; x < tileWidth - tileWidth / 10; ++x)
+        {
+            state = state * 1664525u + 1013904223u;
+
+            if((state >> 28) == 0)
+            {
+                row[x] = qRgb(state & 0xff, (state >> 8) & 0xff, (state >> 16) & 0xff);
+            }
+        }
+    }
+
+    return image;
+}
+
+double measure(int iterations, const QImage& tile, const std::function< void(QImage&) >& operation)
+{
+    qint64 elapsed = 0;
+
+    for(int iteration = 0; iteration < iterations; ++iteration)
+    {
+        QImage image = tile.copy();
+
+        QElapsedTimer timer;
+        timer.start();
+
+        operation(image);
+
+        elapsed += timer.nsecsElapsed();
+    }
+
+    return elapsed / 1.0e6 / iterations;
+}
+
+void report(const char* name, const char* implementation, double milliseconds, double baseline)
+{
+    std::printf("%-20s %-8s %10.3f ms %8.2fx\n", name, implementation, milliseconds, baseline / milliseconds);
+}
+
+void benchmark(const char* name, int iterations, const QImage& tile,
+               const std::function< void(QImage&) >& legacyOperation,
+               const std::function< void(QImage&) >& operation)
+{
+    const double baseline = measure(iterations, tile, legacyOperation);
+
+    report(name, "legacy", baseline, baseline);
+
+    for(int instructionSet = PostProcessing::ScalarInstructions; instructionSet <= PostProcessing::supportedInstructionSet(); ++instructionSet)
+    {
+        PostProcessing::setInstructionSet(static_cast< PostProcessing::InstructionSet >(instructionSet));
+
+        report(name, PostProcessing::instructionSetName(PostProcessing::instructionSet()), measure(iterations, tile, operation), baseline);
+    }
+
+    PostProcessing::setInstructionSet(PostProcessing::supportedInstructionSet());
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+    const int iterations = argc > 1 ? std::max(1, atoi(argv[1])) : 10;
+
+    std::printf("%dx%d tiles, %d iterations, %s supported\n\n", tileWidth, tileHeight, iterations,
+                PostProcessing::instructionSetName(PostProcessing::supportedInstructionSet()));
+
+    const QImage::Format formats[] = {QImage::Format_RGB32, QImage::Format_ARGB32, QImage::Format_ARGB32_Premultiplied};
+    const char* const formatNames[] = {"RGB32", "ARGB32", "ARGB32_Premultiplied"};
+
+    for(int index = 0; index < 3; ++index)
+    {
+        std::printf("%s\n", formatNames[index]);
+
+        const QImage tile = createTile(formats[index]);
+
+        benchmark("convertToGrayscale", iterations, tile,
+                  [](QImage& image) { Legacy::convertToGrayscale(image); },
+                  [](QImage& image) { PostProcessing::convertToGrayscale(image); });
+
+        benchmark("invertPixels", iterations, tile,
+                  [](QImage& image) { image.invertPixels(); },
+                  [](QImage& image) { PostProcessing::invertColors(image); });
+
+        benchmark("darkenWithColor", iterations, tile,
+                  [](QImage& image) { Legacy::composeWithColor(QPainter::CompositionMode_Darken, QColor::fromRgba(darkenColor), image); },
+                  [](QImage& image) { PostProcessing::darkenWithColor(image, darkenColor); });
+
+        benchmark("lightenWithColor", iterations, tile,
+                  [](QImage& image) { Legacy::composeWithColor(QPainter::CompositionMode_Lighten, QColor::fromRgba(darkenColor), image); },
+                  [](QImage& image) { PostProcessing::lightenWithColor(image, darkenColor); });
+
+        benchmark("trimMargins", iterations, tile,
+                  [](QImage& image) { Q_UNUSED(Legacy::trimMargins(paperColor, image)); },
+                  [](QImage& image) { Q_UNUSED(PostProcessing::trimMargins(paperColor, image)); });
+
+        benchmark("all stages", iterations, tile,
+                  [](QImage& image)
+        {
+            Legacy::composeWithColor(QPainter::CompositionMode_Darken, QColor::fromRgba(darkenColor), image);
+            Q_UNUSED(Legacy::trimMargins(darkenColor, image));
+            Legacy::convertToGrayscale(image);
+            image.invertPixels();
+        },
+                  [](QImage& image)
+        {
+            QRectF cropRect;
+            PostProcessing::Pipeline(RenderFlags(DarkenWithPaperColor) | TrimMargins | ConvertToGrayscale | InvertColors, darkenColor).run(image, cropRect, nullptr);
+        });
+
+        std::printf("\n");
+    }
+
+    return 0;
+}
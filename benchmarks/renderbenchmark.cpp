@@ -0,0 +1,495 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include <algorithm>
+#include <cstdio>
+
+#include <QApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QScopedPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+#include <qmath.h>
+
+#if defined(Q_OS_UNIX)
+
+#include <sys/resource.h>
+
+#elif defined(Q_OS_WIN)
+
+#include <windows.h>
+#include <psapi.h>
+
+#endif // Q_OS_UNIX Q_OS_WIN
+
+#include "model.h"
+#include "pluginhandler.h"
+#include "postprocessing.h"
+#include "renderparam.h"
+
+using namespace qpdfview;
+
+namespace
+{
+
+const QRgb paperColor = 0xffffffffu;
+
+struct Configuration
+{
+    qreal scaleFactor;
+    int tileSize; // zero renders whole pages
+    RenderFlags flags;
+    QString flagsName;
+};
+
+struct Tile
+{
+    const Model::Page* page;
+    qreal resolution;
+    QRect rect;
+    RenderFlags flags;
+
+    qint64 nanoseconds;
+    bool failed;
+};
+
+const struct
+{
+    const char* name;
+    RenderFlag flag;
+}
+flagNames[] =
+{
+    {"invertColors", InvertColors},
+    {"convertToGrayscale", ConvertToGrayscale},
+    {"trimMargins", TrimMargins},
+    {"darkenWithPaperColor", DarkenWithPaperColor},
+    {"lightenWithPaperColor", LightenWithPaperColor},
+    {"disableAntialiasing", DisableAntialiasing}
+};
+
+bool parseFlags(const QString& text, RenderFlags& flags)
+{
+    flags = RenderFlags();
+
+    if(text == QLatin1String("none"))
+    {
+        return true;
+    }
+
+    foreach(const QString& name, text.split(QLatin1Char('|'), Qt::SkipEmptyParts))
+    {
+        bool found = false;
+
+        for(const auto& flagName : flagNames)
+        {
+            if(name == QLatin1String(flagName.name))
+            {
+                flags |= flagName.flag;
+                found = true;
+            }
+        }
+
+        if(!found)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Parses a list of one-based page ranges like "1-10,15" into zero-based indices.
+bool parsePages(const QString& text, int numberOfPages, QVector< int >& indices)
+{
+    indices.clear();
+
+    if(text.isEmpty())
+    {
+        for(int index = 0; index < numberOfPages; ++index)
+        {
+            indices.append(index);
+        }
+
+        return true;
+    }
+
+    foreach(const QString& range, text.split(QLatin1Char(','), Qt::SkipEmptyParts))
+    {
+        const QStringList bounds = range.split(QLatin1Char('-'));
+
+        bool firstOk = false;
+        bool lastOk = false;
+
+        const int first = bounds.value(0).toInt(&firstOk);
+        const int last = bounds.count() > 1 ? bounds.value(1).toInt(&lastOk) : first;
+
+        if(!firstOk || (bounds.count() > 1 && !lastOk) || bounds.count() > 2 || first < 1 || last < first)
+        {
+            return false;
+        }
+
+        for(int page = first; page <= qMin(last, numberOfPages); ++page)
+        {
+            indices.append(page - 1);
+        }
+    }
+
+    return true;
+}
+
+template< typename Type, typename Parse >
+bool parseList(const QString& text, QVector< Type >& values, Parse parse)
+{
+    values.clear();
+
+    foreach(const QString& value, text.split(QLatin1Char(','), Qt::SkipEmptyParts))
+    {
+        bool ok = false;
+        values.append(parse(value, &ok));
+
+        if(!ok)
+        {
+            return false;
+        }
+    }
+
+    return !values.isEmpty();
+}
+
+QVector< Tile > createTiles(const QVector< const Model::Page* >& pages, const Configuration& configuration)
+{
+    QVector< Tile > tiles;
+
+    const qreal resolution = 72.0 * configuration.scaleFactor;
+
+    foreach(const Model::Page* page, pages)
+    {
+        const QSizeF size = page->size() * configuration.scaleFactor;
+        const QRect pageRect(0, 0, qCeil(size.width()), qCeil(size.height()));
+
+        if(configuration.tileSize <= 0)
+        {
+            tiles.append(Tile{page, resolution, QRect(), configuration.flags, 0, false});
+            continue;
+        }
+
+        for(int y = 0; y < pageRect.height(); y += configuration.tileSize)
+        {
+            for(int x = 0; x < pageRect.width(); x += configuration.tileSize)
+            {
+                const QRect rect = QRect(x, y, configuration.tileSize, configuration.tileSize).intersected(pageRect);
+
+                tiles.append(Tile{page, resolution, rect, configuration.flags, 0, false});
+            }
+        }
+    }
+
+    return tiles;
+}
+
+void renderTile(Tile& tile)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    QImage image = tile.page->render(tile.resolution, tile.resolution, RotateBy0, tile.rect,
+                                     nullptr, !tile.flags.testFlag(DisableAntialiasing));
+
+    const PostProcessing::Pipeline pipeline(tile.flags, paperColor);
+
+    if(!image.isNull() && !pipeline.isEmpty())
+    {
+        QRectF cropRect;
+        pipeline.run(image, cropRect, nullptr);
+    }
+
+    tile.nanoseconds = timer.nsecsElapsed();
+    tile.failed = image.isNull();
+}
+
+// in milliseconds using the nearest-rank method
+qreal percentile(const QVector< qint64 >& sortedNanoseconds, qreal fraction)
+{
+    if(sortedNanoseconds.isEmpty())
+    {
+        return 0.0;
+    }
+
+    const int rank = qMax(1, qCeil(fraction * sortedNanoseconds.count()));
+
+    return sortedNanoseconds.at(rank - 1) / 1.0e6;
+}
+
+QJsonObject measure(const QVector< const Model::Page* >& pages, const Configuration& configuration, int repetitions)
+{
+    QVector< qint64 > latencies;
+    int failedCount = 0;
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for(int repetition = 0; repetition < repetitions; ++repetition)
+    {
+        QVector< Tile > tiles = createTiles(pages, configuration);
+
+        QtConcurrent::blockingMap(tiles, renderTile);
+
+        foreach(const Tile& tile, tiles)
+        {
+            latencies.append(tile.nanoseconds);
+
+            if(tile.failed)
+            {
+                ++failedCount;
+            }
+        }
+    }
+
+    const qreal seconds = timer.nsecsElapsed() / 1.0e9;
+
+    std::sort(latencies.begin(), latencies.end());
+
+    QJsonObject tileLatency;
+    tileLatency.insert(QLatin1String("p50"), percentile(latencies, 0.50));
+    tileLatency.insert(QLatin1String("p95"), percentile(latencies, 0.95));
+    tileLatency.insert(QLatin1String("p99"), percentile(latencies, 0.99));
+    tileLatency.insert(QLatin1String("max"), latencies.isEmpty() ? 0.0 : latencies.last() / 1.0e6);
+
+    const int pageCount = pages.count() * repetitions;
+
+    QJsonObject run;
+    run.insert(QLatin1String("scaleFactor"), configuration.scaleFactor);
+    run.insert(QLatin1String("tileSize"), configuration.tileSize);
+    run.insert(QLatin1String("flags"), configuration.flagsName);
+    run.insert(QLatin1String("pages"), pageCount);
+    run.insert(QLatin1String("tiles"), latencies.count());
+    run.insert(QLatin1String("failedTiles"), failedCount);
+    run.insert(QLatin1String("seconds"), seconds);
+    run.insert(QLatin1String("pagesPerSecond"), seconds > 0.0 ? pageCount / seconds : 0.0);
+    run.insert(QLatin1String("tileLatency"), tileLatency);
+
+    return run;
+}
+
+// in bytes
+qint64 peakResidentSetSize()
+{
+#if defined(Q_OS_UNIX)
+
+    struct rusage usage;
+
+    if(getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        return -1;
+    }
+
+#if defined(Q_OS_MACOS)
+
+    return usage.ru_maxrss;
+
+#else
+
+    return static_cast< qint64 >(usage.ru_maxrss) * 1024;
+
+#endif // Q_OS_MACOS
+
+#elif defined(Q_OS_WIN)
+
+    PROCESS_MEMORY_COUNTERS counters;
+
+    if(!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return -1;
+    }
+
+    return static_cast< qint64 >(counters.PeakWorkingSetSize);
+
+#else
+
+    return -1;
+
+#endif // Q_OS_UNIX Q_OS_WIN
+}
+
+} // anonymous
+
+int main(int argc, char** argv)
+{
+    // The plug-ins need a GUI application for fonts and images, but no display.
+    if(qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+    {
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    }
+
+    QApplication application(argc, argv);
+
+    QApplication::setApplicationName(QLatin1String("qpdfview-bench"));
+    QApplication::setApplicationVersion(QLatin1String(APPLICATION_VERSION));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QLatin1String("Renders documents without a main window and reports the throughput as JSON."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QLatin1String("files"), QLatin1String("The documents to render."), QLatin1String("files..."));
+
+    const QCommandLineOption pagesOption(QLatin1String("pages"), QLatin1String("One-based page ranges, e.g. 1-10,15 (default: all)."), QLatin1String("ranges"));
+    const QCommandLineOption scaleFactorsOption(QLatin1String("scale-factors"), QLatin1String("Zoom levels (default: 1)."), QLatin1String("factors"), QLatin1String("1"));
+    const QCommandLineOption tileSizesOption(QLatin1String("tile-sizes"), QLatin1String("Tile sizes in pixels, 0 renders whole pages (default: 0)."), QLatin1String("sizes"), QLatin1String("0"));
+    const QCommandLineOption flagsOption(QLatin1String("flags"), QLatin1String("Render flags joined by '|' or 'none', may be given several times (default: none)."), QLatin1String("flags"));
+    const QCommandLineOption threadsOption(QLatin1String("threads"), QLatin1String("Number of render threads (default: ideal thread count)."), QLatin1String("count"));
+    const QCommandLineOption repetitionsOption(QLatin1String("repetitions"), QLatin1String("Number of times each configuration is rendered (default: 1)."), QLatin1String("count"), QLatin1String("1"));
+    const QCommandLineOption outputOption(QLatin1String("output"), QLatin1String("Writes the JSON report to a file instead of the standard output."), QLatin1String("file"));
+
+    parser.addOptions({pagesOption, scaleFactorsOption, tileSizesOption, flagsOption, threadsOption, repetitionsOption, outputOption});
+
+    parser.process(application);
+
+    if(parser.positionalArguments().isEmpty())
+    {
+        parser.showHelp(1);
+    }
+
+    QVector< qreal > scaleFactors;
+    QVector< int > tileSizes;
+
+    if(!parseList(parser.value(scaleFactorsOption), scaleFactors, [](const QString& value, bool* ok) { return value.toDouble(ok); })
+            || !parseList(parser.value(tileSizesOption), tileSizes, [](const QString& value, bool* ok) { return value.toInt(ok); }))
+    {
+        qCritical("Could not parse scale factors or tile sizes.");
+        return 1;
+    }
+
+    QStringList flagsNames = parser.values(flagsOption);
+
+    if(flagsNames.isEmpty())
+    {
+        flagsNames.append(QLatin1String("none"));
+    }
+
+    QVector< Configuration > configurations;
+
+    foreach(const QString& flagsName, flagsNames)
+    {
+        RenderFlags flags;
+
+        if(!parseFlags(flagsName, flags))
+        {
+            qCritical("Could not parse render flags '%s'.", qPrintable(flagsName));
+            return 1;
+        }
+
+        foreach(qreal scaleFactor, scaleFactors)
+        {
+            foreach(int tileSize, tileSizes)
+            {
+                configurations.append(Configuration{scaleFactor, tileSize, flags, flagsName});
+            }
+        }
+    }
+
+    const int threadCount = parser.isSet(threadsOption) ? qMax(1, parser.value(threadsOption).toInt()) : QThread::idealThreadCount();
+    const int repetitions = qMax(1, parser.value(repetitionsOption).toInt());
+
+    QThreadPool::globalInstance()->setMaxThreadCount(threadCount);
+
+    QJsonArray documents;
+
+    foreach(const QString& filePath, parser.positionalArguments())
+    {
+        QScopedPointer< Model::Document > document(PluginHandler::instance()->loadDocument(filePath));
+
+        if(document.isNull())
+        {
+            qCritical("Could not load document '%s'.", qPrintable(filePath));
+            return 1;
+        }
+
+        document->setPaperColor(QColor::fromRgba(paperColor));
+
+        QVector< int > indices;
+
+        if(!parsePages(parser.value(pagesOption), document->numberOfPages(), indices))
+        {
+            qCritical("Could not parse page ranges '%s'.", qPrintable(parser.value(pagesOption)));
+            return 1;
+        }
+
+        QVector< const Model::Page* > pages;
+
+        foreach(int index, indices)
+        {
+            if(Model::Page* page = document->page(index))
+            {
+                pages.append(page);
+            }
+        }
+
+        QJsonArray runs;
+
+        foreach(const Configuration& configuration, configurations)
+        {
+            runs.append(measure(pages, configuration, repetitions));
+        }
+
+        QJsonObject entry;
+        entry.insert(QLatin1String("file"), QFileInfo(filePath).fileName());
+        entry.insert(QLatin1String("backend"), pages.isEmpty() ? QString() : pages.first()->backendName());
+        entry.insert(QLatin1String("numberOfPages"), document->numberOfPages());
+        entry.insert(QLatin1String("runs"), runs);
+
+        documents.append(entry);
+
+        qDeleteAll(pages);
+    }
+
+    QJsonObject report;
+    report.insert(QLatin1String("version"), QLatin1String(APPLICATION_VERSION));
+    report.insert(QLatin1String("threads"), threadCount);
+    report.insert(QLatin1String("repetitions"), repetitions);
+    report.insert(QLatin1String("documents"), documents);
+    report.insert(QLatin1String("peakResidentSetSize"), peakResidentSetSize());
+
+    const QByteArray json = QJsonDocument(report).toJson();
+
+    if(parser.isSet(outputOption))
+    {
+        QFile file(parser.value(outputOption));
+
+        if(!file.open(QIODevice::WriteOnly | QIODevice::Truncate) || file.write(json) != json.size())
+        {
+            qCritical("Could not write report to '%s'.", qPrintable(file.fileName()));
+            return 1;
+        }
+    }
+    else
+    {
+        std::fwrite(json.constData(), 1, json.size(), stdout);
+    }
+
+    return 0;
+}
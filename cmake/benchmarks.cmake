@@ -0,0 +1,45 @@
+set(BENCHMARK_SOURCE_DIR ${CMAKE_CURRENT_SOURCE_DIR}/benchmarks)
+
+set(POSTPROCESSING_BENCHMARK_TARGET qpdfview-postprocessing-bench)
+
+set(POSTPROCESSING_BENCHMARK_SOURCES
+    ${QPDFVIEW_SOURCE_DIR}/postprocessing.cpp
+    ${BENCHMARK_SOURCE_DIR}/postprocessingbenchmark.cpp)
+
+find_package(Qt${QT_MAJOR} ${QT_EXACT_VERSION} COMPONENTS Core Gui REQUIRED)
+
+add_executable(${POSTPROCESSING_BENCHMARK_TARGET} ${POSTPROCESSING_BENCHMARK_SOURCES})
+target_include_directories(${POSTPROCESSING_BENCHMARK_TARGET} PUBLIC ${QPDFVIEW_SOURCE_DIR})
+target_link_libraries(${POSTPROCESSING_BENCHMARK_TARGET} PUBLIC Qt${QT_MAJOR}::Core Qt${QT_MAJOR}::Gui)
+set_target_properties(${POSTPROCESSING_BENCHMARK_TARGET}
+                      PROPERTIES
+                      AUTOGEN_BUILD_DIR ${CMAKE_BINARY_DIR}/moc-benchmarks)
+
+set(RENDER_BENCHMARK_TARGET qpdfview-bench)
+
+set(RENDER_BENCHMARK_SOURCES
+    ${QPDFVIEW_SOURCE_DIR}/global.h
+    ${QPDFVIEW_SOURCE_DIR}/model.h
+    ${QPDFVIEW_SOURCE_DIR}/pluginhandler.cpp
+    ${QPDFVIEW_SOURCE_DIR}/postprocessing.cpp
+    ${BENCHMARK_SOURCE_DIR}/renderbenchmark.cpp)
+
+find_package(Qt${QT_MAJOR} ${QT_EXACT_VERSION} COMPONENTS Concurrent Widgets REQUIRED)
+
+add_executable(${RENDER_BENCHMARK_TARGET} ${RENDER_BENCHMARK_SOURCES})
+target_compile_definitions(${RENDER_BENCHMARK_TARGET} PUBLIC ${QPDFVIEW_DEFINITIONS})
+target_include_directories(${RENDER_BENCHMARK_TARGET} PUBLIC ${QPDFVIEW_SOURCE_DIR})
+target_link_libraries(${RENDER_BENCHMARK_TARGET} PUBLIC
+                      Qt${QT_MAJOR}::Core
+                      Qt${QT_MAJOR}::Gui
+                      Qt${QT_MAJOR}::Concurrent
+                      Qt${QT_MAJOR}::Widgets)
+set_target_properties(${RENDER_BENCHMARK_TARGET}
+                      PROPERTIES
+                      INSTALL_RPATH ${PLUGIN_INSTALL_PATH}
+                      AUTOGEN_BUILD_DIR ${CMAKE_BINARY_DIR}/moc-render-benchmark)
+
+# The plug-ins are looked up next to the executable and in the install path.
+foreach(dependency ${QPDFVIEW_DEPENDENCIES})
+    add_dependencies(${RENDER_BENCHMARK_TARGET} ${dependency})
+endforeach()
@@ -74,6 +74,9 @@ if(NOT ${WITHOUT_PKGCONFIG})
         if(${POPPLER_VERSION} VERSION_GREATER_EQUAL 0.35)
             list(APPEND PDF_PLUGIN_DEFINITIONS -DHAS_POPPLER_35)
         endif()
+        if(${POPPLER_VERSION} VERSION_GREATER_EQUAL 0.63)
+            list(APPEND PDF_PLUGIN_DEFINITIONS -DHAS_POPPLER_63)
+        endif()
     else()
         set(REQUIRED_FOUND FALSE)
     endif()
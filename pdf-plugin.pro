@@ -29,6 +29,7 @@ greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
     system(pkg-config --atleast-version=0.26 $${poppler_qt_pkg}):DEFINES += HAS_POPPLER_26
     system(pkg-config --atleast-version=0.31 $${poppler_qt_pkg}):DEFINES += HAS_POPPLER_31
     system(pkg-config --atleast-version=0.35 $${poppler_qt_pkg}):DEFINES += HAS_POPPLER_35
+    system(pkg-config --atleast-version=0.63 $${poppler_qt_pkg}):DEFINES += HAS_POPPLER_63
 
     CONFIG += link_pkgconfig
     PKGCONFIG += $${poppler_qt_pkg}
@@ -0,0 +1,418 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "disktilecache.h"
+
+#include <cstring>
+
+#include <QApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrentRun>
+
+namespace qpdfview
+{
+
+namespace
+{
+
+const quint32 magic = 0x54565051; // "QPVT"
+const quint32 version = 2;
+
+const char* const suffix = ".tile";
+
+// The file names consist of the hash in hexadecimal digits and the suffix.
+const int hashDigits = 16;
+
+// The pixels follow the header directly and are used in place when the file is mapped.
+// The serialized key follows the pixels.
+struct Header
+{
+    quint32 magic;
+    quint32 version;
+
+    qint32 width;
+    qint32 height;
+    qint32 bytesPerLine;
+    qint32 format;
+
+    double devicePixelRatio;
+    double cropRect[4];
+
+    qint32 keySize;
+    qint32 reserved[3];
+};
+
+static_assert(sizeof(Header) == 80, "The header must keep the pixels aligned.");
+
+inline quint64 mixHash(quint64 value)
+{
+    value = (value ^ (value >> 30)) * Q_UINT64_C(0xbf58476d1ce4e5b9);
+    value = (value ^ (value >> 27)) * Q_UINT64_C(0x94d049bb133111eb);
+
+    return value ^ (value >> 31);
+}
+
+inline quint64 combineHash(quint64 hash, quint64 value)
+{
+    return mixHash(hash ^ (value + Q_UINT64_C(0x9e3779b97f4a7c15) + (hash << 6) + (hash >> 2)));
+}
+
+inline quint64 combineHash(quint64 hash, double value)
+{
+    quint64 bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+
+    return combineHash(hash, bits);
+}
+
+quint64 hashBytes(const QByteArray& bytes)
+{
+    // FNV-1a
+    quint64 hash = Q_UINT64_C(0xcbf29ce484222325);
+
+    for(const char byte : bytes)
+    {
+        hash = (hash ^ static_cast< uchar >(byte)) * Q_UINT64_C(0x100000001b3);
+    }
+
+    return hash;
+}
+
+inline QString fileName(quint64 hash)
+{
+    return QString::number(hash, 16).rightJustified(hashDigits, QLatin1Char('0')) + QLatin1String(suffix);
+}
+
+bool parseFileName(const QString& fileName, quint64& hash)
+{
+    if(fileName.length() != hashDigits + static_cast< int >(std::strlen(suffix)))
+    {
+        return false;
+    }
+
+    bool ok = false;
+    hash = fileName.leftRef(hashDigits).toULongLong(&ok, 16);
+
+    return ok;
+}
+
+void unmapFile(void* info)
+{
+    delete static_cast< QFile* >(info);
+}
+
+} // anonymous
+
+DiskTileCacheKey::DiskTileCacheKey(const QByteArray& documentId, int index, const RenderParam& renderParam, const QRect& rect, const QColor& paperColor) :
+    m_documentId(documentId),
+    m_index(index),
+    m_renderParam(renderParam),
+    m_rect(rect),
+    m_paperColor(paperColor),
+    m_hash(hashBytes(documentId))
+{
+    m_hash = combineHash(m_hash, static_cast< quint64 >(m_index));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(renderParam.resolutionX()));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(renderParam.resolutionY()));
+    m_hash = combineHash(m_hash, static_cast< double >(renderParam.devicePixelRatio()));
+    m_hash = combineHash(m_hash, static_cast< double >(renderParam.scaleFactor()));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(renderParam.rotation()));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(static_cast< int >(renderParam.flags())));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(quint32(rect.x())) << 32 | quint32(rect.y()));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(quint32(rect.width())) << 32 | quint32(rect.height()));
+    m_hash = combineHash(m_hash, static_cast< quint64 >(paperColor.rgba()));
+}
+
+QByteArray DiskTileCacheKey::serialize() const
+{
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+
+    stream << m_documentId << m_index << m_renderParam << m_rect << m_paperColor;
+
+    return key;
+}
+
+DiskTileCache* DiskTileCache::s_instance = nullptr;
+
+DiskTileCache* DiskTileCache::instance()
+{
+    if(s_instance == nullptr)
+    {
+        s_instance = new DiskTileCache(qApp);
+    }
+
+    return s_instance;
+}
+
+DiskTileCache::~DiskTileCache()
+{
+    m_writerPool.waitForDone();
+
+    s_instance = nullptr;
+}
+
+void DiskTileCache::setMaxSize(int maxSize)
+{
+    m_maxSize.storeRelaxed(maxSize);
+}
+
+bool DiskTileCache::contains(const Key& key) const
+{
+    return m_maxSize.loadRelaxed() > 0 && containsHash(key.hash());
+}
+
+bool DiskTileCache::load(const Key& key, QImage& image, QRectF& cropRect) const
+{
+    if(m_maxSize.loadRelaxed() <= 0 || !containsHash(key.hash()))
+    {
+        return false;
+    }
+
+    QScopedPointer< QFile > file(new QFile(filePath(key.hash())));
+
+    if(!file->open(QIODevice::ReadOnly) || file->size() < static_cast< qint64 >(sizeof(Header)))
+    {
+        // An entry which cannot be used is forgotten, so that it is written again.
+        removeHash(key.hash());
+
+        return false;
+    }
+
+    const uchar* data = file->map(0, file->size());
+
+    if(data == nullptr)
+    {
+        removeHash(key.hash());
+
+        return false;
+    }
+
+    Header header;
+    std::memcpy(&header, data, sizeof(Header));
+
+    if(header.magic != magic || header.version != version
+            || header.width <= 0 || header.height <= 0
+            || header.format <= QImage::Format_Invalid || header.format >= QImage::NImageFormats
+            || header.bytesPerLine < header.width * QImage::toPixelFormat(static_cast< QImage::Format >(header.format)).bitsPerPixel() / 8
+            || header.keySize < 0
+            || file->size() != static_cast< qint64 >(sizeof(Header)) + static_cast< qint64 >(header.bytesPerLine) * header.height + header.keySize)
+    {
+        removeHash(key.hash());
+
+        return false;
+    }
+
+    const qint64 pixelsSize = static_cast< qint64 >(header.bytesPerLine) * header.height;
+
+    // Another key with the same hash does not replace the entry, which is rendered again instead.
+    if(QByteArray::fromRawData(reinterpret_cast< const char* >(data + sizeof(Header) + pixelsSize), header.keySize) != key.serialize())
+    {
+        return false;
+    }
+
+    // Mark the entry as recently used for pruning.
+    file->setFileTime(QDateTime::currentDateTime(), QFileDevice::FileModificationTime);
+
+    QFile* mappedFile = file.take();
+
+    image = QImage(data + sizeof(Header), header.width, header.height, header.bytesPerLine,
+                   static_cast< QImage::Format >(header.format), unmapFile, mappedFile);
+    image.setDevicePixelRatio(header.devicePixelRatio);
+
+    cropRect = QRectF(header.cropRect[0], header.cropRect[1], header.cropRect[2], header.cropRect[3]);
+
+    return true;
+}
+
+void DiskTileCache::store(const Key& key, const QImage& image, const QRectF& cropRect)
+{
+    if(m_maxSize.loadRelaxed() <= 0 || image.isNull() || image.colorCount() != 0 || contains(key))
+    {
+        return;
+    }
+
+    const quint64 hash = key.hash();
+    const QByteArray serializedKey = key.serialize();
+
+    QtConcurrent::run(&m_writerPool, [this, hash, serializedKey, image, cropRect]()
+    {
+        write(hash, serializedKey, image, cropRect);
+    });
+}
+
+DiskTileCache::DiskTileCache(QObject* parent) : QObject(parent),
+    m_directory(),
+    m_hashesMutex(),
+    m_hashes(),
+    m_maxSize(0),
+    m_size(0),
+    m_writerPool()
+{
+    const QString path = QDir(QStandardPaths::writableLocation(QStandardPaths::CacheLocation)).filePath(QLatin1String("tiles"));
+
+    QDir().mkpath(path);
+
+    m_directory = QDir(path);
+
+    // Writes are serialized by the pool which also measures the cache before anything is written.
+    m_writerPool.setMaxThreadCount(1);
+
+    QtConcurrent::run(&m_writerPool, [this]() { measure(); });
+}
+
+QString DiskTileCache::filePath(quint64 hash) const
+{
+    return m_directory.filePath(fileName(hash));
+}
+
+bool DiskTileCache::containsHash(quint64 hash) const
+{
+    QMutexLocker mutexLocker(&m_hashesMutex);
+
+    return m_hashes.contains(hash);
+}
+
+void DiskTileCache::insertHash(quint64 hash) const
+{
+    QMutexLocker mutexLocker(&m_hashesMutex);
+
+    m_hashes.insert(hash);
+}
+
+void DiskTileCache::removeHash(quint64 hash) const
+{
+    QMutexLocker mutexLocker(&m_hashesMutex);
+
+    m_hashes.remove(hash);
+}
+
+void DiskTileCache::measure()
+{
+    m_size = 0;
+
+    QSet< quint64 > hashes;
+
+    foreach(const QFileInfo& fileInfo, m_directory.entryInfoList(QStringList() << QLatin1String("*") + QLatin1String(suffix), QDir::Files))
+    {
+        quint64 hash = 0;
+
+        // Entries named by earlier versions cannot be found anymore.
+        if(!parseFileName(fileInfo.fileName(), hash))
+        {
+            QFile::remove(fileInfo.absoluteFilePath());
+
+            continue;
+        }
+
+        m_size += fileInfo.size();
+
+        hashes.insert(hash);
+    }
+
+    QMutexLocker mutexLocker(&m_hashesMutex);
+
+    m_hashes.unite(hashes);
+}
+
+void DiskTileCache::write(quint64 hash, const QByteArray& key, const QImage& image, const QRectF& cropRect)
+{
+    const QString filePath = this->filePath(hash);
+
+    if(QFileInfo::exists(filePath))
+    {
+        return;
+    }
+
+    const Header header =
+    {
+        magic, version,
+        image.width(), image.height(), static_cast< qint32 >(image.bytesPerLine()), static_cast< qint32 >(image.format()),
+        image.devicePixelRatio(),
+        {cropRect.x(), cropRect.y(), cropRect.width(), cropRect.height()},
+        static_cast< qint32 >(key.size()), {0, 0, 0}
+    };
+
+    // The entry is written to a temporary file first so that it is never mapped while incomplete.
+    QSaveFile file(filePath);
+
+    if(!file.open(QIODevice::WriteOnly))
+    {
+        return;
+    }
+
+    file.write(reinterpret_cast< const char* >(&header), sizeof(Header));
+    file.write(reinterpret_cast< const char* >(image.constBits()), image.sizeInBytes());
+    file.write(key);
+
+    if(!file.commit())
+    {
+        return;
+    }
+
+    insertHash(hash);
+
+    m_size += static_cast< qint64 >(sizeof(Header)) + image.sizeInBytes() + key.size();
+
+    if(m_size > 1024 * static_cast< qint64 >(m_maxSize.loadRelaxed()))
+    {
+        prune();
+    }
+}
+
+void DiskTileCache::prune()
+{
+    // Pruning down to three quarters of the budget avoids doing so after every write.
+    const qint64 targetSize = 1024 * static_cast< qint64 >(m_maxSize.loadRelaxed()) * 3 / 4;
+
+    QFileInfoList fileInfos = m_directory.entryInfoList(QStringList() << QLatin1String("*") + QLatin1String(suffix), QDir::Files, QDir::Time | QDir::Reversed);
+
+    m_size = 0;
+
+    foreach(const QFileInfo& fileInfo, fileInfos)
+    {
+        m_size += fileInfo.size();
+    }
+
+    // The oldest entries come first.
+    for(auto fileInfo = fileInfos.constBegin(); fileInfo != fileInfos.constEnd() && m_size > targetSize; ++fileInfo)
+    {
+        // Removing a mapped file might fail on some platforms in which case it is tried again later.
+        if(QFile::remove(fileInfo->absoluteFilePath()))
+        {
+            m_size -= fileInfo->size();
+
+            quint64 hash = 0;
+
+            if(parseFileName(fileInfo->fileName(), hash))
+            {
+                removeHash(hash);
+            }
+        }
+    }
+}
+
+} // qpdfview
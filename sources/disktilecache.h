@@ -0,0 +1,125 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DISKTILECACHE_H
+#define DISKTILECACHE_H
+
+#include <QAtomicInt>
+#include <QColor>
+#include <QDir>
+#include <QImage>
+#include <QMutex>
+#include <QObject>
+#include <QRectF>
+#include <QSet>
+#include <QThreadPool>
+
+#include "global.h"
+#include "renderparam.h"
+
+namespace qpdfview
+{
+
+// Identifies an entry on disk by the persistent identity of its document, its page index, render parameters,
+// rectangle and paper color. Its 64-bit hash names the entry and is computed without allocating,
+// so that looking up entries is cheap. The key is only serialized when an entry is loaded or written.
+class DiskTileCacheKey
+{
+public:
+    DiskTileCacheKey(const QByteArray& documentId, int index, const RenderParam& renderParam, const QRect& rect, const QColor& paperColor);
+
+    DECL_NODISCARD
+    quint64 hash() const { return m_hash; }
+
+    // stored with the entry to tell apart keys with the same hash
+    DECL_NODISCARD
+    QByteArray serialize() const;
+
+private:
+    QByteArray m_documentId;
+    int m_index;
+    RenderParam m_renderParam;
+    QRect m_rect;
+    QColor m_paperColor;
+
+    quint64 m_hash;
+
+};
+
+// Keeps thumbnails and low-resolution previews on disk so that reopening a document does not render them again.
+// Entries are written in the background and memory-mapped when loaded. The least recently used entries are
+// pruned when the cache exceeds its size.
+class DiskTileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef DiskTileCacheKey Key;
+
+    static DiskTileCache* instance();
+    ~DiskTileCache() override;
+
+    // in kilobytes, zero disables the cache
+    void setMaxSize(int maxSize);
+
+    // This does not touch the disk, but only reports the entries found when measuring the cache or written since.
+    DECL_NODISCARD
+    bool contains(const Key& key) const;
+
+    // The image refers to the mapped file until it is detached, e.g. by converting it into a pixmap.
+    bool load(const Key& key, QImage& image, QRectF& cropRect) const;
+    void store(const Key& key, const QImage& image, const QRectF& cropRect);
+
+private:
+    Q_DISABLE_COPY(DiskTileCache)
+
+    static DiskTileCache* s_instance;
+    explicit DiskTileCache(QObject* parent = nullptr);
+
+    QDir m_directory;
+
+    QString filePath(quint64 hash) const;
+
+    // the hashes of the entries known to be on disk, so that looking them up does not hit the file system
+    mutable QMutex m_hashesMutex;
+    mutable QSet< quint64 > m_hashes;
+
+    bool containsHash(quint64 hash) const;
+    void insertHash(quint64 hash) const;
+    void removeHash(quint64 hash) const;
+
+    // accessed by the writer thread, in kilobytes
+    QAtomicInt m_maxSize;
+
+    // only accessed by the writer thread, in bytes
+    qint64 m_size;
+
+    QThreadPool m_writerPool;
+
+    void measure();
+    void write(quint64 hash, const QByteArray& key, const QImage& image, const QRectF& cropRect);
+    void prune();
+
+};
+
+} // qpdfview
+
+#endif // DISKTILECACHE_H
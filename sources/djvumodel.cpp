@@ -26,9 +26,16 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "djvumodel.h"
 
+#include <climits>
 #include <cstdio>
 
 #include <QFile>
+#include <QFormLayout>
+#include <QSet>
+#include <QSettings>
+#include <QSpinBox>
+#include <QThread>
+#include <QWaitCondition>
 #include <qmath.h>
 
 #if defined(Q_OS_WIN) && defined(DJVU_STATIC)
@@ -497,6 +504,14 @@ Properties loadProperties(miniexp_t annoExp)
     return properties;
 }
 
+namespace Defaults
+{
+
+// in megabytes per document
+const int pageCacheSize = 64;
+
+} // Defaults
+
 } // anonymous
 
 namespace qpdfview
@@ -505,6 +520,337 @@ namespace qpdfview
 namespace Model
 {
 
+// Lets threads wait for the messages of a document without consuming them themselves.
+class DjVuMessageWaiter
+{
+public:
+    DjVuMessageWaiter() :
+        m_mutex(),
+        m_messagesReceived(),
+        m_generation(0)
+    {
+    }
+
+    // This has to be read before checking whether a job is done, so that no message is missed in between.
+    quint64 generation()
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        return m_generation;
+    }
+
+    void wait(quint64 generation, unsigned long timeout = ULONG_MAX)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        while(m_generation == generation)
+        {
+            if(!m_messagesReceived.wait(&m_mutex, timeout))
+            {
+                break;
+            }
+        }
+    }
+
+    void notify()
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        ++m_generation;
+
+        m_messagesReceived.wakeAll();
+    }
+
+private:
+    Q_DISABLE_COPY(DjVuMessageWaiter)
+
+    QMutex m_mutex;
+    QWaitCondition m_messagesReceived;
+
+    quint64 m_generation;
+
+};
+
+// Pops the messages of all open documents on a dedicated thread which is woken by DjVuLibre
+// whenever a message is posted, and wakes the threads waiting for the respective document.
+//
+// DjVuLibre calls back while holding the lock of the context, so the lock of the pump
+// is never held while calling into DjVuLibre.
+class DjVuMessagePump : public QThread
+{
+public:
+    DjVuMessagePump() : QThread(),
+        m_mutex(),
+        m_messagesPosted(),
+        m_contextDrained(),
+        m_quit(false),
+        m_waiters(),
+        m_pendingContexts(),
+        m_drainingContexts()
+    {
+        setObjectName(QStringLiteral("DjVuMessagePump"));
+    }
+
+    ~DjVuMessagePump() override
+    {
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            m_quit = true;
+        }
+
+        m_messagesPosted.wakeAll();
+
+        wait();
+    }
+
+    QSharedPointer< DjVuMessageWaiter > add(ddjvu_context_t* context)
+    {
+        const QSharedPointer< DjVuMessageWaiter > waiter(new DjVuMessageWaiter);
+
+        ddjvu_message_set_callback(context, &DjVuMessagePump::callback, this);
+
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            m_waiters.insert(context, waiter);
+
+            // Messages might have been posted before the callback was installed.
+            m_pendingContexts.insert(context);
+        }
+
+        m_messagesPosted.wakeAll();
+
+        return waiter;
+    }
+
+    void remove(ddjvu_context_t* context)
+    {
+        // This waits for a callback which is currently running.
+        ddjvu_message_set_callback(context, nullptr, nullptr);
+
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_waiters.remove(context);
+        m_pendingContexts.remove(context);
+
+        while(m_drainingContexts.contains(context))
+        {
+            m_contextDrained.wait(&m_mutex);
+        }
+    }
+
+protected:
+    void run() override
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        while(!m_quit)
+        {
+            if(m_pendingContexts.isEmpty())
+            {
+                m_messagesPosted.wait(&m_mutex);
+
+                continue;
+            }
+
+            QVector< QPair< ddjvu_context_t*, QSharedPointer< DjVuMessageWaiter > > > contexts;
+
+            foreach(ddjvu_context_t* context, m_pendingContexts)
+            {
+                const QSharedPointer< DjVuMessageWaiter > waiter = m_waiters.value(context);
+
+                if(!waiter.isNull())
+                {
+                    contexts.append(qMakePair(context, waiter));
+
+                    m_drainingContexts.insert(context);
+                }
+            }
+
+            m_pendingContexts.clear();
+
+            mutexLocker.unlock();
+
+            for(int index = 0; index < contexts.count(); ++index)
+            {
+                clearMessageQueue(contexts.at(index).first, false);
+
+                contexts.at(index).second->notify();
+            }
+
+            mutexLocker.relock();
+
+            for(int index = 0; index < contexts.count(); ++index)
+            {
+                m_drainingContexts.remove(contexts.at(index).first);
+            }
+
+            m_contextDrained.wakeAll();
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(DjVuMessagePump)
+
+    static void callback(ddjvu_context_t* context, void* closure)
+    {
+        auto pump = static_cast< DjVuMessagePump* >(closure);
+
+        {
+            QMutexLocker mutexLocker(&pump->m_mutex);
+
+            pump->m_pendingContexts.insert(context);
+        }
+
+        pump->m_messagesPosted.wakeAll();
+    }
+
+    QMutex m_mutex;
+    QWaitCondition m_messagesPosted;
+    QWaitCondition m_contextDrained;
+
+    bool m_quit;
+
+    QHash< ddjvu_context_t*, QSharedPointer< DjVuMessageWaiter > > m_waiters;
+
+    QSet< ddjvu_context_t* > m_pendingContexts;
+    QSet< ddjvu_context_t* > m_drainingContexts;
+
+};
+
+// Keeps recently decoded pages of a document, so that the tiles of a page as well as prefetching
+// and thumbnails share a single decoding instead of decoding the page once per render.
+//
+// A decoded page is accounted with about one byte per pixel at its native resolution, which is
+// roughly what DjVuLibre keeps of a scanned page. Pages which are in use are never evicted,
+// so the cache can exceed its maximum cost as long as there are more concurrent renders than fit.
+//
+// This is not synchronized by itself and has to be used while holding the lock of the document.
+class DjVuPageCache
+{
+public:
+    DjVuPageCache(ddjvu_document_t* document, qint64 maximumCost) :
+        m_document(document),
+        m_entries(),
+        m_totalCost(0),
+        m_maximumCost(maximumCost),
+        m_lastUse(0)
+    {
+    }
+
+    ~DjVuPageCache()
+    {
+        foreach(const Entry& entry, m_entries)
+        {
+            ddjvu_page_release(entry.page);
+        }
+    }
+
+    // Returns the page which might still be decoding. It has to be released again.
+    ddjvu_page_t* acquire(int index, qint64 cost)
+    {
+        const auto entry = m_entries.find(index);
+
+        if(entry != m_entries.end())
+        {
+            ++entry->useCount;
+            entry->lastUse = ++m_lastUse;
+
+            return entry->page;
+        }
+
+        ddjvu_page_t* page = ddjvu_page_create_by_pageno(m_document, index);
+
+        if(page == nullptr)
+        {
+            return nullptr;
+        }
+
+        m_entries.insert(index, Entry{page, cost, ++m_lastUse, 1});
+        m_totalCost += cost;
+
+        return page;
+    }
+
+    void release(int index)
+    {
+        const auto entry = m_entries.find(index);
+
+        if(entry == m_entries.end() || --entry->useCount > 0)
+        {
+            return;
+        }
+
+        // A page which failed to decode is not kept and one which was abandoned by all renders
+        // is stopped, so that it does not keep the decoder busy.
+        const ddjvu_status_t status = ddjvu_page_decoding_status(entry->page);
+
+        if(status != DDJVU_JOB_OK)
+        {
+            if(status < DDJVU_JOB_OK)
+            {
+                ddjvu_job_stop(ddjvu_page_job(entry->page));
+            }
+
+            remove(entry);
+        }
+
+        trim();
+    }
+
+private:
+    Q_DISABLE_COPY(DjVuPageCache)
+
+    struct Entry
+    {
+        ddjvu_page_t* page;
+        qint64 cost;
+        quint64 lastUse;
+        int useCount;
+    };
+
+    ddjvu_document_t* m_document;
+
+    QHash< int, Entry > m_entries;
+
+    qint64 m_totalCost;
+    qint64 m_maximumCost;
+    quint64 m_lastUse;
+
+    void remove(QHash< int, Entry >::iterator entry)
+    {
+        ddjvu_page_release(entry->page);
+
+        m_totalCost -= entry->cost;
+        m_entries.erase(entry);
+    }
+
+    void trim()
+    {
+        while(m_totalCost > m_maximumCost)
+        {
+            auto leastRecentlyUsed = m_entries.end();
+
+            for(auto entry = m_entries.begin(); entry != m_entries.end(); ++entry)
+            {
+                if(entry->useCount == 0 && (leastRecentlyUsed == m_entries.end() || entry->lastUse < leastRecentlyUsed->lastUse))
+                {
+                    leastRecentlyUsed = entry;
+                }
+            }
+
+            if(leastRecentlyUsed == m_entries.end())
+            {
+                break;
+            }
+
+            remove(leastRecentlyUsed);
+        }
+    }
+
+};
+
 DjVuPage::DjVuPage(const DjVuDocument* parent, int index, const ddjvu_pageinfo_t& pageinfo) :
     m_parent(parent),
     m_index(index),
@@ -518,11 +864,17 @@ QSizeF DjVuPage::size() const
     return 72.0 / m_resolution * m_size;
 }
 
-QImage DjVuPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const
+QImage DjVuPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const
 {
-    LOCK_PAGE
+    Q_UNUSED(antialiasing)
 
-    ddjvu_page_t* page = ddjvu_page_create_by_pageno(m_parent->m_document, m_index);
+    ddjvu_page_t* page = nullptr;
+
+    {
+        LOCK_PAGE
+
+        page = m_parent->m_pageCache->acquire(m_index, qRound64(m_size.width() * m_size.height()));
+    }
 
     if(page == nullptr)
     {
@@ -533,21 +885,37 @@ QImage DjVuPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
 
     while(true)
     {
-        status = ddjvu_page_decoding_status(page);
+        const quint64 generation = m_parent->m_messageWaiter->generation();
 
-        if(status < DDJVU_JOB_OK)
         {
-            clearMessageQueue(m_parent->m_context, true);
+            LOCK_PAGE
+
+            status = ddjvu_page_decoding_status(page);
         }
-        else
+
+        // The decoding might be shared with other renders, so it is only stopped
+        // by the cache when the last of them gives up on the page.
+        if(status >= DDJVU_JOB_OK || (cancellation != nullptr && cancellation->isCanceled()))
         {
             break;
         }
+
+        // Waking up now and then lets a canceled render return even if no further message is posted.
+        m_parent->m_messageWaiter->wait(generation, cancellation != nullptr ? 100 : ULONG_MAX);
     }
 
-    if(status >= DDJVU_JOB_FAILED)
+    LOCK_PAGE
+
+    if(status != DDJVU_JOB_OK)
+    {
+        m_parent->m_pageCache->release(m_index);
+
+        return {};
+    }
+
+    if(cancellation != nullptr && cancellation->isCanceled())
     {
-        ddjvu_page_release(page);
+        m_parent->m_pageCache->release(m_index);
 
         return {};
     }
@@ -613,9 +981,7 @@ QImage DjVuPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
         image = QImage();
     }
 
-    clearMessageQueue(m_parent->m_context, false);
-
-    ddjvu_page_release(page);
+    m_parent->m_pageCache->release(m_index);
 
     return image;
 }
@@ -627,31 +993,31 @@ QString DjVuPage::label() const
 
 QList< Link* > DjVuPage::links() const
 {
-    LOCK_PAGE
-
     miniexp_t pageAnnoExp = miniexp_nil;
 
+    while(true)
     {
-        LOCK_PAGE_GLOBAL
+        const quint64 generation = m_parent->m_messageWaiter->generation();
 
-        while(true)
         {
+            LOCK_PAGE
+            LOCK_PAGE_GLOBAL
+
             pageAnnoExp = ddjvu_document_get_pageanno(m_parent->m_document, m_index);
+        }
 
-            if(pageAnnoExp == miniexp_dummy)
-            {
-                clearMessageQueue(m_parent->m_context, true);
-            }
-            else
-            {
-                break;
-            }
+        if(pageAnnoExp != miniexp_dummy)
+        {
+            break;
         }
+
+        m_parent->m_messageWaiter->wait(generation);
     }
 
     const QList< Link* > links = loadLinks(pageAnnoExp, m_size, m_index, m_parent->m_pageByName);
 
     {
+        LOCK_PAGE
         LOCK_PAGE_GLOBAL
 
         ddjvu_miniexp_release(m_parent->m_document, pageAnnoExp);
@@ -662,26 +1028,25 @@ QList< Link* > DjVuPage::links() const
 
 QString DjVuPage::text(const QRectF& rect) const
 {
-    LOCK_PAGE
-
     miniexp_t pageTextExp = miniexp_nil;
 
+    while(true)
     {
-        LOCK_PAGE_GLOBAL
+        const quint64 generation = m_parent->m_messageWaiter->generation();
 
-        while(true)
         {
+            LOCK_PAGE
+            LOCK_PAGE_GLOBAL
+
             pageTextExp = ddjvu_document_get_pagetext(m_parent->m_document, m_index, "word");
+        }
 
-            if(pageTextExp == miniexp_dummy)
-            {
-                clearMessageQueue(m_parent->m_context, true);
-            }
-            else
-            {
-                break;
-            }
+        if(pageTextExp != miniexp_dummy)
+        {
+            break;
         }
+
+        m_parent->m_messageWaiter->wait(generation);
     }
 
     const QTransform transform = QTransform::fromScale(m_resolution / 72.0, m_resolution / 72.0);
@@ -689,6 +1054,7 @@ QString DjVuPage::text(const QRectF& rect) const
     const QString text = loadText(pageTextExp, m_size, transform.mapRect(rect)).simplified();
 
     {
+        LOCK_PAGE
         LOCK_PAGE_GLOBAL
 
         ddjvu_miniexp_release(m_parent->m_document, pageTextExp);
@@ -699,26 +1065,25 @@ QString DjVuPage::text(const QRectF& rect) const
 
 QList< QRectF > DjVuPage::search(const QString& text, bool matchCase, bool wholeWords) const
 {
-    LOCK_PAGE
-
     miniexp_t pageTextExp = miniexp_nil;
 
+    while(true)
     {
-        LOCK_PAGE_GLOBAL
+        const quint64 generation = m_parent->m_messageWaiter->generation();
 
-        while(true)
         {
+            LOCK_PAGE
+            LOCK_PAGE_GLOBAL
+
             pageTextExp = ddjvu_document_get_pagetext(m_parent->m_document, m_index, "word");
+        }
 
-            if(pageTextExp == miniexp_dummy)
-            {
-                clearMessageQueue(m_parent->m_context, true);
-            }
-            else
-            {
-                break;
-            }
+        if(pageTextExp != miniexp_dummy)
+        {
+            break;
         }
+
+        m_parent->m_messageWaiter->wait(generation);
     }
 
     const QTransform transform = QTransform::fromScale(72.0 / m_resolution, 72.0 / m_resolution);
@@ -727,6 +1092,7 @@ QList< QRectF > DjVuPage::search(const QString& text, bool matchCase, bool whole
     auto results = findText(pageTextExp, m_size, transform, words, matchCase, wholeWords);
 
     {
+        LOCK_PAGE
         LOCK_PAGE_GLOBAL
 
         ddjvu_miniexp_release(m_parent->m_document, pageTextExp);
@@ -735,12 +1101,15 @@ QList< QRectF > DjVuPage::search(const QString& text, bool matchCase, bool whole
     return results;
 }
 
-DjVuDocument::DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_document_t* document) :
+DjVuDocument::DjVuDocument(QMutex* globalMutex, const QSharedPointer< DjVuMessagePump >& messagePump, qint64 pageCacheSize, ddjvu_context_t* context, ddjvu_document_t* document) :
     m_mutex(),
     m_globalMutex(globalMutex),
+    m_messagePump(messagePump),
+    m_messageWaiter(),
     m_context(context),
     m_document(document),
     m_format(),
+    m_pageCache(new DjVuPageCache(document, pageCacheSize)),
     m_pageByName(),
     m_titleByIndex()
 {
@@ -750,11 +1119,17 @@ DjVuDocument::DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_
     ddjvu_format_set_row_order(m_format, 1);
     ddjvu_format_set_y_direction(m_format, 1);
 
+    m_messageWaiter = m_messagePump->add(m_context);
+
     prepareFileInfo();
 }
 
 DjVuDocument::~DjVuDocument()
 {
+    m_pageCache.reset();
+
+    m_messagePump->remove(m_context);
+
     ddjvu_document_release(m_document);
     ddjvu_context_release(m_context);
     ddjvu_format_release(m_format);
@@ -769,23 +1144,25 @@ int DjVuDocument::numberOfPages() const
 
 Page* DjVuDocument::page(int index) const
 {
-    LOCK_DOCUMENT
-
     ddjvu_status_t status;
     ddjvu_pageinfo_t pageinfo;
 
     while(true)
     {
-        status = ddjvu_document_get_pageinfo(m_document, index, &pageinfo);
+        const quint64 generation = m_messageWaiter->generation();
 
-        if(status < DDJVU_JOB_OK)
         {
-            clearMessageQueue(m_context, true);
+            LOCK_DOCUMENT
+
+            status = ddjvu_document_get_pageinfo(m_document, index, &pageinfo);
         }
-        else
+
+        if(status >= DDJVU_JOB_OK)
         {
             break;
         }
+
+        m_messageWaiter->wait(generation);
     }
 
     if(status >= DDJVU_JOB_FAILED)
@@ -796,6 +1173,59 @@ Page* DjVuDocument::page(int index) const
     return new DjVuPage(this, index, pageinfo);
 }
 
+QVector< QSizeF > DjVuDocument::pageSizes() const
+{
+    const int numberOfPages = this->numberOfPages();
+
+    QVector< QSizeF > sizes(numberOfPages);
+
+    QVector< int > pendingIndices;
+    pendingIndices.reserve(numberOfPages);
+
+    for(int index = 0; index < numberOfPages; ++index)
+    {
+        pendingIndices.append(index);
+    }
+
+    // The information of all pages is requested before waiting for messages,
+    // so that the decoder can fetch it together instead of one page after the other.
+    while(!pendingIndices.isEmpty())
+    {
+        const quint64 generation = m_messageWaiter->generation();
+
+        QVector< int > stillPendingIndices;
+
+        {
+            LOCK_DOCUMENT
+
+            foreach(int index, pendingIndices)
+            {
+                ddjvu_pageinfo_t pageinfo;
+
+                const ddjvu_status_t status = ddjvu_document_get_pageinfo(m_document, index, &pageinfo);
+
+                if(status < DDJVU_JOB_OK)
+                {
+                    stillPendingIndices.append(index);
+                }
+                else if(status == DDJVU_JOB_OK)
+                {
+                    sizes[index] = 72.0 / pageinfo.dpi * QSizeF(pageinfo.width, pageinfo.height);
+                }
+            }
+        }
+
+        if(!stillPendingIndices.isEmpty())
+        {
+            m_messageWaiter->wait(generation);
+        }
+
+        pendingIndices = stillPendingIndices;
+    }
+
+    return sizes;
+}
+
 QStringList DjVuDocument::saveFilter() const
 {
     return QStringList() << QLatin1String("DjVu (*.djvu *.djv)");
@@ -810,8 +1240,6 @@ bool DjVuDocument::save(const QString& filePath, bool withChanges) const
 {
     Q_UNUSED(withChanges)
 
-    LOCK_DOCUMENT
-
 #ifdef _MSC_VER
 
     FILE* file = _wfopen(reinterpret_cast< const wchar_t* >(filePath.utf16()), L"w+");
@@ -827,11 +1255,24 @@ bool DjVuDocument::save(const QString& filePath, bool withChanges) const
         return false;
     }
 
-    ddjvu_job_t* job = ddjvu_document_save(m_document, file, 0, nullptr);
+    ddjvu_job_t* job = nullptr;
+
+    {
+        LOCK_DOCUMENT
+
+        job = ddjvu_document_save(m_document, file, 0, nullptr);
+    }
 
-    while(!ddjvu_job_done(job))
+    while(true)
     {
-        clearMessageQueue(m_context, true);
+        const quint64 generation = m_messageWaiter->generation();
+
+        if(ddjvu_job_done(job))
+        {
+            break;
+        }
+
+        m_messageWaiter->wait(generation);
     }
 
     fclose(file);
@@ -843,26 +1284,25 @@ Outline DjVuDocument::outline() const
 {
     Outline outline;
 
-    LOCK_DOCUMENT
-
     miniexp_t outlineExp = miniexp_nil;
 
+    while(true)
     {
-        LOCK_DOCUMENT_GLOBAL
+        const quint64 generation = m_messageWaiter->generation();
 
-        while(true)
         {
+            LOCK_DOCUMENT
+            LOCK_DOCUMENT_GLOBAL
+
             outlineExp = ddjvu_document_get_outline(m_document);
+        }
 
-            if(outlineExp == miniexp_dummy)
-            {
-                clearMessageQueue(m_context, true);
-            }
-            else
-            {
-                break;
-            }
+        if(outlineExp != miniexp_dummy)
+        {
+            break;
         }
+
+        m_messageWaiter->wait(generation);
     }
 
     if(miniexp_length(outlineExp) > 1 && qstrcmp(miniexp_to_name(miniexp_car(outlineExp)), "bookmarks") == 0)
@@ -871,6 +1311,7 @@ Outline DjVuDocument::outline() const
     }
 
     {
+        LOCK_DOCUMENT
         LOCK_DOCUMENT_GLOBAL
 
         ddjvu_miniexp_release(m_document, outlineExp);
@@ -883,31 +1324,31 @@ Properties DjVuDocument::properties() const
 {
     Properties properties;
 
-    LOCK_DOCUMENT
-
     miniexp_t annoExp = miniexp_nil;
 
+    while(true)
     {
-        LOCK_DOCUMENT_GLOBAL
+        const quint64 generation = m_messageWaiter->generation();
 
-        while(true)
         {
+            LOCK_DOCUMENT
+            LOCK_DOCUMENT_GLOBAL
+
             annoExp = ddjvu_document_get_anno(m_document, TRUE);
+        }
 
-            if(annoExp == miniexp_dummy)
-            {
-                clearMessageQueue(m_context, true);
-            }
-            else
-            {
-                break;
-            }
+        if(annoExp != miniexp_dummy)
+        {
+            break;
         }
+
+        m_messageWaiter->wait(generation);
     }
 
     properties = loadProperties(annoExp);
 
     {
+        LOCK_DOCUMENT
         LOCK_DOCUMENT_GLOBAL
 
         ddjvu_miniexp_release(m_document, annoExp);
@@ -945,14 +1386,50 @@ void DjVuDocument::prepareFileInfo()
 
 } // Model
 
+DjVuSettingsWidget::DjVuSettingsWidget(QSettings* settings, QWidget* parent) : SettingsWidget(parent),
+    m_settings(settings)
+{
+    m_layout = new QFormLayout(this);
+
+    // page cache size
+
+    m_pageCacheSizeSpinBox = new QSpinBox(this);
+    m_pageCacheSizeSpinBox->setRange(0, 4096);
+    m_pageCacheSizeSpinBox->setSingleStep(16);
+    m_pageCacheSizeSpinBox->setSuffix(" MB");
+    m_pageCacheSizeSpinBox->setSpecialValueText(tr("None"));
+    m_pageCacheSizeSpinBox->setToolTip(tr("Memory used to keep the decoded pages of each document. Effective after reloading the document."));
+    m_pageCacheSizeSpinBox->setValue(m_settings->value("pageCacheSize", Defaults::pageCacheSize).toInt());
+
+    m_layout->addRow(tr("Decoded page cache:"), m_pageCacheSizeSpinBox);
+}
+
+void DjVuSettingsWidget::accept()
+{
+    m_settings->setValue("pageCacheSize", m_pageCacheSizeSpinBox->value());
+}
+
+void DjVuSettingsWidget::reset()
+{
+    m_pageCacheSizeSpinBox->setValue(Defaults::pageCacheSize);
+}
+
 DjVuPlugin::DjVuPlugin(QObject* parent) : QObject(parent),
-    m_globalMutex()
+    m_globalMutex(),
+    m_messagePump(new Model::DjVuMessagePump)
 {
     setObjectName("DjVuPlugin");
+
+    m_settings = new QSettings("qpdfview", "djvu-plugin", this);
+
+    m_messagePump->start();
 }
 
 Model::Document* DjVuPlugin::loadDocument(const QString& filePath) const
 {
+    // A separate settings object is used as documents are loaded by several threads at once.
+    const QSettings settings(m_settings->organizationName(), m_settings->applicationName());
+
     ddjvu_context_t* context = ddjvu_context_create("qpdfview");
 
     if(context == nullptr)
@@ -987,7 +1464,14 @@ Model::Document* DjVuPlugin::loadDocument(const QString& filePath) const
         return nullptr;
     }
 
-    return new Model::DjVuDocument(&m_globalMutex, context, document);
+    const qint64 pageCacheSize = qint64(1024) * 1024 * settings.value("pageCacheSize", Defaults::pageCacheSize).toInt();
+
+    return new Model::DjVuDocument(&m_globalMutex, m_messagePump, pageCacheSize, context, document);
+}
+
+SettingsWidget* DjVuPlugin::createSettingsWidget(QWidget* parent) const
+{
+    return new DjVuSettingsWidget(m_settings, parent);
 }
 
 } // qpdfview
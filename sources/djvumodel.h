@@ -27,6 +27,12 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QHash>
 #include <QMutex>
+#include <QScopedPointer>
+#include <QSharedPointer>
+
+class QFormLayout;
+class QSettings;
+class QSpinBox;
 
 typedef struct ddjvu_context_s ddjvu_context_t;
 typedef struct ddjvu_format_s ddjvu_format_t;
@@ -42,6 +48,10 @@ class DjVuPlugin;
 
 namespace Model
 {
+    class DjVuMessagePump;
+    class DjVuMessageWaiter;
+    class DjVuPageCache;
+
     class DjVuPage final : public Page
     {
         friend class DjVuDocument;
@@ -53,7 +63,10 @@ namespace Model
         QSizeF size() const final;
 
         DECL_NODISCARD
-        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const final;
+        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const final;
+
+        DECL_NODISCARD
+        QString backendName() const final { return QStringLiteral("DjVuLibre"); }
 
         DECL_NODISCARD
         QString label() const final;
@@ -92,6 +105,8 @@ namespace Model
 
         Page* page(int index) const final;
 
+        QVector< QSizeF > pageSizes() const final;
+
         QStringList saveFilter() const final;
 
         bool canSave() const final;
@@ -103,15 +118,21 @@ namespace Model
     private:
         Q_DISABLE_COPY(DjVuDocument)
 
-        DjVuDocument(QMutex* globalMutex, ddjvu_context_t* context, ddjvu_document_t* document);
+        DjVuDocument(QMutex* globalMutex, const QSharedPointer< DjVuMessagePump >& messagePump, qint64 pageCacheSize, ddjvu_context_t* context, ddjvu_document_t* document);
 
         mutable QMutex m_mutex;
         mutable QMutex* m_globalMutex;
 
+        QSharedPointer< DjVuMessagePump > m_messagePump;
+        QSharedPointer< DjVuMessageWaiter > m_messageWaiter;
+
         ddjvu_context_t* m_context;
         ddjvu_document_t* m_document;
         ddjvu_format_t* m_format;
 
+        // decoded pages shared by all renders of this document and guarded by its mutex
+        QScopedPointer< DjVuPageCache > m_pageCache;
+
         QHash< QString, int > m_pageByName;
         QHash< int, QString > m_titleByIndex;
 
@@ -120,6 +141,27 @@ namespace Model
     };
 }
 
+class DjVuSettingsWidget final : public SettingsWidget
+{
+    Q_OBJECT
+
+public:
+    explicit DjVuSettingsWidget(QSettings* settings, QWidget* parent = nullptr);
+
+    void accept() final;
+    void reset() final;
+
+private:
+    Q_DISABLE_COPY(DjVuSettingsWidget)
+
+    QSettings* m_settings;
+
+    QFormLayout* m_layout;
+
+    QSpinBox* m_pageCacheSizeSpinBox;
+
+};
+
 class DjVuPlugin final : public QObject, Plugin
 {
     Q_OBJECT
@@ -136,9 +178,15 @@ public:
 
     Model::Document* loadDocument(const QString& filePath) const final;
 
+    SettingsWidget* createSettingsWidget(QWidget* parent) const final;
+
 private:
+    QSettings* m_settings;
+
     mutable QMutex m_globalMutex;
 
+    QSharedPointer< Model::DjVuMessagePump > m_messagePump;
+
 };
 
 } // qpdfview
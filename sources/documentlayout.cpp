@@ -22,8 +22,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "documentlayout.h"
 
+#include <algorithm>
+
 #include "settings.h"
-#include "pageitem.h"
 
 namespace
 {
@@ -37,6 +38,47 @@ const qreal viewportPadding = 6.0f;
 namespace qpdfview
 {
 
+void OffsetIndex::clear()
+{
+    m_firstIndices.clear();
+    m_lastIndices.clear();
+
+    m_begins.clear();
+    m_ends.clear();
+}
+
+void OffsetIndex::reserve(int count)
+{
+    m_firstIndices.reserve(count);
+    m_lastIndices.reserve(count);
+
+    m_begins.reserve(count);
+    m_ends.reserve(count);
+}
+
+void OffsetIndex::append(int firstIndex, int lastIndex, qreal begin, qreal end)
+{
+    m_firstIndices.append(firstIndex);
+    m_lastIndices.append(lastIndex);
+
+    m_begins.append(begin);
+    m_ends.append(end);
+}
+
+QPair< int, int > OffsetIndex::range(qreal begin, qreal end) const
+{
+    // As the rows do not overlap, both their beginnings and their ends are sorted.
+    const int firstRow = std::upper_bound(m_ends.constBegin(), m_ends.constEnd(), begin) - m_ends.constBegin();
+    const int lastRow = std::lower_bound(m_begins.constBegin(), m_begins.constEnd(), end) - m_begins.constBegin() - 1;
+
+    if(firstRow > lastRow)
+    {
+        return qMakePair(0, -1);
+    }
+
+    return qMakePair(m_firstIndices.at(firstRow), m_lastIndices.at(lastRow));
+}
+
 Settings* DocumentLayout::s_settings = nullptr;
 
 DocumentLayout::DocumentLayout()
@@ -127,21 +169,26 @@ qreal SinglePageLayout::visibleWidth(int viewportWidth) const
     return viewportWidth - viewportPadding - 2.0f * pageSpacing;
 }
 
-void SinglePageLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool /* rightToLeft */,
+void SinglePageLayout::prepareLayout(QVector< PageGeometry >& pages, bool /* rightToLeft */,
                                      qreal& left, qreal& right, qreal& height)
 {
     const qreal pageSpacing = s_settings->documentView().pageSpacing();
 
-    for(int index = 0; index < pageItems.count(); ++index)
+    m_rows.clear();
+    m_rows.reserve(pages.count());
+
+    for(int index = 0; index < pages.count(); ++index)
     {
-        PageItem* page = pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect();
+        PageGeometry& page = pages[index];
+        const QRectF& boundingRect = page.boundingRect;
 
-        page->setPos(-boundingRect.left() - 0.5f * boundingRect.width(), height - boundingRect.top());
+        page.pos = QPointF(-boundingRect.left() - 0.5f * boundingRect.width(), height - boundingRect.top());
 
         qreal pageHeight = boundingRect.height();
         qreal pageWidth = boundingRect.width();
 
+        m_rows.append(index, index, height, height + pageHeight);
+
         left = std::min(left, -0.5f * pageWidth - pageSpacing);
         right = std::max(right, 0.5f * pageWidth + pageSpacing);
         height += pageHeight + pageSpacing;
@@ -189,23 +236,26 @@ qreal TwoPagesLayout::visibleWidth(int viewportWidth) const
     return (viewportWidth - viewportPadding - 3.0f * pageSpacing) / 2.0f;
 }
 
-void TwoPagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
+void TwoPagesLayout::prepareLayout(QVector< PageGeometry >& pages, bool rightToLeft,
                                    qreal& left, qreal& right, qreal& height)
 {
     const qreal pageSpacing = s_settings->documentView().pageSpacing();
     qreal pageHeight = 0.0f;
 
-    for(int index = 0; index < pageItems.count(); ++index)
+    m_rows.clear();
+    m_rows.reserve(pages.count() / 2 + 1);
+
+    for(int index = 0; index < pages.count(); ++index)
     {
-        PageItem* page = pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect();
+        PageGeometry& page = pages[index];
+        const QRectF& boundingRect = page.boundingRect;
 
         const qreal leftPos = -boundingRect.left() - boundingRect.width() - 0.5f * pageSpacing;
         const qreal rightPos = -boundingRect.left() + 0.5f * pageSpacing;
 
         if(index == leftIndex(index))
         {
-            page->setPos(rightToLeft ? rightPos : leftPos, height - boundingRect.top());
+            page.pos = QPointF(rightToLeft ? rightPos : leftPos, height - boundingRect.top());
 
             pageHeight = boundingRect.height();
 
@@ -218,15 +268,17 @@ void TwoPagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool r
                 left = std::min(left, -boundingRect.width() - 1.5f * pageSpacing);
             }
 
-            if(index == rightIndex(index, pageItems.count()))
+            if(index == rightIndex(index, pages.count()))
             {
+                m_rows.append(index, index, height, height + pageHeight);
+
                 right = std::max(right, 0.5f * pageSpacing);
                 height += pageHeight + pageSpacing;
             }
         }
         else
         {
-            page->setPos(rightToLeft ? leftPos : rightPos, height - boundingRect.top());
+            page.pos = QPointF(rightToLeft ? leftPos : rightPos, height - boundingRect.top());
 
             pageHeight = std::max(pageHeight, boundingRect.height());
 
@@ -239,6 +291,8 @@ void TwoPagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool r
                 right = std::max(right, boundingRect.width() + 1.5f * pageSpacing);
             }
 
+            m_rows.append(leftIndex(index), index, height, height + pageHeight);
+
             height += pageHeight + pageSpacing;
         }
     }
@@ -313,21 +367,25 @@ qreal MultiplePagesLayout::visibleWidth(int viewportWidth) const
     return (viewportWidth - viewportPadding - (pagesPerRow + 1) * pageSpacing) / pagesPerRow;
 }
 
-void MultiplePagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
+void MultiplePagesLayout::prepareLayout(QVector< PageGeometry >& pages, bool rightToLeft,
                                         qreal& left, qreal& right, qreal& height)
 {
     const qreal pageSpacing = s_settings->documentView().pageSpacing();
+    const int pagesPerRow = s_settings->documentView().pagesPerRow();
     qreal pageHeight = 0.0;
 
-    for(int index = 0; index < pageItems.count(); ++index)
+    m_rows.clear();
+    m_rows.reserve(pages.count() / pagesPerRow + 1);
+
+    for(int index = 0; index < pages.count(); ++index)
     {
-        PageItem* page = pageItems.at(index);
-        const QRectF boundingRect = page->boundingRect();
+        PageGeometry& page = pages[index];
+        const QRectF& boundingRect = page.boundingRect;
 
         const qreal leftPos = left - boundingRect.left() + pageSpacing;
         const qreal rightPos = right - boundingRect.left() - boundingRect.width() - pageSpacing;
 
-        page->setPos(rightToLeft ? rightPos : leftPos, height - boundingRect.top());
+        page.pos = QPointF(rightToLeft ? rightPos : leftPos, height - boundingRect.top());
 
         pageHeight = std::max(pageHeight, boundingRect.height());
 
@@ -340,8 +398,10 @@ void MultiplePagesLayout::prepareLayout(const QVector< PageItem* >& pageItems, b
             left += boundingRect.width() + pageSpacing;
         }
 
-        if(index == rightIndex(index, pageItems.count()))
+        if(index == rightIndex(index, pages.count()))
         {
+            m_rows.append(leftIndex(index), index, height, height + pageHeight);
+
             height += pageHeight + pageSpacing;
             pageHeight = 0.0f;
 
@@ -25,16 +25,58 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QMap>
 #include <QPair>
+#include <QRectF>
+#include <QVector>
 
 #include "global.h"
-
-class QRectF;
+#include "renderparam.h"
 
 namespace qpdfview
 {
 
 class Settings;
-class PageItem;
+
+// Everything needed to lay out and show a page without creating its item
+struct PageGeometry
+{
+    QSizeF size;
+    RenderParam renderParam;
+    QRectF cropRect;
+
+    // in item coordinates including the crop rectangle
+    QRectF boundingRect;
+    QPointF pos;
+
+    bool visible;
+
+    DECL_NODISCARD
+    QRectF sceneBoundingRect() const { return boundingRect.translated(pos); }
+
+};
+
+// The extents of consecutive rows of pages along the scrolling direction, i.e. prefix sums of the row heights,
+// so that the pages within a range of offsets can be found by binary search.
+class OffsetIndex
+{
+public:
+    void clear();
+    void reserve(int count);
+
+    // Rows have to be appended in order of their offsets and must not overlap.
+    void append(int firstIndex, int lastIndex, qreal begin, qreal end);
+
+    // the first and last index of the pages in rows overlapping the range or an empty pair if there are none
+    DECL_NODISCARD
+    QPair< int, int > range(qreal begin, qreal end) const;
+
+private:
+    QVector< int > m_firstIndices;
+    QVector< int > m_lastIndices;
+
+    QVector< qreal > m_begins;
+    QVector< qreal > m_ends;
+
+};
 
 struct DocumentLayout
 {
@@ -69,12 +111,18 @@ struct DocumentLayout
     DECL_NODISCARD
     static qreal visibleHeight(int viewportHeight);
 
-    virtual void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
+    virtual void prepareLayout(QVector< PageGeometry >& pages, bool rightToLeft,
                                qreal& left, qreal& right, qreal& height) = 0;
 
+    // the pages in rows overlapping the vertical range as laid out by the last call to prepareLayout
+    DECL_NODISCARD
+    QPair< int, int > pageRange(qreal top, qreal bottom) const { return m_rows.range(top, bottom); }
+
 protected:
     static Settings* s_settings;
 
+    OffsetIndex m_rows;
+
 };
 
 struct SinglePageLayout : public DocumentLayout
@@ -100,7 +148,7 @@ struct SinglePageLayout : public DocumentLayout
     DECL_NODISCARD
     qreal visibleWidth(int viewportWidth) const override;
 
-    void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
+    void prepareLayout(QVector< PageGeometry >& pages, bool rightToLeft,
                        qreal& left, qreal& right, qreal& height) override;
 
 };
@@ -128,7 +176,7 @@ struct TwoPagesLayout : public DocumentLayout
     DECL_NODISCARD
     qreal visibleWidth(int viewportWidth) const override;
 
-    void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
+    void prepareLayout(QVector< PageGeometry >& pages, bool rightToLeft,
                        qreal& left, qreal& right, qreal& height) override;
 
 };
@@ -171,7 +219,7 @@ struct MultiplePagesLayout : public DocumentLayout
     DECL_NODISCARD
     qreal visibleWidth(int viewportWidth) const override;
 
-    void prepareLayout(const QVector< PageItem* >& pageItems, bool rightToLeft,
+    void prepareLayout(QVector< PageGeometry >& pages, bool rightToLeft,
                        qreal& left, qreal& right, qreal& height) override;
 
 };
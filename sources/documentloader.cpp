@@ -0,0 +1,274 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "documentloader.h"
+
+#include <QDebug>
+#include <QFileInfo>
+#include <QInputDialog>
+#include <QtConcurrentRun>
+
+#include "lazypage.h"
+#include "model.h"
+#include "pluginhandler.h"
+#include "settings.h"
+
+namespace qpdfview
+{
+
+struct DocumentLoader::Job
+{
+    enum Stage
+    {
+        PrepareStage,
+        LoadStage,
+        EnumerateStage
+    };
+
+    Job(const QString& filePath, int openPageCount) :
+        stage(PrepareStage),
+        filePath(filePath),
+        adjustedFilePath(),
+        fileType(PluginHandler::Unknown),
+        plugin(nullptr),
+        document(nullptr),
+        openPageCount(openPageCount),
+        pages(),
+        canceled(0)
+    {
+    }
+
+    ~Job()
+    {
+        qDeleteAll(pages);
+        delete document;
+    }
+
+    Stage stage;
+
+    QString filePath;
+    QString adjustedFilePath;
+
+    PluginHandler::FileType fileType;
+    const Plugin* plugin;
+
+    Model::Document* document;
+
+    int openPageCount;
+    QVector< Model::Page* > pages;
+
+    QAtomicInt canceled;
+
+    static void run(QSharedPointer< Job > job)
+    {
+        if(job->canceled.loadAcquire() != 0)
+        {
+            return;
+        }
+
+        switch(job->stage)
+        {
+        case PrepareStage:
+            job->fileType = PluginHandler::prepareFile(job->filePath, job->adjustedFilePath);
+            break;
+        case LoadStage:
+            job->document = PluginHandler::loadDocument(job->plugin, job->adjustedFilePath);
+            break;
+        case EnumerateStage:
+            job->enumeratePages();
+            break;
+        }
+    }
+
+    void enumeratePages()
+    {
+        const int numberOfPages = document->numberOfPages();
+
+        if(numberOfPages == 0)
+        {
+            qWarning() << "No pages were found in document at" << filePath;
+
+            return;
+        }
+
+        // Only the sizes are needed for the layout, the pages themselves are created when they are used.
+        const QVector< QSizeF > pageSizes = document->pageSizes();
+
+        if(canceled.loadAcquire() != 0)
+        {
+            return;
+        }
+
+        for(int index = 0; index < pageSizes.count(); ++index)
+        {
+            if(!pageSizes.at(index).isValid())
+            {
+                qWarning() << "No page" << index << "was found in document at" << filePath;
+
+                return;
+            }
+        }
+
+        pages = Model::LazyPage::createPages(document, pageSizes, openPageCount);
+    }
+
+};
+
+DocumentLoader::DocumentLoader(QWidget* parent) : QObject(parent),
+    m_job(),
+    m_filePath(),
+    m_running(false),
+    m_watcher(nullptr)
+{
+}
+
+DocumentLoader::~DocumentLoader()
+{
+    cancel();
+}
+
+bool DocumentLoader::take(Model::Document*& document, QVector< Model::Page* >& pages)
+{
+    if(m_running || m_job.isNull() || m_job->pages.isEmpty())
+    {
+        return false;
+    }
+
+    document = m_job->document;
+    pages = m_job->pages;
+
+    m_job->document = nullptr;
+    m_job->pages.clear();
+
+    m_job.reset();
+
+    return true;
+}
+
+void DocumentLoader::start(const QString& filePath)
+{
+    cancel();
+
+    m_job.reset(new Job(filePath, Settings::instance()->pageItem().openPageCount()));
+
+    m_filePath = filePath;
+    m_running = true;
+
+    runStage();
+}
+
+void DocumentLoader::cancel()
+{
+    if(m_job.isNull())
+    {
+        return;
+    }
+
+    // The worker drops its reference to the job when it returns and the last one deletes the partial results.
+    m_job->canceled.storeRelease(1);
+    m_job.reset();
+
+    if(m_watcher != nullptr)
+    {
+        m_watcher->disconnect(this);
+        m_watcher->deleteLater();
+        m_watcher = nullptr;
+    }
+
+    m_running = false;
+}
+
+void DocumentLoader::onStageFinished()
+{
+    m_watcher->deleteLater();
+    m_watcher = nullptr;
+
+    const QSharedPointer< Job > job = m_job;
+
+    switch(job->stage)
+    {
+    case Job::PrepareStage:
+        job->plugin = PluginHandler::instance()->plugin(job->fileType);
+
+        if(job->plugin == nullptr)
+        {
+            finish(false);
+            return;
+        }
+
+        job->stage = Job::LoadStage;
+        runStage();
+        break;
+    case Job::LoadStage:
+        if(job->document == nullptr)
+        {
+            finish(false);
+            return;
+        }
+
+        if(job->document->isLocked())
+        {
+            const QString password = QInputDialog::getText(qobject_cast< QWidget* >(parent()), tr("Unlock %1").arg(QFileInfo(job->filePath).completeBaseName()), tr("Password:"), QLineEdit::Password);
+
+            // The load might have been canceled while the dialog was shown.
+            if(m_job != job)
+            {
+                return;
+            }
+
+            if(job->document->unlock(password))
+            {
+                finish(false);
+                return;
+            }
+        }
+
+        job->stage = Job::EnumerateStage;
+        runStage();
+        break;
+    case Job::EnumerateStage:
+        finish(!job->pages.isEmpty());
+        break;
+    }
+}
+
+void DocumentLoader::runStage()
+{
+    m_watcher = new QFutureWatcher< void >(this);
+
+    connect(m_watcher, SIGNAL(finished()), SLOT(onStageFinished()));
+
+    m_watcher->setFuture(QtConcurrent::run(&Job::run, m_job));
+}
+
+void DocumentLoader::finish(bool success)
+{
+    m_running = false;
+
+    if(!success)
+    {
+        m_job.reset();
+    }
+
+    emit finished(success);
+}
+
+} // qpdfview
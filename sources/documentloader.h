@@ -0,0 +1,91 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef DOCUMENTLOADER_H
+#define DOCUMENTLOADER_H
+
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSharedPointer>
+#include <QVector>
+
+#include "global.h"
+
+class QWidget;
+
+namespace qpdfview
+{
+
+namespace Model
+{
+class Document;
+class Page;
+}
+
+// Loads a document and its pages on the global thread pool so that opening large documents or documents on slow storage
+// does not block the user interface. Only loading the plug-in and asking for a password happen on the main thread.
+// A canceled load is not waited for and its results are discarded by whichever thread drops them last.
+class DocumentLoader : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit DocumentLoader(QWidget* parent);
+    ~DocumentLoader() override;
+
+    DECL_NODISCARD
+    bool isRunning() const { return m_running; }
+
+    DECL_NODISCARD
+    const QString& filePath() const { return m_filePath; }
+
+    // Transfers the ownership of the document and its pages to the caller after the load finished successfully.
+    bool take(Model::Document*& document, QVector< Model::Page* >& pages);
+
+public slots:
+    void start(const QString& filePath);
+    void cancel();
+
+signals:
+    void finished(bool success);
+
+protected slots:
+    void onStageFinished();
+
+private:
+    Q_DISABLE_COPY(DocumentLoader)
+
+    struct Job;
+    QSharedPointer< Job > m_job;
+
+    QString m_filePath;
+    bool m_running;
+
+    QFutureWatcher< void >* m_watcher;
+    void runStage();
+
+    void finish(bool success);
+
+};
+
+} // qpdfview
+
+#endif // DOCUMENTLOADER_H
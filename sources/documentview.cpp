@@ -25,23 +25,28 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "documentview.h"
 
+#include <algorithm>
+
 #include <QApplication>
-#include <QInputDialog>
 #include <QDesktopWidget>
 #include <QDesktopServices>
 #include <QDir>
 #include <QFileSystemWatcher>
 #include <QKeyEvent>
+#include <QLabel>
 #include <qmath.h>
 #include <QMessageBox>
 #include <QPrintEngine>
 #include <QProcess>
+#include <QProgressBar>
 #include <QProgressDialog>
+#include <QPushButton>
 #include <QScreen>
 #include <QScrollBar>
 #include <QTemporaryFile>
 #include <QTimer>
 #include <QUrl>
+#include <QVBoxLayout>
 
 #ifdef WITH_CUPS
 
@@ -75,6 +80,11 @@ typedef synctex_node_t synctex_node_p;
 #include "searchtask.h"
 #include "miscellaneous.h"
 #include "documentlayout.h"
+#include "documentloader.h"
+#include "renderscheduler.h"
+#include "tilecache.h"
+#include "tileitem.h"
+#include "idleprerenderer.h"
 
 namespace
 {
@@ -664,6 +674,37 @@ void addFileProperties(Model::Properties& properties, const QFileInfo& fileInfo)
     addProperty(properties, "File group", fileInfo.owner());
 }
 
+// Documents loaded from the same unchanged file render identically and can share their renders.
+QByteArray documentIdentity(const QFileInfo& fileInfo)
+{
+    const QFileInfo currentFileInfo(fileInfo.absoluteFilePath());
+
+    if(!currentFileInfo.exists())
+    {
+        return {};
+    }
+
+    QByteArray identity;
+    QDataStream stream(&identity, QIODevice::WriteOnly);
+
+    stream << currentFileInfo.canonicalFilePath() << currentFileInfo.size() << currentFileInfo.lastModified();
+
+    return identity;
+}
+
+// A modified document no longer matches its file and has to be told apart from all other documents.
+QByteArray uniqueDocumentIdentity()
+{
+    static quint64 count = 0;
+
+    return QByteArray("modified:") + QByteArray::number(++count);
+}
+
+inline bool isPersistentDocumentIdentity(const QByteArray& identity)
+{
+    return !identity.isEmpty() && !identity.startsWith("modified:");
+}
+
 void appendToPath(const QModelIndex& index, QByteArray& path)
 {
     path.append(index.data(Qt::DisplayRole).toByteArray()).append('\0');
@@ -699,6 +740,114 @@ void restoreExpandedPaths(QAbstractItemModel* model, const QSet<QByteArray>& pat
     }
 }
 
+// Prefetching is limited by the memory its pixmaps take up in the cache and by the render time it takes.
+class PrefetchBudget
+{
+public:
+    explicit PrefetchBudget(int horizon) :
+        m_bytes(qint64(TileCache::instance()->maxCost(TileCache::PixmapTier)) * 1024 / 2),
+        m_milliseconds(qreal(horizon) * qMax(1, RenderScheduler::instance()->workerCount()))
+    {
+    }
+
+    // Starts prefetching the page and returns false once the budget is exhausted.
+    bool prefetch(PageItem* page)
+    {
+        if(page->startRender(true) > 0)
+        {
+            m_bytes -= page->estimatedPixmapSize();
+            m_milliseconds -= page->estimatedRenderTime();
+        }
+
+        return m_bytes > 0 && m_milliseconds > 0.0;
+    }
+
+private:
+    qint64 m_bytes;
+    qreal m_milliseconds;
+
+};
+
+// Items are created for the pages within half a viewport of the visible area
+// and released once they are more than two viewports away from it.
+const qreal prepareMargin = 0.5;
+const qreal releaseMargin = 2.0;
+
+// Released items are kept for reuse up to this number before they are destroyed.
+const int maximumReleasedItems = 32;
+
+inline QRectF adjustedByViewports(const QRectF& rect, qreal viewports)
+{
+    const qreal dx = viewports * rect.width();
+    const qreal dy = viewports * rect.height();
+
+    return rect.adjusted(-dx, -dy, dx, dy);
+}
+
+template< typename Item >
+Item* takeReleasedItem(QList< Item* >& releasedItems, int index)
+{
+    for(int position = 0; position < releasedItems.count(); ++position)
+    {
+        if(releasedItems.at(position)->index() == index)
+        {
+            return releasedItems.takeAt(position);
+        }
+    }
+
+    return nullptr;
+}
+
+template< typename Item >
+Item* findReleasedItem(const QList< Item* >& releasedItems, int index)
+{
+    foreach(Item* item, releasedItems)
+    {
+        if(item->index() == index)
+        {
+            return item;
+        }
+    }
+
+    return nullptr;
+}
+
+template< typename Item >
+void releaseItems(QGraphicsScene* scene, const QVector< PageGeometry >& geometries, const QRectF& keptRect,
+                  QHash< int, Item* >& items, QList< Item* >& releasedItems)
+{
+    for(auto item = items.begin(); item != items.end();)
+    {
+        const PageGeometry& geometry = geometries.at(item.key());
+
+        if(geometry.visible && geometry.sceneBoundingRect().intersects(keptRect))
+        {
+            ++item;
+            continue;
+        }
+
+        scene->removeItem(item.value());
+        releasedItems.append(item.value());
+
+        item = items.erase(item);
+    }
+
+    // The least recently released items are destroyed first, but only once they stopped rendering
+    // and loading their interactive elements as waiting for either would block.
+    for(auto item = releasedItems.begin(); item != releasedItems.end() && releasedItems.count() > maximumReleasedItems;)
+    {
+        if(!(*item)->isBusy())
+        {
+            delete *item;
+            item = releasedItems.erase(item);
+        }
+        else
+        {
+            ++item;
+        }
+    }
+}
+
 } // anonymous
 
 namespace qpdfview
@@ -734,9 +883,19 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     m_autoRefreshWatcher(),
     m_autoRefreshTimer(),
     m_prefetchTimer(),
+    m_predictivePrefetchTimer(),
+    m_scrollPredictor(),
+    m_idlePrerenderer(),
+    m_loader(),
+    m_openingWidget(),
+    m_openingLabel(),
+    m_openingProgressBar(),
+    m_deferredPage(0),
+    m_refreshing(false),
     m_document(),
     m_pages(),
     m_fileInfo(),
+    m_documentId(),
     m_wasModified(),
     m_currentPage(-1),
     m_firstPage(-1),
@@ -750,8 +909,16 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
     m_renderFlags(),
     m_highlightAll(),
     m_rubberBandMode(ModifiersMode),
+    m_pageGeometries(),
     m_pageItems(),
+    m_releasedPageItems(),
+    m_visiblePages(0, -1),
+    m_thumbnailGeometries(),
     m_thumbnailItems(),
+    m_releasedThumbnailItems(),
+    m_thumbnailsIndex(),
+    m_thumbnailsVisibleRect(),
+    m_releaseItemsTimer(),
     m_highlight(),
     m_thumbnailsViewportSize(),
     m_thumbnailsOrientation(Qt::Vertical),
@@ -785,8 +952,17 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
 
     connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(onVerticalScrollBarValueChanged()));
 
+    connect(horizontalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(onScrollBarValueChanged()));
+    connect(verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(onScrollBarValueChanged()));
+
     m_thumbnailsScene = new QGraphicsScene(this);
 
+    m_releaseItemsTimer = new QTimer(this);
+    m_releaseItemsTimer->setInterval(250);
+    m_releaseItemsTimer->setSingleShot(true);
+
+    connect(m_releaseItemsTimer, SIGNAL(timeout()), SLOT(onReleaseItemsTimeout()));
+
     // highlight
 
     m_highlight = new QGraphicsRectItem();
@@ -831,6 +1007,50 @@ DocumentView::DocumentView(QWidget* parent) : QGraphicsView(parent),
 
     connect(m_prefetchTimer, SIGNAL(timeout()), SLOT(onPrefetchTimeout()));
 
+    // Predictive prefetching runs repeatedly while scrolling instead of waiting for it to stop.
+    m_predictivePrefetchTimer = new QTimer(this);
+    m_predictivePrefetchTimer->setInterval(50);
+    m_predictivePrefetchTimer->setSingleShot(true);
+
+    connect(m_predictivePrefetchTimer, SIGNAL(timeout()), SLOT(onPredictivePrefetchTimeout()));
+
+    // idle prerendering
+
+    m_idlePrerenderer = new IdlePrerenderer(this);
+
+    connect(this, SIGNAL(currentPageChanged(int)), m_idlePrerenderer, SLOT(setCurrentPage(int)));
+    connect(this, SIGNAL(layoutModeChanged(qpdfview::LayoutMode)), m_idlePrerenderer, SLOT(restart()));
+    connect(this, SIGNAL(scaleModeChanged(qpdfview::ScaleMode)), m_idlePrerenderer, SLOT(restart()));
+    connect(this, SIGNAL(scaleFactorChanged(qreal)), m_idlePrerenderer, SLOT(restart()));
+    connect(this, SIGNAL(rotationChanged(qpdfview::Rotation)), m_idlePrerenderer, SLOT(restart()));
+    connect(this, SIGNAL(renderFlagsChanged(qpdfview::RenderFlags)), m_idlePrerenderer, SLOT(restart()));
+
+    // opening
+
+    m_loader = new DocumentLoader(this);
+
+    connect(m_loader, SIGNAL(finished(bool)), SLOT(onLoaderFinished(bool)));
+
+    auto openingFrame = new QFrame(viewport());
+    openingFrame->setFrameShape(QFrame::StyledPanel);
+    openingFrame->setAutoFillBackground(true);
+
+    m_openingLabel = new QLabel(openingFrame);
+    m_openingProgressBar = new QProgressBar(openingFrame);
+    m_openingProgressBar->setRange(0, 0);
+
+    auto cancelButton = new QPushButton(tr("Cancel"), openingFrame);
+
+    connect(cancelButton, SIGNAL(clicked()), SLOT(cancelOpen()));
+
+    auto openingLayout = new QVBoxLayout(openingFrame);
+    openingLayout->addWidget(m_openingLabel);
+    openingLayout->addWidget(m_openingProgressBar);
+    openingLayout->addWidget(cancelButton, 0, Qt::AlignRight);
+
+    openingFrame->hide();
+    m_openingWidget = openingFrame;
+
     // settings
 
     m_continuousMode = s_settings->documentView().continuousMode();
@@ -880,7 +1100,9 @@ DocumentView::~DocumentView()
     s_searchModel->clearResults(this);
 
     qDeleteAll(m_pageItems);
+    qDeleteAll(m_releasedPageItems);
     qDeleteAll(m_thumbnailItems);
+    qDeleteAll(m_releasedThumbnailItems);
 
     qDeleteAll(m_pages);
     delete m_document;
@@ -892,9 +1114,9 @@ void DocumentView::setFirstPage(int firstPage)
     {
         m_firstPage = firstPage;
 
-        for(int index = 0; index < m_thumbnailItems.count(); ++index)
+        for(auto page = m_thumbnailItems.constBegin(); page != m_thumbnailItems.constEnd(); ++page)
         {
-            m_thumbnailItems.at(index)->setText(pageLabelFromNumber(index + 1));
+            page.value()->setText(pageLabelFromNumber(page.key() + 1));
         }
 
         prepareThumbnailsScene();
@@ -987,7 +1209,7 @@ QString DocumentView::title() const
 {
     QString title;
 
-    if(s_settings->mainWindow().documentTitleAsTabTitle())
+    if(s_settings->mainWindow().documentTitleAsTabTitle() && !m_propertiesModel.isNull())
     {
         for(int row = 0, rowCount = m_propertiesModel->rowCount(); row < rowCount; ++row)
         {
@@ -1017,12 +1239,12 @@ QStringList DocumentView::openFilter()
 
 QStringList DocumentView::saveFilter() const
 {
-    return m_document->saveFilter();
+    return m_document != nullptr ? m_document->saveFilter() : QStringList();
 }
 
 bool DocumentView::canSave() const
 {
-    return m_document->canSave();
+    return m_document != nullptr && m_document->canSave();
 }
 
 void DocumentView::setContinuousMode(bool continuousMode)
@@ -1247,23 +1469,16 @@ void DocumentView::setHighlightAll(bool highlightAll)
     {
         m_highlightAll = highlightAll;
 
-        if(m_highlightAll)
-        {
-            for(int index = 0; index < m_pages.count(); ++index)
-            {
-                const QList<QRectF>& results = s_searchModel->resultsOnPage(this, index + 1);
+        // Items which are created later pick up the highlights themselves.
 
-                m_pageItems.at(index)->setHighlights(results);
-                m_thumbnailItems.at(index)->setHighlights(results);
-            }
+        for(auto page = m_pageItems.constBegin(); page != m_pageItems.constEnd(); ++page)
+        {
+            page.value()->setHighlights(m_highlightAll ? s_searchModel->resultsOnPage(this, page.key() + 1) : QList<QRectF>());
         }
-        else
+
+        for(auto page = m_thumbnailItems.constBegin(); page != m_thumbnailItems.constEnd(); ++page)
         {
-            for(int index = 0; index < m_pages.count(); ++index)
-            {
-                m_pageItems.at(index)->setHighlights(QList<QRectF>());
-                m_thumbnailItems.at(index)->setHighlights(QList<QRectF>());
-            }
+            page.value()->setHighlights(m_highlightAll ? s_searchModel->resultsOnPage(this, page.key() + 1) : QList<QRectF>());
         }
 
         emit highlightAllChanged(m_highlightAll);
@@ -1297,6 +1512,21 @@ void DocumentView::setThumbnailsViewportSize(QSize thumbnailsViewportSize)
     }
 }
 
+void DocumentView::setThumbnailsVisibleRect(const QRectF& thumbnailsVisibleRect)
+{
+    m_thumbnailsVisibleRect = thumbnailsVisibleRect;
+
+    for(auto page = m_thumbnailItems.constBegin(); page != m_thumbnailItems.constEnd(); ++page)
+    {
+        if(!m_thumbnailGeometries.at(page.key()).sceneBoundingRect().intersects(m_thumbnailsVisibleRect))
+        {
+            page.value()->cancelRender();
+        }
+    }
+
+    prepareVisibleThumbnails();
+}
+
 void DocumentView::setThumbnailsOrientation(Qt::Orientation thumbnailsOrientation)
 {
     if(m_thumbnailsOrientation != thumbnailsOrientation)
@@ -1447,98 +1677,109 @@ void DocumentView::show()
     prepareView();
 }
 
-bool DocumentView::open(const QString& filePath)
+bool DocumentView::isOpening() const
 {
-    Model::Document* document = PluginHandler::instance()->loadDocument(filePath);
+    return m_loader->isRunning();
+}
 
-    if(document != nullptr)
+void DocumentView::open(const QString& filePath)
+{
+    // Opening another document supersedes a pending refresh.
+    if(m_refreshing)
     {
-        QVector<Model::Page*> pages;
-
-        if(!checkDocument(filePath, document, pages))
-        {
-            delete document;
-            qDeleteAll(pages);
+        m_refreshing = false;
 
-            return false;
-        }
+        emit refreshFinished(false);
+    }
 
+    // A view without a document is labelled by the file it is opening.
+    if(m_document == nullptr)
+    {
         m_fileInfo.setFile(filePath);
-        m_wasModified = false;
+    }
 
-        m_currentPage = 1;
+    m_deferredPage = 0;
 
-        m_past.clear();
-        m_future.clear();
+    m_openingLabel->setText(tr("Opening '%1'...").arg(QFileInfo(filePath).fileName()));
 
-        prepareDocument(document, pages);
+    m_openingWidget->show();
+    adjustOpeningWidget();
 
-        loadDocumentDefaults();
+    m_loader->start(filePath);
+}
 
-        adjustScrollBarPolicy();
+void DocumentView::cancelOpen()
+{
+    if(m_loader->isRunning())
+    {
+        m_loader->cancel();
 
-        prepareScene();
-        prepareView();
+        m_openingWidget->hide();
 
-        prepareThumbnailsScene();
+        if(m_refreshing)
+        {
+            m_refreshing = false;
 
-        emit documentChanged();
+            emit refreshFinished(false);
+        }
+        else
+        {
+            emit openCanceled();
+        }
+    }
+}
 
-        emit numberOfPagesChanged(m_pages.count());
-        emit currentPageChanged(m_currentPage);
+bool DocumentView::refresh()
+{
+    if(m_loader->isRunning() && !m_refreshing)
+    {
+        return false;
+    }
 
-        emit canJumpChanged(false, false);
+    m_refreshing = true;
 
-        emit continuousModeChanged(m_continuousMode);
-        emit layoutModeChanged(m_layout->layoutMode());
-        emit rightToLeftModeChanged(m_rightToLeftMode);
-    }
+    m_loader->start(m_fileInfo.filePath());
 
-    return document != nullptr;
+    return true;
 }
 
-bool DocumentView::refresh()
+void DocumentView::finishRefresh(bool success)
 {
-    auto document = PluginHandler::instance()->loadDocument(m_fileInfo.filePath());
+    Model::Document* document = nullptr;
+    QVector<Model::Page*> pages;
 
-    if(document != nullptr)
+    if(!success || !m_loader->take(document, pages))
     {
-        QVector<Model::Page*> pages;
+        emit refreshFinished(false);
 
-        if(!checkDocument(m_fileInfo.filePath(), document, pages))
-        {
-            delete document;
-            qDeleteAll(pages);
-
-            return false;
-        }
+        return;
+    }
 
-        qreal left = 0.0, top = 0.0;
-        saveLeftAndTop(left, top);
+    qreal left = 0.0, top = 0.0;
+    saveLeftAndTop(left, top);
 
-        m_wasModified = false;
+    m_wasModified = false;
 
-        m_currentPage = std::min(m_currentPage, document->numberOfPages());
+    m_currentPage = std::min(m_currentPage, document->numberOfPages());
 
-        QSet<QByteArray> expandedPaths;
-        ::saveExpandedPaths(m_outlineModel.data(), expandedPaths);
+    QSet<QByteArray> expandedPaths;
+    ::saveExpandedPaths(m_outlineModel.data(), expandedPaths);
 
-        prepareDocument(document, pages);
+    prepareDocument(document, pages);
 
-        ::restoreExpandedPaths(m_outlineModel.data(), expandedPaths);
+    ::restoreExpandedPaths(m_outlineModel.data(), expandedPaths);
 
-        prepareScene();
-        prepareView(left, top);
+    prepareScene();
+    prepareView(left, top);
 
-        prepareThumbnailsScene();
+    prepareThumbnailsScene();
 
-        emit documentChanged();
+    emit documentChanged();
 
-        emit numberOfPagesChanged(m_pages.count());
-        emit currentPageChanged(m_currentPage);
-    }
+    emit numberOfPagesChanged(m_pages.count());
+    emit currentPageChanged(m_currentPage);
 
-    return document != nullptr;
+    emit refreshFinished(true);
 }
 
 bool DocumentView::save(const QString& filePath, bool withChanges)
@@ -1625,6 +1866,13 @@ void DocumentView::lastPage()
 
 void DocumentView::jumpToPage(int page, bool trackChange, qreal newLeft, qreal newTop)
 {
+    if(m_document == nullptr && m_loader->isRunning())
+    {
+        m_deferredPage = page;
+
+        return;
+    }
+
     if(page >= 1 && page <= m_pages.count())
     {
         qreal left = 0.0, top = 0.0;
@@ -1784,7 +2032,7 @@ void DocumentView::zoomIn()
 {
     if(scaleMode() != ScaleFactorMode)
     {
-        const qreal currentScaleFactor = m_pageItems.at(m_currentPage - 1)->renderParam().scaleFactor();
+        const qreal currentScaleFactor = m_pageGeometries.at(m_currentPage - 1).renderParam.scaleFactor();
 
         setScaleFactor(std::min(currentScaleFactor * s_settings->documentView().zoomFactor(),
                                 s_settings->documentView().maximumScaleFactor()));
@@ -1802,7 +2050,7 @@ void DocumentView::zoomOut()
 {
     if(scaleMode() != ScaleFactorMode)
     {
-        const qreal currentScaleFactor = m_pageItems.at(m_currentPage - 1)->renderParam().scaleFactor();
+        const qreal currentScaleFactor = m_pageGeometries.at(m_currentPage - 1).renderParam.scaleFactor();
 
         setScaleFactor(std::max(currentScaleFactor / s_settings->documentView().zoomFactor(),
                                 s_settings->documentView().minimumScaleFactor()));
@@ -1866,7 +2114,7 @@ void DocumentView::startPresentation()
 {
     const int screenIndex = s_settings->presentationView().screen();
 
-    auto presentationView = new PresentationView(m_pages);
+    auto presentationView = new PresentationView(m_pages, m_documentId);
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,11,0)
     const QScreen *screen = QGuiApplication::screens().at(screenIndex > -1 ? screenIndex : 0);
@@ -1894,6 +2142,71 @@ void DocumentView::startPresentation()
     }
 }
 
+void DocumentView::onLoaderFinished(bool success)
+{
+    m_openingWidget->hide();
+
+    if(m_refreshing)
+    {
+        m_refreshing = false;
+
+        finishRefresh(success);
+
+        return;
+    }
+
+    const QString filePath = m_loader->filePath();
+
+    Model::Document* document = nullptr;
+    QVector<Model::Page*> pages;
+
+    if(!success || !m_loader->take(document, pages))
+    {
+        emit openFinished(false);
+
+        return;
+    }
+
+    m_fileInfo.setFile(filePath);
+    m_wasModified = false;
+
+    m_currentPage = 1;
+
+    m_past.clear();
+    m_future.clear();
+
+    prepareDocument(document, pages);
+
+    loadDocumentDefaults();
+
+    adjustScrollBarPolicy();
+
+    prepareScene();
+    prepareView();
+
+    prepareThumbnailsScene();
+
+    emit documentChanged();
+
+    emit numberOfPagesChanged(m_pages.count());
+    emit currentPageChanged(m_currentPage);
+
+    emit canJumpChanged(false, false);
+
+    emit continuousModeChanged(m_continuousMode);
+    emit layoutModeChanged(m_layout->layoutMode());
+    emit rightToLeftModeChanged(m_rightToLeftMode);
+
+    if(m_deferredPage != 0)
+    {
+        jumpToPage(m_deferredPage, false);
+
+        m_deferredPage = 0;
+    }
+
+    emit openFinished(true);
+}
+
 void DocumentView::onVerticalScrollBarValueChanged()
 {
     if(m_verticalScrollBarChangedBlocked || !m_continuousMode)
@@ -1903,23 +2216,37 @@ void DocumentView::onVerticalScrollBarValueChanged()
 
     int currentPage = -1;
     const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+    const QPair<int, int> visiblePages = m_layout->pageRange(visibleRect.top(), visibleRect.bottom());
 
-    for(int index = 0, count = m_pageItems.count(); index < count; ++index)
+    // Only the pages which were visible before can have just left the viewport.
+    for(int index = m_visiblePages.first; index <= m_visiblePages.second; ++index)
     {
-        PageItem* page = m_pageItems.at((m_currentPage - 1 + index) % count);
+        PageItem* page = m_pageItems.value(index);
 
-        const int pageNumber = page->index() + 1;
-        const QRectF pageRect = page->boundingRect().translated(page->pos());
-
-        if(!pageRect.intersects(visibleRect))
+        if(page != nullptr && !m_pageGeometries.at(index).sceneBoundingRect().intersects(visibleRect))
         {
             page->cancelRender();
         }
-        else if(currentPage == -1 &&
-                 m_layout->currentPage(pageNumber) == pageNumber &&
-                 m_layout->isCurrentPage(visibleRect, pageRect))
+    }
+
+    m_visiblePages = visiblePages;
+
+    // Starting from the current page keeps it as long as it qualifies.
+    const int first = visiblePages.first;
+    const int count = std::min(visiblePages.second, m_pageGeometries.count() - 1) - first + 1;
+    const int start = m_currentPage - 1 >= first && m_currentPage - 1 < first + count ? m_currentPage - 1 - first : 0;
+
+    for(int index = 0; index < count; ++index)
+    {
+        const int pageNumber = first + (start + index) % count + 1;
+        const QRectF pageRect = m_pageGeometries.at(pageNumber - 1).sceneBoundingRect();
+
+        if(pageRect.intersects(visibleRect) &&
+                m_layout->currentPage(pageNumber) == pageNumber &&
+                m_layout->isCurrentPage(visibleRect, pageRect))
         {
             currentPage = pageNumber;
+            break;
         }
     }
 
@@ -1931,9 +2258,9 @@ void DocumentView::onVerticalScrollBarValueChanged()
 
         if(s_settings->documentView().highlightCurrentThumbnail())
         {
-            for(int index = 0; index < m_thumbnailItems.count(); ++index)
+            for(auto page = m_thumbnailItems.constBegin(); page != m_thumbnailItems.constEnd(); ++page)
             {
-                m_thumbnailItems.at(index)->setHighlighted(index == m_currentPage - 1);
+                page.value()->setHighlighted(page.key() == m_currentPage - 1);
             }
         }
     }
@@ -1957,14 +2284,11 @@ void DocumentView::onPrefetchTimeout()
 {
     const QPair<int, int> prefetchRange = m_layout->prefetchRange(m_currentPage, m_pages.count());
 
-    const int maxCost = prefetchRange.second - prefetchRange.first + 1;
-    int cost = 0;
+    PrefetchBudget budget(s_settings->documentView().prefetchHorizon());
 
     for(int index = m_currentPage - 1; index <= prefetchRange.second - 1; ++index)
     {
-        cost += m_pageItems.at(index)->startRender(true);
-
-        if(cost >= maxCost)
+        if(!budget.prefetch(pageItem(index)))
         {
             return;
         }
@@ -1972,9 +2296,101 @@ void DocumentView::onPrefetchTimeout()
 
     for(int index = m_currentPage - 1; index >= prefetchRange.first - 1; --index)
     {
-        cost += m_pageItems.at(index)->startRender(true);
+        if(!budget.prefetch(pageItem(index)))
+        {
+            return;
+        }
+    }
+}
+
+void DocumentView::onScrollBarValueChanged()
+{
+    prepareVisiblePages();
+
+    if(!m_continuousMode || m_predictivePrefetchTimer->signalsBlocked())
+    {
+        return;
+    }
+
+    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
 
-        if(cost >= maxCost)
+    // Moving by more than two viewports at once is a jump rather than scrolling.
+    m_scrollPredictor.addSample(visibleRect.center(), 2.0 * (visibleRect.width() + visibleRect.height()));
+
+    if(!m_predictivePrefetchTimer->isActive())
+    {
+        m_predictivePrefetchTimer->start();
+    }
+}
+
+void DocumentView::onPredictivePrefetchTimeout()
+{
+    const QPointF velocity = m_scrollPredictor.velocity();
+
+    if(velocity.isNull() || m_pageGeometries.isEmpty())
+    {
+        return;
+    }
+
+    const int horizon = s_settings->documentView().prefetchHorizon();
+
+    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+    const QRectF sweptRect = m_scrollPredictor.sweptRect(visibleRect, horizon);
+
+    // Rows of pages are laid out from top to bottom, so they are walked from the current one
+    // in the direction of scrolling until a row is beyond the swept area.
+
+    const int count = m_pageGeometries.count();
+    const bool forward = velocity.y() >= 0.0;
+
+    QVector< int > indices;
+
+    for(int index = m_layout->leftIndex(m_currentPage - 1); index >= 0 && index < count;)
+    {
+        const int leftIndex = m_layout->leftIndex(index);
+        const int rightIndex = m_layout->rightIndex(index, count);
+
+        bool rowIntersects = false;
+
+        for(int pageIndex = leftIndex; pageIndex <= rightIndex; ++pageIndex)
+        {
+            const QRectF pageRect = m_pageGeometries.at(pageIndex).sceneBoundingRect();
+
+            if(pageRect.intersects(sweptRect))
+            {
+                rowIntersects = true;
+
+                if(!pageRect.intersects(visibleRect))
+                {
+                    indices.append(pageIndex);
+                }
+            }
+        }
+
+        if(!rowIntersects)
+        {
+            break;
+        }
+
+        index = forward ? rightIndex + 1 : leftIndex - 1;
+    }
+
+    // The pages which become visible first are prefetched first.
+    const QPointF center = visibleRect.center();
+
+    std::sort(indices.begin(), indices.end(), [this, &center, &velocity](int left, int right)
+    {
+        const QPointF leftCenter = m_pageGeometries.at(left).sceneBoundingRect().center();
+        const QPointF rightCenter = m_pageGeometries.at(right).sceneBoundingRect().center();
+
+        return QPointF::dotProduct(leftCenter - center, velocity) < QPointF::dotProduct(rightCenter - center, velocity);
+    });
+
+    PrefetchBudget budget(horizon);
+
+    foreach(int index, indices)
+    {
+        if(!budget.prefetch(pageItem(index)))
         {
             return;
         }
@@ -2004,8 +2420,15 @@ void DocumentView::onSearchTaskResultsReady(int index, const QList<QRectF>& resu
 
     if(m_highlightAll)
     {
-        m_pageItems.at(index)->setHighlights(results);
-        m_thumbnailItems.at(index)->setHighlights(results);
+        if(PageItem* page = m_pageItems.value(index))
+        {
+            page->setHighlights(results);
+        }
+
+        if(ThumbnailItem* page = m_thumbnailItems.value(index))
+        {
+            page->setHighlights(results);
+        }
     }
 
     if(s_settings->documentView().limitThumbnailsToResults())
@@ -2023,6 +2446,12 @@ void DocumentView::onSearchTaskResultsReady(int index, const QList<QRectF>& resu
 
 void DocumentView::onPagesCropRectChanged()
 {
+    // The crop rectangle is kept with the geometry, so that the layout does not change when the item is released.
+    if(auto page = qobject_cast<PageItem*>(sender()))
+    {
+        m_pageGeometries[page->index()].cropRect = page->cropRect();
+    }
+
     qreal left = 0.0, top = 0.0;
     saveLeftAndTop(left, top);
 
@@ -2032,6 +2461,11 @@ void DocumentView::onPagesCropRectChanged()
 
 void DocumentView::onThumbnailsCropRectChanged()
 {
+    if(auto page = qobject_cast<ThumbnailItem*>(sender()))
+    {
+        m_thumbnailGeometries[page->index()].cropRect = page->cropRect();
+    }
+
     prepareThumbnailsScene();
 }
 
@@ -2081,7 +2515,8 @@ void DocumentView::onPagesZoomToSelection(int page, const QRectF& rect)
     const qreal visibleWidth = m_layout->visibleWidth(viewport()->width());
     const qreal visibleHeight = m_layout->visibleHeight(viewport()->height());
 
-    const QSizeF displayedSize = m_pageItems.at(page - 1)->displayedSize();
+    const PageGeometry& geometry = m_pageGeometries.at(page - 1);
+    const QSizeF displayedSize = PageItem::displayedSize(geometry.size, geometry.cropRect, geometry.renderParam);
 
     setScaleFactor(std::min(std::min(visibleWidth / displayedSize.width() / rect.width(),
                                      visibleHeight / displayedSize.height() / rect.height()),
@@ -2117,9 +2552,32 @@ void DocumentView::onPagesWasModified()
 {
     m_wasModified = true;
 
+    m_documentId = uniqueDocumentIdentity();
+
+    foreach(PageItem* page, m_pageItems)
+    {
+        page->setDocumentId(m_documentId, isPersistentDocumentIdentity(m_documentId));
+    }
+
+    foreach(ThumbnailItem* page, m_thumbnailItems)
+    {
+        page->setDocumentId(m_documentId, isPersistentDocumentIdentity(m_documentId));
+    }
+
     emit documentModified();
 }
 
+void DocumentView::onReleaseItemsTimeout()
+{
+    const QRectF visibleRect = mapToScene(viewport()->rect()).boundingRect();
+
+    releaseItems(scene(), m_pageGeometries, adjustedByViewports(visibleRect, releaseMargin),
+                 m_pageItems, m_releasedPageItems);
+
+    releaseItems(m_thumbnailsScene, m_thumbnailGeometries, adjustedByViewports(m_thumbnailsVisibleRect, releaseMargin),
+                 m_thumbnailItems, m_releasedThumbnailItems);
+}
+
 void DocumentView::resizeEvent(QResizeEvent* event)
 {
     qreal left = 0.0, top = 0.0;
@@ -2127,6 +2585,8 @@ void DocumentView::resizeEvent(QResizeEvent* event)
 
     QGraphicsView::resizeEvent(event);
 
+    adjustOpeningWidget();
+
     if(m_scaleMode != ScaleFactorMode)
     {
         prepareScene();
@@ -2660,8 +3120,13 @@ bool DocumentView::printUsingQt(QPrinter* printer, const PrintOptions& printOpti
 
 void DocumentView::saveLeftAndTop(qreal& left, qreal& top) const
 {
-    const PageItem* page = m_pageItems.at(m_currentPage - 1);
-    const QRectF boundingRect = page->uncroppedBoundingRect().translated(page->pos());
+    if(m_currentPage < 1 || m_currentPage > m_pageGeometries.count())
+    {
+        return;
+    }
+
+    const PageGeometry& page = m_pageGeometries.at(m_currentPage - 1);
+    const QRectF boundingRect = PageItem::uncroppedBoundingRect(page.size, page.renderParam).translated(page.pos);
 
     const QPointF topLeft = mapToScene(viewport()->rect().topLeft());
 
@@ -2669,44 +3134,13 @@ void DocumentView::saveLeftAndTop(qreal& left, qreal& top) const
     top = (topLeft.y() - boundingRect.y()) / boundingRect.height();
 }
 
-bool DocumentView::checkDocument(const QString& filePath, Model::Document* document, QVector<Model::Page* >& pages)
+void DocumentView::adjustOpeningWidget()
 {
-    if(document->isLocked())
+    if(!m_openingWidget->isHidden())
     {
-        QString password = QInputDialog::getText(this, tr("Unlock %1").arg(QFileInfo(filePath).completeBaseName()), tr("Password:"), QLineEdit::Password);
-
-        if(document->unlock(password))
-        {
-            return false;
-        }
+        m_openingWidget->resize(m_openingWidget->sizeHint().expandedTo(QSize(qMin(viewport()->width() / 2, 400), 0)));
+        m_openingWidget->move(viewport()->rect().center() - m_openingWidget->rect().center());
     }
-
-    const int numberOfPages = document->numberOfPages();
-
-    if(numberOfPages == 0)
-    {
-        qWarning() << "No pages were found in document at" << filePath;
-
-        return false;
-    }
-
-    pages.reserve(numberOfPages);
-
-    for(int index = 0; index < numberOfPages; ++index)
-    {
-        Model::Page* page = document->page(index);
-
-        if(!page)
-        {
-            qWarning() << "No page" << index << "was found in document at" << filePath;
-
-            return false;
-        }
-
-        pages.append(page);
-    }
-
-    return true;
 }
 
 void DocumentView::loadDocumentDefaults()
@@ -2760,11 +3194,18 @@ void DocumentView::prepareDocument(Model::Document* document, const QVector<Mode
     m_prefetchTimer->blockSignals(true);
     m_prefetchTimer->stop();
 
+    m_predictivePrefetchTimer->blockSignals(true);
+    m_predictivePrefetchTimer->stop();
+
+    m_scrollPredictor.reset();
+
     cancelSearch();
     clearResults();
 
     qDeleteAll(m_pageItems);
+    qDeleteAll(m_releasedPageItems);
     qDeleteAll(m_thumbnailItems);
+    qDeleteAll(m_releasedThumbnailItems);
 
     qDeleteAll(m_pages);
     m_pages = pages;
@@ -2784,10 +3225,14 @@ void DocumentView::prepareDocument(Model::Document* document, const QVector<Mode
 
     m_document->setPaperColor(s_settings->pageItem().paperColor());
 
+    m_documentId = documentIdentity(m_fileInfo);
+
     preparePages();
     prepareThumbnails();
     prepareBackground();
 
+    m_idlePrerenderer->setPageCount(m_pages.count());
+
     const Model::Outline outline = m_document->outline();
 
     if(!outline.empty())
@@ -2809,22 +3254,71 @@ void DocumentView::prepareDocument(Model::Document* document, const QVector<Mode
     {
         m_prefetchTimer->blockSignals(false);
         m_prefetchTimer->start();
+
+        m_predictivePrefetchTimer->blockSignals(false);
     }
 }
 
 void DocumentView::preparePages()
 {
     m_pageItems.clear();
-    m_pageItems.reserve(m_pages.count());
+    m_releasedPageItems.clear();
 
-    for(int index = 0; index < m_pages.count(); ++index)
+    m_pageGeometries.clear();
+    m_pageGeometries.reserve(m_pages.count());
+
+    foreach(const Model::Page* page, m_pages)
+    {
+        m_pageGeometries.append(PageGeometry{page->size(), RenderParam(), QRectF(), QRectF(), QPointF(), true});
+    }
+}
+
+void DocumentView::prepareThumbnails()
+{
+    m_thumbnailItems.clear();
+    m_releasedThumbnailItems.clear();
+
+    m_thumbnailGeometries = m_pageGeometries;
+}
+
+bool DocumentView::isPrerendered(int index) const
+{
+    if(const PageItem* page = m_pageItems.value(index))
+    {
+        return page->isPrerendered();
+    }
+
+    const PageGeometry& geometry = m_pageGeometries.at(index);
+
+    return TileItem::isPreviewPrerendered(m_documentId, isPersistentDocumentIdentity(m_documentId), index,
+                                          geometry.renderParam, PageItem::uncroppedBoundingRect(geometry.size, geometry.renderParam));
+}
+
+bool DocumentView::cancelPrerender(int index)
+{
+    PageItem* page = m_pageItems.value(index);
+
+    // The item might have been released while its preview is prerendered.
+    if(page == nullptr)
     {
-        auto page = new PageItem(m_pages.at(index), index);
+        page = findReleasedItem(m_releasedPageItems, index);
+    }
+
+    return page != nullptr && page->cancelPrerender();
+}
 
-        page->setRubberBandMode(m_rubberBandMode);
+PageItem* DocumentView::pageItem(int index)
+{
+    if(PageItem* page = m_pageItems.value(index))
+    {
+        return page;
+    }
 
-        scene()->addItem(page);
-        m_pageItems.append(page);
+    PageItem* page = takeReleasedItem(m_releasedPageItems, index);
+
+    if(page == nullptr)
+    {
+        page = new PageItem(m_pages.at(index), index);
 
         connect(page, SIGNAL(cropRectChanged()), SLOT(onPagesCropRectChanged()));
 
@@ -2839,24 +3333,116 @@ void DocumentView::preparePages()
 
         connect(page, SIGNAL(wasModified()), SLOT(onPagesWasModified()));
     }
+
+    const PageGeometry& geometry = m_pageGeometries.at(index);
+
+    if(page->documentId() != m_documentId)
+    {
+        page->setDocumentId(m_documentId, isPersistentDocumentIdentity(m_documentId));
+    }
+
+    page->setRubberBandMode(m_rubberBandMode);
+    page->setHighlights(m_highlightAll ? s_searchModel->resultsOnPage(this, index + 1) : QList<QRectF>());
+
+    page->setRenderParam(geometry.renderParam);
+    page->setCropRect(geometry.cropRect);
+    page->setPos(geometry.pos);
+    page->setVisible(geometry.visible);
+
+    scene()->addItem(page);
+    m_pageItems.insert(index, page);
+
+    if(!m_releaseItemsTimer->isActive())
+    {
+        m_releaseItemsTimer->start();
+    }
+
+    return page;
 }
 
-void DocumentView::prepareThumbnails()
+ThumbnailItem* DocumentView::thumbnailItem(int index)
 {
-    m_thumbnailItems.clear();
-    m_thumbnailItems.reserve(m_pages.count());
-
-    for(int index = 0; index < m_pages.count(); ++index)
+    if(ThumbnailItem* page = m_thumbnailItems.value(index))
     {
-        auto page = new ThumbnailItem(m_pages.at(index), pageLabelFromNumber(index + 1), index);
+        return page;
+    }
 
-        m_thumbnailsScene->addItem(page);
-        m_thumbnailItems.append(page);
+    ThumbnailItem* page = takeReleasedItem(m_releasedThumbnailItems, index);
+
+    if(page == nullptr)
+    {
+        page = new ThumbnailItem(m_pages.at(index), pageLabelFromNumber(index + 1), index);
 
         connect(page, SIGNAL(cropRectChanged()), SLOT(onThumbnailsCropRectChanged()));
 
         connect(page, SIGNAL(linkClicked(bool,int,qreal,qreal)), SLOT(onPagesLinkClicked(bool,int,qreal,qreal)));
     }
+
+    const PageGeometry& geometry = m_thumbnailGeometries.at(index);
+
+    if(page->documentId() != m_documentId)
+    {
+        page->setDocumentId(m_documentId, isPersistentDocumentIdentity(m_documentId));
+    }
+
+    page->setText(pageLabelFromNumber(index + 1));
+    page->setHighlighted(s_settings->documentView().highlightCurrentThumbnail() && index == m_currentPage - 1);
+    page->setHighlights(m_highlightAll ? s_searchModel->resultsOnPage(this, index + 1) : QList<QRectF>());
+
+    page->setRenderParam(geometry.renderParam);
+    page->setCropRect(geometry.cropRect);
+    page->setPos(geometry.pos);
+    page->setVisible(geometry.visible);
+
+    m_thumbnailsScene->addItem(page);
+    m_thumbnailItems.insert(index, page);
+
+    if(!m_releaseItemsTimer->isActive())
+    {
+        m_releaseItemsTimer->start();
+    }
+
+    return page;
+}
+
+void DocumentView::prepareVisiblePages()
+{
+    const QRectF preparedRect = adjustedByViewports(mapToScene(viewport()->rect()).boundingRect(), prepareMargin);
+    const QPair<int, int> preparedPages = m_layout->pageRange(preparedRect.top(), preparedRect.bottom());
+
+    // The layout can lag behind the geometries while a document is being prepared.
+    for(int index = preparedPages.first; index <= std::min(preparedPages.second, m_pageGeometries.count() - 1); ++index)
+    {
+        const PageGeometry& page = m_pageGeometries.at(index);
+
+        if(page.visible && page.sceneBoundingRect().intersects(preparedRect))
+        {
+            pageItem(index);
+        }
+    }
+}
+
+void DocumentView::prepareVisibleThumbnails()
+{
+    if(m_thumbnailsVisibleRect.isEmpty())
+    {
+        return;
+    }
+
+    const QRectF preparedRect = adjustedByViewports(m_thumbnailsVisibleRect, prepareMargin);
+    const QPair<int, int> preparedThumbnails = m_thumbnailsOrientation == Qt::Vertical
+            ? m_thumbnailsIndex.range(preparedRect.top(), preparedRect.bottom())
+            : m_thumbnailsIndex.range(preparedRect.left(), preparedRect.right());
+
+    for(int index = preparedThumbnails.first; index <= std::min(preparedThumbnails.second, m_thumbnailGeometries.count() - 1); ++index)
+    {
+        const PageGeometry& page = m_thumbnailGeometries.at(index);
+
+        if(page.visible && page.sceneBoundingRect().intersects(preparedRect))
+        {
+            thumbnailItem(index);
+        }
+    }
 }
 
 void DocumentView::prepareBackground()
@@ -2908,9 +3494,15 @@ void DocumentView::prepareScene()
     const qreal visibleWidth = m_layout->visibleWidth(viewport()->width());
     const qreal visibleHeight = m_layout->visibleHeight(viewport()->height());
 
-    for(auto page : m_pageItems)
+    for(auto page = m_pageGeometries.begin(); page != m_pageGeometries.end(); ++page)
     {
-        const QSizeF displayedSize = page->displayedSize(renderParam);
+        // As with the items, the crop rectangle does not survive changes of rotation or render flags.
+        if(page->renderParam.rotation() != renderParam.rotation() || page->renderParam.flags() != renderParam.flags())
+        {
+            page->cropRect = QRectF();
+        }
+
+        const QSizeF displayedSize = PageItem::displayedSize(page->size, page->cropRect, renderParam);
 
         if(m_scaleMode == FitToPageWidthMode)
         {
@@ -2921,7 +3513,8 @@ void DocumentView::prepareScene()
             adjustScaleFactor(renderParam, std::min(visibleWidth / displayedSize.width(), visibleHeight / displayedSize.height()));
         }
 
-        page->setRenderParam(renderParam);
+        page->renderParam = renderParam;
+        page->boundingRect = PageItem::croppedBoundingRect(PageItem::uncroppedBoundingRect(page->size, renderParam), page->cropRect);
     }
 
     // prepare layout
@@ -2930,10 +3523,18 @@ void DocumentView::prepareScene()
     qreal right = 0.0;
     qreal height = s_settings->documentView().pageSpacing();
 
-    m_layout->prepareLayout(m_pageItems, m_rightToLeftMode,
+    m_layout->prepareLayout(m_pageGeometries, m_rightToLeftMode,
                             left, right, height);
 
     scene()->setSceneRect(left, 0.0, right - left, height);
+
+    for(auto page = m_pageItems.constBegin(); page != m_pageItems.constEnd(); ++page)
+    {
+        const PageGeometry& geometry = m_pageGeometries.at(page.key());
+
+        page.value()->setRenderParam(geometry.renderParam);
+        page.value()->setPos(geometry.pos);
+    }
 }
 
 void DocumentView::prepareView(qreal newLeft, qreal newTop, bool forceScroll, int scrollToPage)
@@ -2951,50 +3552,54 @@ void DocumentView::prepareView(qreal newLeft, qreal newTop, bool forceScroll, in
     const int highlightIsOnPage = m_currentResult.isValid() ? pageOfResult(m_currentResult) : 0;
     const bool highlightCurrentThumbnail = s_settings->documentView().highlightCurrentThumbnail();
 
-    for(int index = 0; index < m_pageItems.count(); ++index)
+    for(int index = 0; index < m_pageGeometries.count(); ++index)
     {
-        PageItem* page = m_pageItems.at(index);
+        PageGeometry& page = m_pageGeometries[index];
 
-        if(m_continuousMode)
-        {
-            page->setVisible(true);
-        }
-        else
-        {
-            if(m_layout->leftIndex(index) == m_currentPage - 1)
-            {
-                page->setVisible(true);
-
-                const QRectF boundingRect = page->boundingRect().translated(page->pos());
+        page.visible = m_continuousMode || m_layout->leftIndex(index) == m_currentPage - 1;
 
-                top = boundingRect.top() - s_settings->documentView().pageSpacing();
-                height = boundingRect.height() + 2.0 * s_settings->documentView().pageSpacing();
-            }
-            else
-            {
-                page->setVisible(false);
+        if(!m_continuousMode && page.visible)
+        {
+            const QRectF boundingRect = page.sceneBoundingRect();
 
-                page->cancelRender();
-            }
+            top = boundingRect.top() - s_settings->documentView().pageSpacing();
+            height = boundingRect.height() + 2.0 * s_settings->documentView().pageSpacing();
         }
 
         if(index == scrollToPage - 1)
         {
-            const QRectF boundingRect = page->uncroppedBoundingRect().translated(page->pos());
+            const QRectF boundingRect = PageItem::uncroppedBoundingRect(page.size, page.renderParam).translated(page.pos);
 
             horizontalValue = qFloor(boundingRect.left() + newLeft * boundingRect.width());
             verticalValue = qFloor(boundingRect.top() + newTop * boundingRect.height());
         }
+    }
 
-        if(index == highlightIsOnPage - 1)
-        {
-            m_highlight->setPos(page->pos());
-            m_highlight->setTransform(page->transform());
+    for(auto page = m_pageItems.constBegin(); page != m_pageItems.constEnd(); ++page)
+    {
+        const bool visible = m_pageGeometries.at(page.key()).visible;
+
+        page.value()->setVisible(visible);
 
-            page->stackBefore(m_highlight);
+        if(!visible)
+        {
+            page.value()->cancelRender();
         }
+    }
 
-        m_thumbnailItems.at(index)->setHighlighted(highlightCurrentThumbnail && (index == m_currentPage - 1));
+    if(highlightIsOnPage > 0)
+    {
+        PageItem* page = pageItem(highlightIsOnPage - 1);
+
+        m_highlight->setPos(page->pos());
+        m_highlight->setTransform(page->transform());
+
+        page->stackBefore(m_highlight);
+    }
+
+    for(auto page = m_thumbnailItems.constBegin(); page != m_thumbnailItems.constEnd(); ++page)
+    {
+        page.value()->setHighlighted(highlightCurrentThumbnail && (page.key() == m_currentPage - 1));
     }
 
     setSceneRect(sceneRect.left(), top, sceneRect.width(), height);
@@ -3010,6 +3615,8 @@ void DocumentView::prepareView(qreal newLeft, qreal newTop, bool forceScroll, in
         verticalScrollBar()->setValue(verticalValue);
     }
 
+    prepareVisiblePages();
+
     viewport()->update();
 }
 
@@ -3049,9 +3656,16 @@ void DocumentView::prepareThumbnailsScene()
         visibleHeight = m_thumbnailsViewportSize.height() - 3.0 * thumbnailSpacing;
     }
 
-    for(auto page : m_thumbnailItems)
+    const qreal textHeight = ThumbnailItem::textHeight(pageLabelFromNumber(1));
+
+    for(auto page = m_thumbnailGeometries.begin(); page != m_thumbnailGeometries.end(); ++page)
     {
-        const QSizeF displayedSize = page->displayedSize(renderParam);
+        if(page->renderParam.rotation() != renderParam.rotation() || page->renderParam.flags() != renderParam.flags())
+        {
+            page->cropRect = QRectF();
+        }
+
+        const QSizeF displayedSize = PageItem::displayedSize(page->size, page->cropRect, renderParam);
 
         if(thumbnailSize != 0.0)
         {
@@ -3065,11 +3679,13 @@ void DocumentView::prepareThumbnailsScene()
             }
             else
             {
-                adjustScaleFactor(renderParam, (visibleHeight - page->textHeight()) / displayedSize.height());
+                adjustScaleFactor(renderParam, (visibleHeight - textHeight) / displayedSize.height());
             }
         }
 
-        page->setRenderParam(renderParam);
+        page->renderParam = renderParam;
+        page->boundingRect = PageItem::croppedBoundingRect(PageItem::uncroppedBoundingRect(page->size, renderParam), page->cropRect)
+                .adjusted(0.0, 0.0, 0.0, textHeight);
     }
 
     // prepare layout
@@ -3081,30 +3697,31 @@ void DocumentView::prepareThumbnailsScene()
 
     const bool limitThumbnailsToResults = s_settings->documentView().limitThumbnailsToResults();
 
-    for(int index = 0; index < m_thumbnailItems.count(); ++index)
+    m_thumbnailsIndex.clear();
+    m_thumbnailsIndex.reserve(m_thumbnailGeometries.count());
+
+    for(int index = 0; index < m_thumbnailGeometries.count(); ++index)
     {
-        ThumbnailItem* page = m_thumbnailItems.at(index);
+        PageGeometry& page = m_thumbnailGeometries[index];
 
         // prepare visibility
 
-        if(limitThumbnailsToResults && s_searchModel->hasResults(this) && !s_searchModel->hasResultsOnPage(this, index + 1))
-        {
-            page->setVisible(false);
-
-            page->cancelRender();
+        page.visible = !limitThumbnailsToResults || !s_searchModel->hasResults(this) || s_searchModel->hasResultsOnPage(this, index + 1);
 
+        if(!page.visible)
+        {
             continue;
         }
 
-        page->setVisible(true);
-
         // prepare position
 
-        const QRectF boundingRect = page->boundingRect();
+        const QRectF& boundingRect = page.boundingRect;
 
         if(m_thumbnailsOrientation == Qt::Vertical)
         {
-            page->setPos(-boundingRect.left() - 0.5 * boundingRect.width(), bottom - boundingRect.top());
+            page.pos = QPointF(-boundingRect.left() - 0.5 * boundingRect.width(), bottom - boundingRect.top());
+
+            m_thumbnailsIndex.append(index, index, bottom, bottom + boundingRect.height());
 
             left = std::min(left, -0.5f * boundingRect.width() - thumbnailSpacing);
             right = std::max(right, 0.5f * boundingRect.width() + thumbnailSpacing);
@@ -3112,7 +3729,9 @@ void DocumentView::prepareThumbnailsScene()
         }
         else
         {
-            page->setPos(right - boundingRect.left(), -boundingRect.top() - 0.5 * boundingRect.height());
+            page.pos = QPointF(right - boundingRect.left(), -boundingRect.top() - 0.5 * boundingRect.height());
+
+            m_thumbnailsIndex.append(index, index, right, right + boundingRect.width());
 
             top = std::min(top, -0.5f * boundingRect.height() - thumbnailSpacing);
             bottom = std::max(bottom, 0.5f * boundingRect.height() + thumbnailSpacing);
@@ -3121,11 +3740,27 @@ void DocumentView::prepareThumbnailsScene()
     }
 
     m_thumbnailsScene->setSceneRect(left, top, right - left, bottom - top);
+
+    for(auto page = m_thumbnailItems.constBegin(); page != m_thumbnailItems.constEnd(); ++page)
+    {
+        const PageGeometry& geometry = m_thumbnailGeometries.at(page.key());
+
+        page.value()->setRenderParam(geometry.renderParam);
+        page.value()->setPos(geometry.pos);
+        page.value()->setVisible(geometry.visible);
+
+        if(!geometry.visible)
+        {
+            page.value()->cancelRender();
+        }
+    }
+
+    prepareVisibleThumbnails();
 }
 
 void DocumentView::prepareHighlight(int index, const QRectF& rect)
 {
-    PageItem* page = m_pageItems.at(index);
+    PageItem* page = pageItem(index);
 
     m_highlight->setPos(page->pos());
     m_highlight->setTransform(page->transform());
@@ -3144,6 +3779,8 @@ void DocumentView::prepareHighlight(int index, const QRectF& rect)
         centerOn(m_highlight);
     }
 
+    prepareVisiblePages();
+
     viewport()->update();
 }
 
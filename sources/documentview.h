@@ -27,15 +27,20 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QFileInfo>
 #include <QGraphicsView>
+#include <QHash>
 #include <QMap>
 #include <QPersistentModelIndex>
 
 class QDomNode;
 class QFileSystemWatcher;
+class QLabel;
 class QPrinter;
+class QProgressBar;
 
 #include "renderparam.h"
 #include "printoptions.h"
+#include "documentlayout.h"
+#include "scrollpredictor.h"
 
 namespace qpdfview
 {
@@ -54,7 +59,8 @@ class SearchModel;
 class SearchTask;
 class PresentationView;
 class ShortcutHandler;
-struct DocumentLayout;
+class IdlePrerenderer;
+class DocumentLoader;
 
 class DocumentView : public QGraphicsView
 {
@@ -69,6 +75,11 @@ public:
     DECL_NODISCARD
     bool wasModified() const { return m_wasModified; }
 
+    DECL_NODISCARD
+    bool hasDocument() const { return m_document != nullptr; }
+    DECL_NODISCARD
+    bool isOpening() const;
+
     DECL_NODISCARD
     int numberOfPages() const { return m_pages.count(); }
     DECL_NODISCARD
@@ -161,11 +172,26 @@ public:
     Qt::Orientation thumbnailsOrientation() const { return m_thumbnailsOrientation; }
     void setThumbnailsOrientation(Qt::Orientation thumbnailsOrientation);
 
-    DECL_NODISCARD
-    const QVector<qpdfview::ThumbnailItem*>& thumbnailItems() const { return m_thumbnailItems; }
     DECL_NODISCARD
     QGraphicsScene* thumbnailsScene() const { return m_thumbnailsScene; }
 
+    // Thumbnails are only created near the visible part of the thumbnails scene.
+    DECL_UNUSED
+    DECL_NODISCARD
+    const QRectF& thumbnailsVisibleRect() const { return m_thumbnailsVisibleRect; }
+    void setThumbnailsVisibleRect(const QRectF& thumbnailsVisibleRect);
+
+    DECL_NODISCARD
+    QRectF thumbnailRect(int index) const { return m_thumbnailGeometries.value(index).sceneBoundingRect(); }
+
+    // Page items are only created near the viewport, so this creates the item if necessary.
+    PageItem* pageItem(int index);
+    // true if the preview of the page is ready, which does not create its item
+    DECL_NODISCARD
+    bool isPrerendered(int index) const;
+    // Cancels the prerender of the page if it is still in progress, which does not create its item either.
+    bool cancelPrerender(int index);
+
     DECL_NODISCARD
     QAbstractItemModel* outlineModel() const { return m_outlineModel.data(); }
     DECL_NODISCARD
@@ -246,10 +272,20 @@ signals:
     void searchFinished();
     void searchProgressChanged(int progress);
 
+    void openFinished(bool success);
+    void openCanceled();
+
+    void refreshFinished(bool success);
+
 public slots:
     void show();
 
-    bool open(const QString& filePath);
+    // Loads the document in the background and shows it when it is ready, the current document is kept until then.
+    void open(const QString& filePath);
+    void cancelOpen();
+
+    // Reloads the document in the background and keeps showing the current one until then.
+    // This returns false without doing anything while another document is being opened.
     bool refresh();
     bool save(const QString& filePath, bool withChanges);
     bool print(QPrinter* printer, const qpdfview::PrintOptions& printOptions = PrintOptions());
@@ -298,11 +334,16 @@ public slots:
     void startPresentation();
 
 protected slots:
+    void onLoaderFinished(bool success);
+
     void onVerticalScrollBarValueChanged();
 
     void onAutoRefreshTimeout();
     void onPrefetchTimeout();
 
+    void onScrollBarValueChanged();
+    void onPredictivePrefetchTimeout();
+
     void onTemporaryHighlightTimeout();
 
     void onSearchTaskProgressChanged(int progress);
@@ -324,6 +365,8 @@ protected slots:
 
     void onPagesWasModified();
 
+    void onReleaseItemsTimeout();
+
 protected:
     void resizeEvent(QResizeEvent* event) override;
 
@@ -344,10 +387,32 @@ private:
 
     QTimer* m_prefetchTimer;
 
+    QTimer* m_predictivePrefetchTimer;
+    ScrollPredictor m_scrollPredictor;
+
+    IdlePrerenderer* m_idlePrerenderer;
+
+    DocumentLoader* m_loader;
+
+    QWidget* m_openingWidget;
+    QLabel* m_openingLabel;
+    QProgressBar* m_openingProgressBar;
+
+    void adjustOpeningWidget();
+
+    // a page to jump to once the document which is being opened is shown
+    int m_deferredPage;
+
+    // whether the loader reloads the current document instead of opening another one
+    bool m_refreshing;
+
+    void finishRefresh(bool success);
+
     Model::Document* m_document;
     QVector<Model::Page*> m_pages;
 
     QFileInfo m_fileInfo;
+    QByteArray m_documentId;
     bool m_wasModified;
 
     int m_currentPage;
@@ -389,8 +454,30 @@ private:
     bool m_highlightAll;
     RubberBandMode m_rubberBandMode;
 
-    QVector<PageItem*> m_pageItems;
-    QVector<ThumbnailItem*> m_thumbnailItems;
+    // The geometry of all pages is kept, but items only exist for the pages near the viewport.
+    // Items which moved far away are kept for a while in case they come back before they are destroyed.
+
+    QVector<PageGeometry> m_pageGeometries;
+    QHash<int, PageItem*> m_pageItems;
+    QList<PageItem*> m_releasedPageItems;
+
+    // the pages which intersected the viewport when it last moved
+    QPair<int, int> m_visiblePages;
+
+    QVector<PageGeometry> m_thumbnailGeometries;
+    QHash<int, ThumbnailItem*> m_thumbnailItems;
+    QList<ThumbnailItem*> m_releasedThumbnailItems;
+
+    OffsetIndex m_thumbnailsIndex;
+
+    QRectF m_thumbnailsVisibleRect;
+
+    QTimer* m_releaseItemsTimer;
+
+    ThumbnailItem* thumbnailItem(int index);
+
+    void prepareVisiblePages();
+    void prepareVisibleThumbnails();
 
     QGraphicsRectItem* m_highlight;
 
@@ -402,7 +489,6 @@ private:
     QScopedPointer<QAbstractItemModel> m_outlineModel;
     QScopedPointer<QAbstractItemModel> m_propertiesModel;
 
-    bool checkDocument(const QString& filePath, Model::Document* document, QVector<Model::Page*>& pages);
 
     void loadDocumentDefaults();
 
@@ -44,9 +44,13 @@ extern "C"
 #include <mupdf/fitz/structured-text.h>
 
 typedef struct pdf_document_s pdf_document;
+typedef struct pdf_obj_s pdf_obj;
 
 pdf_document* pdf_specifics(fz_context*, fz_document*);
 
+pdf_obj* pdf_lookup_page_obj(fz_context*, pdf_document*, int);
+void pdf_page_obj_transform(fz_context*, pdf_obj*, fz_rect*, fz_matrix*);
+
 }
 
 std::string getData(const QVariant& value)
@@ -189,7 +193,7 @@ QSizeF FitzPage::size() const
     return {m_boundingRect.x1 - m_boundingRect.x0, m_boundingRect.y1 - m_boundingRect.y0};
 }
 
-QImage FitzPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const
+QImage FitzPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const
 {
     float hRes {static_cast<float>(horizontalResolution)};
     float vRes {static_cast<float>(verticalResolution)};
@@ -278,11 +282,34 @@ QImage FitzPage::render(qreal horizontalResolution, qreal verticalResolution, Ro
 
     auto pixmap = fz_new_pixmap_with_data(context, fz_device_bgr(context), image.width(), image.height(), nullptr, 1, image.bytesPerLine(), image.bits());
 
+    fz_cookie cookie {};
+
+    if(cancellation != nullptr)
+    {
+        cancellation->bindAbortFlag(&cookie.abort);
+    }
+
+    if(!antialiasing)
+    {
+        // The cloned context keeps its own antialiasing level.
+        fz_set_aa_level(context, 0);
+    }
+
     fz_device* device = fz_new_draw_device(context, tileMatrix, pixmap);
-    fz_run_display_list(context, display_list, device, fz_identity, tileRect, nullptr);
+    fz_run_display_list(context, display_list, device, fz_identity, tileRect, &cookie);
     fz_close_device(context, device);
     fz_drop_device(context, device);
 
+    if(cancellation != nullptr)
+    {
+        cancellation->bindAbortFlag(nullptr);
+    }
+
+    if(cookie.abort != 0)
+    {
+        image = QImage();
+    }
+
     fz_drop_pixmap(context, pixmap);
     fz_drop_context(context);
 
@@ -448,6 +475,47 @@ Page* FitzDocument::page(int index) const
     return nullptr;
 }
 
+QVector< QSizeF > FitzDocument::pageSizes() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    pdf_document* document = pdf_specifics(m_context, m_document);
+
+    if(document == nullptr)
+    {
+        mutexLocker.unlock();
+
+        return Document::pageSizes();
+    }
+
+    // The page tree of a PDF document yields the bounds of the pages without loading their contents.
+
+    const int numberOfPages = fz_count_pages(m_context, m_document);
+
+    QVector< QSizeF > sizes(numberOfPages);
+
+    for(int index = 0; index < numberOfPages; ++index)
+    {
+        fz_rect mediaBox;
+        fz_matrix transform;
+
+        fz_try(m_context)
+        {
+            pdf_page_obj_transform(m_context, pdf_lookup_page_obj(m_context, document, index), &mediaBox, &transform);
+
+            const fz_rect rect = fz_transform_rect(mediaBox, transform);
+
+            sizes[index] = QSizeF(rect.x1 - rect.x0, rect.y1 - rect.y0);
+        }
+        fz_catch(m_context)
+        {
+            // The size stays invalid and the page is reported as missing.
+        }
+    }
+
+    return sizes;
+}
+
 bool FitzDocument::canBePrintedUsingCUPS() const
 {
     QMutexLocker mutexLocker(&m_mutex);
@@ -557,6 +625,9 @@ FitzPlugin::~FitzPlugin()
 
 Model::Document* FitzPlugin::loadDocument(const QString& filePath) const
 {
+    // A separate settings object is used as documents are loaded by several threads at once.
+    const QSettings settings(m_settings->organizationName(), m_settings->applicationName());
+
     fz_context* context = fz_clone_context(m_context);
 
     if(context == nullptr)
@@ -581,13 +652,13 @@ Model::Document* FitzPlugin::loadDocument(const QString& filePath) const
         return nullptr;
     }
 
-    auto defaultFontStandard = getData(m_settings->value("defaultFontStandard", Defaults::defaultFontStandard));
+    auto defaultFontStandard = getData(settings.value("defaultFontStandard", Defaults::defaultFontStandard));
 
-	auto horizontalMargin = getData(m_settings->value("horizontalMargin", Defaults::horizontalMargin));
-	auto verticalMargin = getData(m_settings->value("verticalMargin", Defaults::verticalMargin));
+	auto horizontalMargin = getData(settings.value("horizontalMargin", Defaults::horizontalMargin));
+	auto verticalMargin = getData(settings.value("verticalMargin", Defaults::verticalMargin));
 
-	auto defaultFontSize = getData(m_settings->value("defaultFontSize", Defaults::fontSize));
-	auto monoFontSize = getData(m_settings->value("monospaceFontSize", Defaults::monospaceFontSize));
+	auto defaultFontSize = getData(settings.value("defaultFontSize", Defaults::fontSize));
+	auto monoFontSize = getData(settings.value("monospaceFontSize", Defaults::monospaceFontSize));
 
 	auto data = join(fontStyleSheet,
 	                 verticalMargin.data(), horizontalMargin.data(),
@@ -60,7 +60,10 @@ namespace Model
         QSizeF size() const final;
 
         DECL_NODISCARD
-        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const final;
+        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const final;
+
+        DECL_NODISCARD
+        QString backendName() const final { return QStringLiteral("MuPDF"); }
 
         DECL_NODISCARD
         QList< Link* > links() const final;
@@ -100,6 +103,9 @@ namespace Model
         DECL_NODISCARD
         Page* page(int index) const final;
 
+        DECL_NODISCARD
+        QVector< QSizeF > pageSizes() const final;
+
         DECL_NODISCARD
         bool canBePrintedUsingCUPS() const final;
 
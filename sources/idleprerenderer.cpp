@@ -0,0 +1,208 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "idleprerenderer.h"
+
+#include <QApplication>
+#include <QEvent>
+#include <QTimer>
+#include <qmath.h>
+
+#include "documentview.h"
+#include "pageitem.h"
+#include "settings.h"
+
+namespace qpdfview
+{
+
+namespace
+{
+
+// how long the application has to be without user input before prerendering starts in milliseconds
+const int idleDelay = 1000;
+
+// the render time assumed in milliseconds while the throughput of the backend is unknown
+const qreal defaultRenderTime = 50.0;
+
+// Pages which need no prerendering are skipped in batches, so that the event loop is not blocked.
+const int maximumSkippedPages = 64;
+
+inline bool isUserInput(const QEvent* event)
+{
+    switch(event->type())
+    {
+    case QEvent::KeyPress:
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonDblClick:
+    case QEvent::Wheel:
+    case QEvent::TouchBegin:
+    case QEvent::TabletPress:
+        return true;
+    default:
+        return false;
+    }
+}
+
+} // anonymous
+
+Settings* IdlePrerenderer::s_settings = nullptr;
+
+IdlePrerenderer::IdlePrerenderer(DocumentView* view) : QObject(view),
+    m_view(view),
+    m_timer(nullptr),
+    m_pageCount(0),
+    m_currentIndex(0),
+    m_step(0),
+    m_prerenderingIndex(-1),
+    m_prerenderingStep(0)
+{
+    if(s_settings == nullptr)
+    {
+        s_settings = Settings::instance();
+    }
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+
+    connect(m_timer, SIGNAL(timeout()), SLOT(onTimeout()));
+
+    qApp->installEventFilter(this);
+}
+
+IdlePrerenderer::~IdlePrerenderer()
+{
+    qApp->removeEventFilter(this);
+}
+
+void IdlePrerenderer::setPageCount(int pageCount)
+{
+    m_pageCount = pageCount;
+    m_currentIndex = 0;
+
+    restart();
+}
+
+void IdlePrerenderer::setCurrentPage(int currentPage)
+{
+    m_currentIndex = currentPage - 1;
+
+    restart();
+}
+
+void IdlePrerenderer::restart()
+{
+    m_step = 0;
+    m_prerenderingIndex = -1;
+
+    if(!s_settings->pageItem().idlePrerendering() || m_pageCount == 0)
+    {
+        m_timer->stop();
+
+        return;
+    }
+
+    m_timer->start(idleDelay);
+}
+
+bool IdlePrerenderer::eventFilter(QObject* object, QEvent* event)
+{
+    if(isUserInput(event))
+    {
+        // User input pauses prerendering until the application is idle again
+        // and the render thread is freed by canceling a prerender which is still in progress.
+        if(m_prerenderingIndex >= 0 && m_view->cancelPrerender(m_prerenderingIndex))
+        {
+            // The page is visited again once prerendering resumes.
+            m_step = m_prerenderingStep;
+
+            m_timer->start(idleDelay);
+        }
+        else if(!isDone() && m_timer->isActive())
+        {
+            m_timer->start(idleDelay);
+        }
+
+        m_prerenderingIndex = -1;
+    }
+
+    return QObject::eventFilter(object, event);
+}
+
+void IdlePrerenderer::onTimeout()
+{
+    if(!m_view->isVisible())
+    {
+        m_timer->start(idleDelay);
+
+        return;
+    }
+
+    for(int skipped = 0; skipped < maximumSkippedPages && !isDone(); ++skipped)
+    {
+        const int index = nextIndex();
+
+        if(index < 0 || m_view->isPrerendered(index))
+        {
+            continue;
+        }
+
+        // Items of pages far from the viewport are only created for the render and released again later.
+        PageItem* page = m_view->pageItem(index);
+
+        if(!page->startPrerender())
+        {
+            continue;
+        }
+
+        m_prerenderingIndex = index;
+        m_prerenderingStep = m_step - 1;
+
+        const qreal renderTime = page->estimatedPrerenderTime();
+        const int share = qBound(1, s_settings->pageItem().idlePrerenderingShare(), 100);
+
+        // The render thread is left to others for the rest of the time.
+        m_timer->start(qCeil((renderTime > 0.0 ? renderTime : defaultRenderTime) * 100 / share));
+
+        return;
+    }
+
+    if(!isDone())
+    {
+        m_timer->start(0);
+    }
+}
+
+bool IdlePrerenderer::isDone() const
+{
+    return m_step > 2 * m_pageCount;
+}
+
+int IdlePrerenderer::nextIndex()
+{
+    // The steps visit the current page and then alternately the following and preceding ones.
+    const int step = m_step++;
+    const int offset = step % 2 != 0 ? (step + 1) / 2 : -(step / 2);
+    const int index = m_currentIndex + offset;
+
+    return index >= 0 && index < m_pageCount ? index : -1;
+}
+
+} // qpdfview
@@ -0,0 +1,82 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef IDLEPRERENDERER_H
+#define IDLEPRERENDERER_H
+
+#include <QObject>
+
+class QTimer;
+
+namespace qpdfview
+{
+
+class Settings;
+class DocumentView;
+
+// Walks the pages of a document outwards from the current one and prerenders their low-resolution previews
+// while the application is idle, so that jumping to any page shows at least its preview at once.
+// Any user input pauses it and it keeps to a share of the time of one render thread.
+class IdlePrerenderer : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit IdlePrerenderer(DocumentView* view);
+    ~IdlePrerenderer() override;
+
+    void setPageCount(int pageCount);
+
+public slots:
+    void setCurrentPage(int currentPage);
+    void restart();
+
+protected:
+    bool eventFilter(QObject* object, QEvent* event) override;
+
+protected slots:
+    void onTimeout();
+
+private:
+    Q_DISABLE_COPY(IdlePrerenderer)
+
+    static Settings* s_settings;
+
+    DocumentView* m_view;
+    QTimer* m_timer;
+
+    int m_pageCount;
+
+    int m_currentIndex;
+    int m_step;
+
+    // the page which was prerendered last and the step which visited it
+    int m_prerenderingIndex;
+    int m_prerenderingStep;
+
+    bool isDone() const;
+    int nextIndex();
+
+};
+
+} // qpdfview
+
+#endif // IDLEPRERENDERER_H
@@ -59,8 +59,10 @@ QSizeF ImagePage::size() const
             m_image.height() * 72.0 / dotsPerInchY(m_image)};
 }
 
-QImage ImagePage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const
+QImage ImagePage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const
 {
+    Q_UNUSED(cancellation)
+
     QTransform transform;
 
     transform.scale(horizontalResolution / dotsPerInchX(m_image),
@@ -82,7 +84,7 @@ QImage ImagePage::render(qreal horizontalResolution, qreal verticalResolution, R
         break;
     }
 
-    QImage image = m_image.transformed(transform, Qt::SmoothTransformation);
+    QImage image = m_image.transformed(transform, antialiasing ? Qt::SmoothTransformation : Qt::FastTransformation);
 
     if(!boundingRect.isNull())
     {
@@ -107,6 +109,11 @@ Page* ImageDocument::page(int index) const
     return index == 0 ? new ImagePage(m_image) : nullptr;
 }
 
+QVector< QSizeF > ImageDocument::pageSizes() const
+{
+    return QVector< QSizeF >() << ImagePage(m_image).size();
+}
+
 QStringList ImageDocument::saveFilter() const
 {
     QStringList formats;
@@ -42,7 +42,10 @@ namespace Model
         QSizeF size() const final;
 
         DECL_NODISCARD
-        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const final;
+        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const final;
+
+        DECL_NODISCARD
+        QString backendName() const final { return QStringLiteral("Qt"); }
 
     private:
         Q_DISABLE_COPY(ImagePage)
@@ -66,6 +69,9 @@ namespace Model
         DECL_NODISCARD
         Page* page(int index) const final;
 
+        DECL_NODISCARD
+        QVector< QSizeF > pageSizes() const final;
+
         DECL_NODISCARD
         QStringList saveFilter() const final;
 
@@ -0,0 +1,455 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "lazypage.h"
+
+#include <QImage>
+#include <QMutex>
+#include <QWaitCondition>
+
+namespace qpdfview
+{
+
+namespace Model
+{
+
+class LazyPage::Pool
+{
+public:
+    Pool(const Document* document, int openPageCount) :
+        m_document(document),
+        m_openPageCount(qMax(1, openPageCount)),
+        m_mutex(),
+        m_loaded(),
+        m_openPages(),
+        m_clock(0),
+        m_backendName()
+    {
+    }
+
+    Page* acquire(const LazyPage* page)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        waitUntilLoaded(page);
+
+        if(page->m_page == nullptr)
+        {
+            page->m_loading = true;
+
+            // Creating the page can take the lock of the document or wait for the backend,
+            // so the pool is not blocked meanwhile and only users of this page wait for it.
+            mutexLocker.unlock();
+
+            Page* object = m_document->page(page->m_index);
+            const QString backendName = object != nullptr ? object->backendName() : QString();
+
+            mutexLocker.relock();
+
+            page->m_loading = false;
+            m_loaded.wakeAll();
+
+            if(object == nullptr)
+            {
+                return nullptr;
+            }
+
+            page->m_page = object;
+            m_openPages.append(page);
+
+            if(m_backendName.isNull())
+            {
+                m_backendName = backendName;
+            }
+        }
+
+        ++page->m_useCount;
+        page->m_lastUse = ++m_clock;
+
+        return page->m_page;
+    }
+
+    void release(const LazyPage* page)
+    {
+        QVector< Page* > closedPages;
+
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            --page->m_useCount;
+
+            closedPages = evict();
+        }
+
+        // Closing the pages can take the lock of the document, so the pool is not blocked meanwhile.
+        qDeleteAll(closedPages);
+    }
+
+    void retain(const LazyPage* page)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        page->m_retained = true;
+    }
+
+    void remove(const LazyPage* page)
+    {
+        Page* closedPage = nullptr;
+
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            waitUntilLoaded(page);
+
+            if(page->m_page != nullptr)
+            {
+                m_openPages.removeOne(page);
+
+                closedPage = page->m_page;
+                page->m_page = nullptr;
+            }
+        }
+
+        delete closedPage;
+    }
+
+    bool hasLabel(const LazyPage* page, QString& label)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        label = page->m_label;
+
+        return page->m_hasLabel;
+    }
+
+    void setLabel(const LazyPage* page, const QString& label)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        page->m_label = label;
+        page->m_hasLabel = true;
+    }
+
+    QString backendName()
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        return m_backendName;
+    }
+
+private:
+    Q_DISABLE_COPY(Pool)
+
+    const Document* m_document;
+    int m_openPageCount;
+
+    QMutex m_mutex;
+    QWaitCondition m_loaded;
+
+    QVector< const LazyPage* > m_openPages;
+    quint64 m_clock;
+
+    QString m_backendName;
+
+    void waitUntilLoaded(const LazyPage* page)
+    {
+        while(page->m_loading)
+        {
+            m_loaded.wait(&m_mutex);
+        }
+    }
+
+    QVector< Page* > evict()
+    {
+        QVector< Page* > closedPages;
+
+        while(m_openPages.count() > m_openPageCount)
+        {
+            int leastRecentlyUsed = -1;
+
+            for(int index = 0, count = m_openPages.count(); index < count; ++index)
+            {
+                const LazyPage* page = m_openPages.at(index);
+
+                if(page->m_useCount == 0 && !page->m_retained
+                        && (leastRecentlyUsed == -1 || page->m_lastUse < m_openPages.at(leastRecentlyUsed)->m_lastUse))
+                {
+                    leastRecentlyUsed = index;
+                }
+            }
+
+            if(leastRecentlyUsed == -1)
+            {
+                break;
+            }
+
+            const LazyPage* page = m_openPages.takeAt(leastRecentlyUsed);
+
+            closedPages.append(page->m_page);
+            page->m_page = nullptr;
+        }
+
+        return closedPages;
+    }
+
+};
+
+// Keeps the page of the backend open while it is used.
+class LazyPage::Use
+{
+public:
+    explicit Use(const LazyPage* page) :
+        m_page(page),
+        m_object(page->m_pool->acquire(page))
+    {
+    }
+
+    ~Use()
+    {
+        if(m_object != nullptr)
+        {
+            m_page->m_pool->release(m_page);
+        }
+    }
+
+    DECL_NODISCARD
+    bool isNull() const { return m_object == nullptr; }
+
+    Page* operator->() const { return m_object; }
+
+private:
+    Q_DISABLE_COPY(Use)
+
+    const LazyPage* m_page;
+    Page* m_object;
+
+};
+
+QVector< Page* > LazyPage::createPages(const Document* document, const QVector< QSizeF >& pageSizes, int openPageCount)
+{
+    const QSharedPointer< Pool > pool(new Pool(document, openPageCount));
+
+    QVector< Page* > pages;
+    pages.reserve(pageSizes.count());
+
+    for(int index = 0, count = pageSizes.count(); index < count; ++index)
+    {
+        pages.append(new LazyPage(pool, index, pageSizes.at(index)));
+    }
+
+    return pages;
+}
+
+LazyPage::~LazyPage()
+{
+    m_pool->remove(this);
+}
+
+QImage LazyPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect,
+                        CancellationToken* cancellation, bool antialiasing) const
+{
+    const Use use(this);
+
+    if(use.isNull())
+    {
+        return {};
+    }
+
+    return use->render(horizontalResolution, verticalResolution, rotation, boundingRect, cancellation, antialiasing);
+}
+
+QString LazyPage::label() const
+{
+    QString label;
+
+    if(m_pool->hasLabel(this, label))
+    {
+        return label;
+    }
+
+    {
+        const Use use(this);
+
+        if(use.isNull())
+        {
+            return {};
+        }
+
+        label = use->label();
+    }
+
+    m_pool->setLabel(this, label);
+
+    return label;
+}
+
+QString LazyPage::backendName() const
+{
+    const QString backendName = m_pool->backendName();
+
+    if(!backendName.isNull())
+    {
+        return backendName;
+    }
+
+    const Use use(this);
+
+    return use.isNull() ? QString() : use->backendName();
+}
+
+QList< Link* > LazyPage::links() const
+{
+    const Use use(this);
+
+    return use.isNull() ? QList< Link* >() : use->links();
+}
+
+QString LazyPage::text(const QRectF& rect) const
+{
+    const Use use(this);
+
+    return use.isNull() ? QString() : use->text(rect);
+}
+
+QString LazyPage::cachedText(const QRectF& rect) const
+{
+    const Use use(this);
+
+    return use.isNull() ? QString() : use->cachedText(rect);
+}
+
+QList< QRectF > LazyPage::search(const QString& text, bool matchCase, bool wholeWords) const
+{
+    const Use use(this);
+
+    return use.isNull() ? QList< QRectF >() : use->search(text, matchCase, wholeWords);
+}
+
+QList< Annotation* > LazyPage::annotations() const
+{
+    const Use use(this);
+
+    if(use.isNull())
+    {
+        return {};
+    }
+
+    const QList< Annotation* > annotations = use->annotations();
+
+    if(!annotations.isEmpty())
+    {
+        m_pool->retain(this);
+    }
+
+    return annotations;
+}
+
+bool LazyPage::canAddAndRemoveAnnotations() const
+{
+    const Use use(this);
+
+    return !use.isNull() && use->canAddAndRemoveAnnotations();
+}
+
+Annotation* LazyPage::addTextAnnotation(const QRectF& boundary, const QColor& color)
+{
+    const Use use(this);
+
+    if(use.isNull())
+    {
+        return nullptr;
+    }
+
+    Annotation* annotation = use->addTextAnnotation(boundary, color);
+
+    if(annotation != nullptr)
+    {
+        m_pool->retain(this);
+    }
+
+    return annotation;
+}
+
+Annotation* LazyPage::addHighlightAnnotation(const QRectF& boundary, const QColor& color)
+{
+    const Use use(this);
+
+    if(use.isNull())
+    {
+        return nullptr;
+    }
+
+    Annotation* annotation = use->addHighlightAnnotation(boundary, color);
+
+    if(annotation != nullptr)
+    {
+        m_pool->retain(this);
+    }
+
+    return annotation;
+}
+
+void LazyPage::removeAnnotation(Annotation* annotation)
+{
+    const Use use(this);
+
+    if(!use.isNull())
+    {
+        use->removeAnnotation(annotation);
+    }
+}
+
+QList< FormField* > LazyPage::formFields() const
+{
+    const Use use(this);
+
+    if(use.isNull())
+    {
+        return {};
+    }
+
+    const QList< FormField* > formFields = use->formFields();
+
+    if(!formFields.isEmpty())
+    {
+        m_pool->retain(this);
+    }
+
+    return formFields;
+}
+
+LazyPage::LazyPage(const QSharedPointer< Pool >& pool, int index, const QSizeF& size) :
+    m_pool(pool),
+    m_index(index),
+    m_size(size),
+    m_page(nullptr),
+    m_loading(false),
+    m_useCount(0),
+    m_lastUse(0),
+    m_retained(false),
+    m_hasLabel(false),
+    m_label()
+{
+}
+
+} // Model
+
+} // qpdfview
@@ -0,0 +1,117 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef LAZYPAGE_H
+#define LAZYPAGE_H
+
+#include <QSharedPointer>
+
+#include "model.h"
+
+namespace qpdfview
+{
+
+namespace Model
+{
+    // Stands in for a page of a document using only its size, which is known in advance from Document::pageSizes.
+    // The page of the backend is created when the page is rendered or its text, links, annotations or form fields
+    // are accessed. Only a limited number of them are kept open per document and the least recently used ones
+    // are closed again unless they are in use.
+    class LazyPage : public Page
+    {
+    public:
+        // Creates stand-ins for all pages of the document which have to be deleted before the document.
+        static QVector< Page* > createPages(const Document* document, const QVector< QSizeF >& pageSizes, int openPageCount);
+
+        ~LazyPage() override;
+
+        DECL_NODISCARD
+        QSizeF size() const override { return m_size; }
+
+        DECL_NODISCARD
+        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect,
+                      CancellationToken* cancellation, bool antialiasing) const override;
+
+        DECL_NODISCARD
+        QString label() const override;
+
+        DECL_NODISCARD
+        QString backendName() const override;
+
+        DECL_NODISCARD
+        QList< Link* > links() const override;
+
+        DECL_NODISCARD
+        QString text(const QRectF& rect) const override;
+
+        DECL_NODISCARD
+        QString cachedText(const QRectF& rect) const override;
+
+        DECL_NODISCARD
+        QList< QRectF > search(const QString& text, bool matchCase, bool wholeWords) const override;
+
+        DECL_NODISCARD
+        QList< Annotation* > annotations() const override;
+
+        DECL_NODISCARD
+        bool canAddAndRemoveAnnotations() const override;
+        Annotation* addTextAnnotation(const QRectF& boundary, const QColor& color) override;
+        Annotation* addHighlightAnnotation(const QRectF& boundary, const QColor& color) override;
+        void removeAnnotation(Annotation* annotation) override;
+
+        DECL_NODISCARD
+        QList< FormField* > formFields() const override;
+
+    private:
+        Q_DISABLE_COPY(LazyPage)
+
+        class Pool;
+        class Use;
+
+        LazyPage(const QSharedPointer< Pool >& pool, int index, const QSizeF& size);
+
+        QSharedPointer< Pool > m_pool;
+
+        int m_index;
+        QSizeF m_size;
+
+        // These are guarded by the mutex of the pool.
+
+        mutable Page* m_page;
+
+        // The page of the backend is created without holding the mutex, so other users wait until it is done.
+        mutable bool m_loading;
+
+        mutable int m_useCount;
+        mutable quint64 m_lastUse;
+
+        // Annotations and form fields refer to the page of the backend which therefore has to stay open.
+        mutable bool m_retained;
+
+        mutable bool m_hasLabel;
+        mutable QString m_label;
+
+    };
+}
+
+} // qpdfview
+
+#endif // LAZYPAGE_H
@@ -70,6 +70,8 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "printdialog.h"
 #include "settingsdialog.h"
 #include "fontsdialog.h"
+#include "renderstatistics.h"
+#include "renderstatisticsdialog.h"
 #include "helpdialog.h"
 #include "recentlyusedmenu.h"
 #include "recentlyclosedmenu.h"
@@ -362,6 +364,8 @@ SearchModel* MainWindow::s_searchModel = nullptr;
 			: QMainWindow(parent),
 			  m_tabWidget(),
 			  m_currentTabChangedBlocked(),
+			  m_pendingOpens(),
+			  m_pendingRefreshes(),
 			  m_saveDatabaseTimer(),
 			  m_outlineView(),
 			  m_thumbnailsView()
@@ -456,34 +460,12 @@ bool MainWindow::open(const QString& filePath, int page, const QRectF& highlight
             return false;
         }
 
-        if(tab->open(filePath))
-        {
-            s_settings->mainWindow().setOpenPath(tab->fileInfo().absolutePath());
-            m_recentlyUsedMenu->addOpenAction(tab->fileInfo());
-
-            m_tabWidget->setCurrentTabText(tab->title());
-            m_tabWidget->setCurrentTabToolTip(tab->fileInfo().absoluteFilePath());
-
-            restorePerFileSettings(tab);
-            scheduleSaveTabs();
-
-            tab->jumpToPage(page, false);
-            tab->setFocus();
+        m_pendingRefreshes.remove(tab);
+        m_pendingOpens.insert(tab, PendingOpen{filePath, page, highlight, quiet});
 
-            if(!highlight.isNull())
-            {
-                tab->temporaryHighlight(page, highlight);
-            }
+        tab->open(filePath);
 
-            return true;
-        }
-        else
-        {
-            if(!quiet)
-            {
-                QMessageBox::warning(this, tr("Warning"), tr("Could not open '%1'.").arg(filePath));
-            }
-        }
+        return true;
     }
 
     return false;
@@ -493,41 +475,18 @@ bool MainWindow::openInNewTab(const QString& filePath, int page, const QRectF& h
 {
     auto const newTab = new DocumentView(this);
 
-    if(newTab->open(filePath))
-    {
-        s_settings->mainWindow().setOpenPath(newTab->fileInfo().absolutePath());
-        m_recentlyUsedMenu->addOpenAction(newTab->fileInfo());
-
-        addTab(newTab);
-        addTabAction(newTab);
-        connectTab(newTab);
+    m_pendingOpens.insert(newTab, PendingOpen{filePath, page, highlight, quiet});
 
-        newTab->show();
-
-        restorePerFileSettings(newTab);
-        scheduleSaveTabs();
+    newTab->open(filePath);
 
-        newTab->jumpToPage(page, false);
-        newTab->setFocus();
-
-        if(!highlight.isNull())
-        {
-            newTab->temporaryHighlight(page, highlight);
-        }
-
-        return true;
-    }
-    else
-    {
-        delete newTab;
+    addTab(newTab);
+    addTabAction(newTab);
+    connectTab(newTab);
 
-        if(!quiet)
-        {
-            QMessageBox::warning(this, tr("Warning"), tr("Could not open '%1'.").arg(filePath));
-        }
-    }
+    newTab->show();
+    newTab->setFocus();
 
-    return false;
+    return true;
 }
 
 bool MainWindow::jumpToPageOrOpenInNewTab(const QString& filePath, int page, bool refreshBeforeJump, const QRectF& highlight, bool quiet)
@@ -542,16 +501,16 @@ bool MainWindow::jumpToPageOrOpenInNewTab(const QString& filePath, int page, boo
             {
                 m_tabWidget->setCurrentIndex(index);
 
-                if(refreshBeforeJump)
+                tab->setFocus();
+
+                if(refreshBeforeJump && tab->hasDocument())
                 {
-                    if(!tab->refresh())
-                    {
-                        return false;
-                    }
+                    refresh(tab, page, highlight, quiet);
+
+                    return true;
                 }
 
                 tab->jumpToPage(page);
-                tab->setFocus();
 
                 if(!highlight.isNull())
                 {
@@ -594,8 +553,11 @@ void MainWindow::onTabWidgetCurrentChanged()
     DocumentView* const tab = currentTab();
     const bool hasCurrent = tab != nullptr;
 
-    m_refreshAction->setEnabled(hasCurrent);
-    m_printAction->setEnabled(hasCurrent);
+    // A tab which is still opening its first document has nothing to refresh, print or present yet.
+    const bool hasDocument = hasCurrent && tab->hasDocument();
+
+    m_refreshAction->setEnabled(hasDocument);
+    m_printAction->setEnabled(hasDocument);
 
     m_previousPageAction->setEnabled(hasCurrent);
     m_nextPageAction->setEnabled(hasCurrent);
@@ -617,8 +579,8 @@ void MainWindow::onTabWidgetCurrentChanged()
     m_multiplePagesModeAction->setEnabled(hasCurrent);
     m_rightToLeftModeAction->setEnabled(hasCurrent);
 
-    m_zoomInAction->setEnabled(hasCurrent);
-    m_zoomOutAction->setEnabled(hasCurrent);
+    m_zoomInAction->setEnabled(hasDocument);
+    m_zoomOutAction->setEnabled(hasDocument);
     m_originalSizeAction->setEnabled(hasCurrent);
     m_fitToPageWidthModeAction->setEnabled(hasCurrent);
     m_fitToPageSizeModeAction->setEnabled(hasCurrent);
@@ -634,9 +596,9 @@ void MainWindow::onTabWidgetCurrentChanged()
     m_darkenWithPaperColorAction->setEnabled(hasCurrent);
     m_lightenWithPaperColorAction->setEnabled(hasCurrent);
 
-    m_fontsAction->setEnabled(hasCurrent);
+    m_fontsAction->setEnabled(hasDocument);
 
-    m_presentationAction->setEnabled(hasCurrent);
+    m_presentationAction->setEnabled(hasDocument);
 
     m_previousTabAction->setEnabled(hasCurrent);
     m_nextTabAction->setEnabled(hasCurrent);
@@ -693,6 +655,8 @@ void MainWindow::onTabWidgetCurrentChanged()
 
         m_thumbnailsView->setScene(tab->thumbnailsScene());
         tab->setThumbnailsViewportSize(m_thumbnailsView->viewport()->size());
+
+        onThumbnailsScrollBarValueChanged(0);
 	
 	    onCurrentTabDocumentChanged();
 	
@@ -909,6 +873,101 @@ void MainWindow::onCurrentTabDocumentChanged()
     setWindowModified(currentTab()->wasModified());
 }
 
+void MainWindow::onTabOpenFinished(bool success)
+{
+    auto const tab = qobject_cast< DocumentView* >(sender());
+
+    if(tab == nullptr || !m_pendingOpens.contains(tab))
+    {
+        return;
+    }
+
+    const PendingOpen pendingOpen = m_pendingOpens.take(tab);
+
+    if(success)
+    {
+        s_settings->mainWindow().setOpenPath(tab->fileInfo().absolutePath());
+        m_recentlyUsedMenu->addOpenAction(tab->fileInfo());
+
+        restorePerFileSettings(tab);
+        scheduleSaveTabs();
+
+        tab->jumpToPage(pendingOpen.page, false);
+
+        if(!pendingOpen.highlight.isNull())
+        {
+            tab->temporaryHighlight(pendingOpen.page, pendingOpen.highlight);
+        }
+
+        if(tab == currentTab())
+        {
+            onTabWidgetCurrentChanged();
+        }
+    }
+    else
+    {
+        if(!pendingOpen.quiet)
+        {
+            QMessageBox::warning(this, tr("Warning"), tr("Could not open '%1'.").arg(pendingOpen.filePath));
+        }
+
+        // A tab which never showed a document is discarded.
+        if(!tab->hasDocument())
+        {
+            tab->deleteLater();
+        }
+    }
+}
+
+void MainWindow::onTabRefreshFinished(bool success)
+{
+    auto const tab = qobject_cast< DocumentView* >(sender());
+
+    if(tab == nullptr || !m_pendingRefreshes.contains(tab))
+    {
+        return;
+    }
+
+    const PendingOpen pendingRefresh = m_pendingRefreshes.take(tab);
+
+    if(!success)
+    {
+        if(!pendingRefresh.quiet)
+        {
+            QMessageBox::warning(this, tr("Warning"), tr("Could not refresh '%1'.").arg(pendingRefresh.filePath));
+        }
+
+        return;
+    }
+
+    if(pendingRefresh.page != -1)
+    {
+        tab->jumpToPage(pendingRefresh.page);
+
+        if(!pendingRefresh.highlight.isNull())
+        {
+            tab->temporaryHighlight(pendingRefresh.page, pendingRefresh.highlight);
+        }
+    }
+}
+
+void MainWindow::onTabOpenCanceled()
+{
+    auto const tab = qobject_cast< DocumentView* >(sender());
+
+    if(tab == nullptr || !m_pendingOpens.contains(tab))
+    {
+        return;
+    }
+
+    m_pendingOpens.remove(tab);
+
+    if(!tab->hasDocument())
+    {
+        tab->deleteLater();
+    }
+}
+
 void MainWindow::onCurrentTabDocumentModified()
 {
     ONLY_IF_SENDER_IS_CURRENT_TAB
@@ -948,7 +1007,7 @@ void MainWindow::onCurrentTabCurrentPageChanged(int currentPage)
         }
     }
 
-    m_thumbnailsView->ensureVisible(currentTab()->thumbnailItems().at(currentPage - 1));
+    m_thumbnailsView->ensureVisible(currentTab()->thumbnailRect(currentPage - 1));
 
     setWindowTitleForCurrentTab();
     setCurrentPageSuffixForCurrentTab();
@@ -1210,11 +1269,9 @@ void MainWindow::onSplitViewSplitTriggered(Qt::Orientation orientation, int inde
 
     auto const newTab = new DocumentView(this);
 
-    if(!newTab->open(filePath))
-    {
-        delete newTab;
-        return;
-    }
+    m_pendingOpens.insert(newTab, PendingOpen{filePath, -1, QRectF(), true});
+
+    newTab->open(filePath);
 
     auto splitter = new Splitter(orientation, this);
     connect(splitter, SIGNAL(currentWidgetChanged(QWidget*)), this, SLOT(onSplitViewCurrentWidgetChanged(QWidget*)));
@@ -1473,9 +1530,9 @@ void MainWindow::onRefreshTriggered()
 {
     DocumentView* const tab = currentTab();
 
-    if(saveModifications(tab) && !tab->refresh())
+    if(saveModifications(tab))
     {
-        QMessageBox::warning(this, tr("Warning"), tr("Could not refresh '%1'.").arg(currentTab()->fileInfo().filePath()));
+        refresh(tab);
     }
 }
 
@@ -1490,10 +1547,7 @@ void MainWindow::onSaveTriggered()
         return;
     }
 
-    if(!tab->refresh())
-    {
-        QMessageBox::warning(this, tr("Warning"), tr("Could not refresh '%1'.").arg(filePath));
-    }
+    refresh(tab);
 }
 
 void MainWindow::onSaveAsTriggered()
@@ -1707,9 +1761,9 @@ void MainWindow::onSettingsTriggered()
 
     for(DocumentView* tab : allTabs())
     {
-        if(saveModifications(tab) && !tab->refresh())
+        if(saveModifications(tab))
         {
-            QMessageBox::warning(this, tr("Warning"), tr("Could not refresh '%1'.").arg(currentTab()->fileInfo().filePath()));
+            refresh(tab);
         }
     }
 }
@@ -1807,6 +1861,13 @@ void MainWindow::onFontsTriggered()
     dialog->exec();
 }
 
+void MainWindow::onRenderStatisticsTriggered()
+{
+    QScopedPointer<RenderStatisticsDialog> dialog(new RenderStatisticsDialog(this));
+
+    dialog->exec();
+}
+
 void MainWindow::onFullscreenTriggered(bool checked)
 {
     if(checked)
@@ -2357,21 +2418,13 @@ void MainWindow::onThumbnailsDockLocationChanged(Qt::DockWidgetArea area)
     }
 }
 
-void MainWindow::onThumbnailsVerticalScrollBarValueChanged(int value)
+void MainWindow::onThumbnailsScrollBarValueChanged(int value)
 {
     Q_UNUSED(value)
 
     if(m_thumbnailsView->scene())
     {
-        const QRectF visibleRect = m_thumbnailsView->mapToScene(m_thumbnailsView->viewport()->rect()).boundingRect();
-
-        for(ThumbnailItem* page : currentTab()->thumbnailItems())
-        {
-            if(!page->boundingRect().translated(page->pos()).intersects(visibleRect))
-            {
-                page->cancelRender();
-            }
-        }
+        currentTab()->setThumbnailsVisibleRect(m_thumbnailsView->mapToScene(m_thumbnailsView->viewport()->rect()).boundingRect());
     }
 }
 
@@ -2591,7 +2644,10 @@ void MainWindow::onSaveDatabaseTimeout()
     {
         for(auto tab : allTabs())
         {
-            s_database->savePerFileSettings(tab);
+            if(tab->hasDocument())
+            {
+                s_database->savePerFileSettings(tab);
+            }
         }
     }
 }
@@ -2618,6 +2674,8 @@ bool MainWindow::eventFilter(QObject* target, QEvent* event)
         if(DocumentView* tab = currentTab())
         {
             tab->setThumbnailsViewportSize(m_thumbnailsView->viewport()->size());
+
+            onThumbnailsScrollBarValueChanged(0);
         }
     }
 
@@ -2775,6 +2833,10 @@ void MainWindow::addTabAction(DocumentView* tab)
 
 void MainWindow::connectTab(DocumentView* tab)
 {
+    connect(tab, SIGNAL(openFinished(bool)), SLOT(onTabOpenFinished(bool)));
+    connect(tab, SIGNAL(openCanceled()), SLOT(onTabOpenCanceled()));
+    connect(tab, SIGNAL(refreshFinished(bool)), SLOT(onTabRefreshFinished(bool)));
+
     connect(tab, SIGNAL(documentChanged()), SLOT(onCurrentTabDocumentChanged()));
     connect(tab, SIGNAL(documentModified()), SLOT(onCurrentTabDocumentModified()));
 
@@ -2810,6 +2872,19 @@ void MainWindow::connectTab(DocumentView* tab)
     connect(tab, SIGNAL(customContextMenuRequested(QPoint)), SLOT(onCurrentTabCustomContextMenuRequested(QPoint)));
 }
 
+void MainWindow::refresh(DocumentView* tab, int page, const QRectF& highlight, bool quiet)
+{
+    if(tab->refresh())
+    {
+        m_pendingRefreshes.insert(tab, PendingOpen{tab->fileInfo().filePath(), page, highlight, quiet});
+    }
+    else if(page != -1)
+    {
+        // The document which is being opened replaces the current one anyway.
+        tab->jumpToPage(page);
+    }
+}
+
 void MainWindow::restorePerFileSettings(DocumentView* tab)
 {
     s_database->restorePerFileSettings(tab);
@@ -2822,7 +2897,11 @@ void MainWindow::restorePerFileSettings(DocumentView* tab)
 
 bool MainWindow::saveModifications(DocumentView* tab)
 {
-    s_database->savePerFileSettings(tab);
+    if(tab->hasDocument())
+    {
+        s_database->savePerFileSettings(tab);
+    }
+
     scheduleSaveTabs();
 
     if(tab->wasModified())
@@ -2853,6 +2932,9 @@ bool MainWindow::saveModifications(DocumentView* tab)
 
 void MainWindow::closeTab(DocumentView* tab)
 {
+    m_pendingOpens.remove(tab);
+    m_pendingRefreshes.remove(tab);
+
     const int tabIndex = m_tabWidget->indexOf(tab);
 
     if(s_settings->mainWindow().keepRecentlyClosed() && tabIndex != -1)
@@ -3467,6 +3549,13 @@ void MainWindow::createActions()
 			SLOT(onFontsTriggered())
 	);
 	
+	m_renderStatisticsAction = this->createAction(
+			tr("Render statistics..."),
+			QString(), QIcon(),
+			QKeySequence(),
+			SLOT(onRenderStatisticsTriggered())
+	);
+	
 	m_fullscreenAction = this->createAction(
 			tr("&Fullscreen"),
 			QLatin1String("fullscreen"),
@@ -3989,7 +4078,8 @@ void MainWindow::createDocks()
 
     m_thumbnailsView->installEventFilter(this);
 
-    connect(m_thumbnailsView->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(onThumbnailsVerticalScrollBarValueChanged(int)));
+    connect(m_thumbnailsView->horizontalScrollBar(), SIGNAL(valueChanged(int)), SLOT(onThumbnailsScrollBarValueChanged(int)));
+    connect(m_thumbnailsView->verticalScrollBar(), SIGNAL(valueChanged(int)), SLOT(onThumbnailsScrollBarValueChanged(int)));
 
     m_thumbnailsDock->setWidget(m_thumbnailsView);
 
@@ -4086,6 +4176,7 @@ void MainWindow::createMenus()
     }
 
     m_viewMenu->addAction(m_fontsAction);
+    m_viewMenu->addAction(m_renderStatisticsAction);
     m_viewMenu->addSeparator();
     m_viewMenu->addActions(QList<QAction*>() << m_fullscreenAction << m_presentationAction);
 
@@ -4378,6 +4469,18 @@ void MainWindowAdaptor::presentation()
 	mainWindow()->onPresentationTriggered();
 }
 
+DECL_UNUSED
+QString MainWindowAdaptor::renderStatistics() const
+{
+    return QString::fromUtf8(RenderStatistics::instance()->toJson());
+}
+
+DECL_UNUSED
+void MainWindowAdaptor::resetRenderStatistics()
+{
+    RenderStatistics::instance()->reset();
+}
+
 DECL_UNUSED
 void MainWindowAdaptor::closeTab()
 {
@@ -28,7 +28,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QMainWindow>
 
+#include <QHash>
 #include <QPointer>
+#include <QRectF>
 
 #ifdef WITH_DBUS
 
@@ -102,6 +104,10 @@ protected slots:
     void onTabWidgetTabDragRequested(int index);
     void onTabWidgetTabContextMenuRequested(QPoint globalPos, int index);
 
+    void onTabOpenFinished(bool success);
+    void onTabOpenCanceled();
+    void onTabRefreshFinished(bool success);
+
     void onCurrentTabDocumentChanged();
     void onCurrentTabDocumentModified();
 
@@ -214,6 +220,7 @@ protected slots:
     void onLightenWithPaperColorTriggered(bool checked);
 
     void onFontsTriggered();
+    void onRenderStatisticsTriggered();
 
     void onFullscreenTriggered(bool checked);
     void onPresentationTriggered();
@@ -268,7 +275,7 @@ protected slots:
     void onPropertiesSectionCountChanged();
 
     void onThumbnailsDockLocationChanged(Qt::DockWidgetArea area);
-    void onThumbnailsVerticalScrollBarValueChanged(int value);
+    void onThumbnailsScrollBarValueChanged(int value);
 
     void onBookmarksSectionCountChanged();
     void onBookmarksClicked(const QModelIndex& index);
@@ -322,6 +329,22 @@ private:
     void addTabAction(DocumentView* tab);
     void connectTab(DocumentView* tab);
 
+    // what to do with a tab once it finished opening its document
+    struct PendingOpen
+    {
+        QString filePath;
+        int page;
+        QRectF highlight;
+        bool quiet;
+    };
+
+    QHash< DocumentView*, PendingOpen > m_pendingOpens;
+
+    // Refreshes run in the background, so jumping to a page and reporting failures happen when they finish.
+    QHash< DocumentView*, PendingOpen > m_pendingRefreshes;
+
+    void refresh(DocumentView* tab, int page = -1, const QRectF& highlight = QRectF(), bool quiet = false);
+
     void restorePerFileSettings(DocumentView* tab);
 
     bool saveModifications(DocumentView* tab);
@@ -418,6 +441,7 @@ private:
     QAction* m_lightenWithPaperColorAction {};
 
     QAction* m_fontsAction {};
+    QAction* m_renderStatisticsAction {};
 
     QAction* m_fullscreenAction {};
     QAction* m_presentationAction {};
@@ -621,6 +645,13 @@ public slots:
     DECL_UNUSED
     void presentation();
 
+    // per-stage render latencies as JSON
+    DECL_UNUSED
+    QString renderStatistics() const;
+    Q_NOREPLY
+    DECL_UNUSED
+    void resetRenderStatistics();
+
 
     Q_NOREPLY
     DECL_UNUSED
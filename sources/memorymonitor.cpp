@@ -0,0 +1,239 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "memorymonitor.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QTimer>
+
+namespace qpdfview
+{
+
+namespace
+{
+
+const int sampleInterval = 2000;
+
+const QLatin1String cgroupRoot("/sys/fs/cgroup");
+
+QByteArray readFile(const QString& fileName)
+{
+    QFile file(fileName);
+
+    if(!file.open(QIODevice::ReadOnly))
+    {
+        return {};
+    }
+
+    // Files in procfs and sysfs report a size of zero and must be read until their end.
+    return file.readAll();
+}
+
+// Reads the value of a line like "MemAvailable:   1234 kB" or "inactive_file 1234".
+bool readValue(const QByteArray& data, const char* name, qint64& value)
+{
+    foreach(const QByteArray& line, data.split('\n'))
+    {
+        if(!line.startsWith(name))
+        {
+            continue;
+        }
+
+        const QList< QByteArray > fields = line.mid(static_cast< int >(qstrlen(name))).simplified().split(' ');
+
+        bool ok = false;
+        value = fields.value(0).toLongLong(&ok);
+
+        return ok;
+    }
+
+    return false;
+}
+
+// Reads "avg10" of the "some" line of the pressure stall information.
+qreal readPressure(const QByteArray& data)
+{
+    foreach(const QByteArray& line, data.split('\n'))
+    {
+        if(!line.startsWith("some "))
+        {
+            continue;
+        }
+
+        foreach(const QByteArray& field, line.split(' '))
+        {
+            if(field.startsWith("avg10="))
+            {
+                return field.mid(6).toDouble();
+            }
+        }
+    }
+
+    return 0.0;
+}
+
+QString cgroupPath()
+{
+    // Only the unified hierarchy of cgroup v2 is considered.
+    foreach(const QByteArray& line, readFile(QLatin1String("/proc/self/cgroup")).split('\n'))
+    {
+        if(line.startsWith("0::"))
+        {
+            QString path = cgroupRoot + QString::fromLocal8Bit(line.mid(3).trimmed());
+
+            while(path.endsWith(QLatin1Char('/')))
+            {
+                path.chop(1);
+            }
+
+            return path;
+        }
+    }
+
+    return {};
+}
+
+} // anonymous
+
+MemoryMonitor* MemoryMonitor::s_instance = nullptr;
+
+MemoryMonitor* MemoryMonitor::instance()
+{
+    if(s_instance == nullptr)
+    {
+        s_instance = new MemoryMonitor(qApp);
+    }
+
+    return s_instance;
+}
+
+MemoryMonitor::~MemoryMonitor()
+{
+    s_instance = nullptr;
+}
+
+bool MemoryMonitor::isEnabled() const
+{
+    return m_timer->isActive();
+}
+
+void MemoryMonitor::setEnabled(bool enabled)
+{
+    if(!m_supported || enabled == m_timer->isActive())
+    {
+        return;
+    }
+
+    if(enabled)
+    {
+        m_timer->start();
+
+        onTimerTimeout();
+    }
+    else
+    {
+        m_timer->stop();
+    }
+}
+
+void MemoryMonitor::onTimerTimeout()
+{
+    if(readSample(m_sample))
+    {
+        emit sampled();
+    }
+}
+
+MemoryMonitor::MemoryMonitor(QObject* parent) : QObject(parent),
+    m_timer(nullptr),
+    m_supported(false),
+    m_cgroupPath(),
+    m_sample{0, 0, 0.0}
+{
+    m_timer = new QTimer(this);
+    m_timer->setInterval(sampleInterval);
+
+    connect(m_timer, SIGNAL(timeout()), SLOT(onTimerTimeout()));
+
+#ifdef Q_OS_LINUX
+
+    m_cgroupPath = cgroupPath();
+
+    m_supported = readSample(m_sample);
+
+#endif // Q_OS_LINUX
+}
+
+bool MemoryMonitor::readSample(Sample& sample) const
+{
+    const QByteArray meminfo = readFile(QLatin1String("/proc/meminfo"));
+
+    qint64 limit = 0;
+    qint64 available = 0;
+
+    if(!readValue(meminfo, "MemTotal:", limit) || !readValue(meminfo, "MemAvailable:", available))
+    {
+        return false;
+    }
+
+    // The limits of all enclosing cgroups apply, so the tightest one counts.
+    for(QString path = m_cgroupPath; path.length() > cgroupRoot.size(); path.truncate(path.lastIndexOf(QLatin1Char('/'))))
+    {
+        bool ok = false;
+        const qint64 maximum = readFile(path + QLatin1String("/memory.max")).trimmed().toLongLong(&ok);
+
+        // The maximum is "max" if the cgroup is not limited.
+        if(!ok)
+        {
+            continue;
+        }
+
+        const qint64 current = readFile(path + QLatin1String("/memory.current")).trimmed().toLongLong();
+
+        // The usage includes the page cache of which inactive pages are reclaimed cheaply.
+        qint64 inactiveFile = 0;
+        readValue(readFile(path + QLatin1String("/memory.stat")), "inactive_file ", inactiveFile);
+
+        limit = qMin(limit, maximum / 1024);
+        available = qMin(available, qMax(qint64(0), maximum - current + inactiveFile) / 1024);
+    }
+
+    QByteArray pressure;
+
+    if(!m_cgroupPath.isEmpty())
+    {
+        pressure = readFile(m_cgroupPath + QLatin1String("/memory.pressure"));
+    }
+
+    if(pressure.isEmpty())
+    {
+        pressure = readFile(QLatin1String("/proc/pressure/memory"));
+    }
+
+    sample.limit = limit;
+    sample.available = available;
+    sample.pressure = readPressure(pressure);
+
+    return true;
+}
+
+} // qpdfview
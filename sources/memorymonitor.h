@@ -0,0 +1,91 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef MEMORYMONITOR_H
+#define MEMORYMONITOR_H
+
+#include <QObject>
+#include <QString>
+
+#include "global.h"
+
+class QTimer;
+
+namespace qpdfview
+{
+
+// Periodically samples the memory available to the process and the memory pressure on Linux,
+// respecting the limits of its cgroup, so that caches can adapt their budgets.
+class MemoryMonitor : public QObject
+{
+    Q_OBJECT
+
+public:
+    static MemoryMonitor* instance();
+    ~MemoryMonitor() override;
+
+    struct Sample
+    {
+        // in kilobytes
+        qint64 limit;
+        qint64 available;
+
+        // the share of the last ten seconds in which some tasks stalled waiting for memory in percent
+        qreal pressure;
+    };
+
+    // false if memory information cannot be read on this system
+    DECL_NODISCARD
+    bool isSupported() const { return m_supported; }
+
+    DECL_NODISCARD
+    bool isEnabled() const;
+    void setEnabled(bool enabled);
+
+    DECL_NODISCARD
+    const Sample& sample() const { return m_sample; }
+
+signals:
+    void sampled();
+
+protected slots:
+    void onTimerTimeout();
+
+private:
+    Q_DISABLE_COPY(MemoryMonitor)
+
+    static MemoryMonitor* s_instance;
+    explicit MemoryMonitor(QObject* parent = nullptr);
+
+    QTimer* m_timer;
+
+    bool m_supported;
+    QString m_cgroupPath;
+
+    Sample m_sample;
+
+    bool readSample(Sample& sample) const;
+
+};
+
+} // qpdfview
+
+#endif // MEMORYMONITOR_H
@@ -23,8 +23,11 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef DOCUMENTMODEL_H
 #define DOCUMENTMODEL_H
 
+#include <QAtomicInt>
 #include <QList>
+#include <QMutex>
 #include <QPainterPath>
+#include <QSizeF>
 #include <QWidget>
 #include <QtPlugin>
 #include <QWidget>
@@ -34,7 +37,6 @@ class QAbstractItemModel;
 class QColor;
 class QImage;
 class QPrinter;
-class QSizeF;
 
 #include "global.h"
 
@@ -119,6 +121,57 @@ namespace Model
         void wasModified();
     };
 
+    // Lets the caller abort a render which is running on another thread.
+    class CancellationToken
+    {
+    public:
+        CancellationToken() : m_canceled(0), m_mutex(), m_abortFlag(nullptr) {}
+
+        DECL_NODISCARD
+        bool isCanceled() const { return m_canceled.loadAcquire() != 0; }
+
+        void cancel()
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            m_canceled.storeRelease(1);
+
+            if(m_abortFlag != nullptr)
+            {
+                *m_abortFlag = 1;
+            }
+        }
+
+        void reset()
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            m_canceled.storeRelease(0);
+        }
+
+        // Backends polling a flag of their own, e.g. fz_cookie::abort, bind it for the duration of a render.
+        void bindAbortFlag(int* abortFlag)
+        {
+            QMutexLocker mutexLocker(&m_mutex);
+
+            m_abortFlag = abortFlag;
+
+            if(m_abortFlag != nullptr && m_canceled.loadAcquire() != 0)
+            {
+                *m_abortFlag = 1;
+            }
+        }
+
+    private:
+        Q_DISABLE_COPY(CancellationToken)
+
+        QAtomicInt m_canceled;
+
+        QMutex m_mutex;
+        int* m_abortFlag;
+
+    };
+
     class Page
     {
     public:
@@ -128,11 +181,16 @@ namespace Model
         virtual QSizeF size() const = 0;
 
         DECL_NODISCARD
-        virtual QImage render(qreal horizontalResolution = 72.0, qreal verticalResolution = 72.0, Rotation rotation = RotateBy0, QRect boundingRect = QRect()) const = 0;
+        virtual QImage render(qreal horizontalResolution = 72.0, qreal verticalResolution = 72.0, Rotation rotation = RotateBy0, QRect boundingRect = QRect(),
+                              CancellationToken* cancellation = nullptr, bool antialiasing = true) const = 0;
 
         DECL_NODISCARD
         virtual QString label() const { return {}; }
 
+        // the library which renders the page, e.g. to compare render statistics
+        DECL_NODISCARD
+        virtual QString backendName() const { return {}; }
+
         DECL_NODISCARD
         virtual QList< Link* > links() const { return {}; }
 
@@ -170,6 +228,28 @@ namespace Model
         DECL_NODISCARD
         virtual Page* page(int index) const = 0;
 
+        // The sizes of all pages, which are invalid for pages that could not be loaded.
+        // Backends should override this if the sizes can be determined without creating the pages.
+        DECL_NODISCARD
+        virtual QVector< QSizeF > pageSizes() const
+        {
+            const int numberOfPages = this->numberOfPages();
+
+            QVector< QSizeF > sizes(numberOfPages);
+
+            for(int index = 0; index < numberOfPages; ++index)
+            {
+                if(const Page* page = this->page(index))
+                {
+                    sizes[index] = page->size();
+
+                    delete page;
+                }
+            }
+
+            return sizes;
+        }
+
         DECL_NODISCARD
         virtual bool isLocked() const { return false; }
         virtual bool unlock(const QString& password) { Q_UNUSED(password) return false; }
@@ -233,6 +313,7 @@ class Plugin
 public:
     virtual ~Plugin() = default;
 
+    // This is called by worker threads, possibly for several documents at once.
     DECL_NODISCARD
     virtual Model::Document* loadDocument(const QString& filePath) const = 0;
 
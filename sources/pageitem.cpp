@@ -21,6 +21,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "pageitem.h"
 
+#include <algorithm>
+#include <cmath>
+
 #include <QApplication>
 #include <QClipboard>
 #include <QtConcurrentRun>
@@ -28,6 +31,7 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include <QGraphicsProxyWidget>
 #include <QGraphicsScene>
 #include <QGraphicsSceneHoverEvent>
+#include <QGraphicsView>
 #include <qmath.h>
 #include <QMenu>
 #include <QMessageBox>
@@ -39,6 +43,9 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include "settings.h"
 #include "model.h"
+#include "renderscheduler.h"
+#include "renderstatistics.h"
+#include "tilecache.h"
 #include "tileitem.h"
 
 namespace qpdfview
@@ -50,6 +57,90 @@ namespace
 const int largeTilesThreshold = 8;
 const int veryLargeTilesThreshold = 16;
 
+// Tiles are sized to render within this time in milliseconds at the measured throughput of the backend,
+// but are kept within these bounds in device pixels.
+const qreal targetTileRenderTime = 40.0;
+const int minimumTileSize = 256;
+const int maximumTileSize = 4096;
+
+// The viewport is covered by at least this many tiles in each direction, so that its centre fills in first.
+const int minimumTilesPerViewport = 2;
+
+inline int floorToPowerOfTwo(int value)
+{
+    return 1 << qFloor(std::log2(qMax(1, value)));
+}
+
+inline int roundToPowerOfTwo(int value)
+{
+    return 1 << qRound(std::log2(qMax(1, value)));
+}
+
+// Orders tiles in a spiral around the given centre, i.e. by rings of tiles and within each ring by angle.
+QVector< TileItem* > spiralOrder(const QSet< TileItem* >& tiles, const QPointF& center)
+{
+    struct Position
+    {
+        TileItem* tile;
+        int ring;
+        qreal angle;
+    };
+
+    QVector< Position > positions;
+    positions.reserve(tiles.count());
+
+    foreach(TileItem* tile, tiles)
+    {
+        const QRectF rect = tile->rect();
+        const QPointF offset = rect.center() - center;
+
+        const int ring = qRound(qMax(qAbs(offset.x()) / qMax(1.0, rect.width()), qAbs(offset.y()) / qMax(1.0, rect.height())));
+
+        positions.append(Position{tile, ring, std::atan2(offset.y(), offset.x())});
+    }
+
+    std::sort(positions.begin(), positions.end(), [](const Position& left, const Position& right)
+    {
+        return left.ring != right.ring ? left.ring < right.ring : left.angle < right.angle;
+    });
+
+    QVector< TileItem* > orderedTiles;
+    orderedTiles.reserve(positions.count());
+
+    foreach(const Position& position, positions)
+    {
+        orderedTiles.append(position.tile);
+    }
+
+    return orderedTiles;
+}
+
+QTransform pageTransform(const RenderParam& renderParam)
+{
+    QTransform transform;
+
+    transform.scale(renderParam.resolutionX() * renderParam.scaleFactor() / 72.0,
+                    renderParam.resolutionY() * renderParam.scaleFactor() / 72.0);
+
+    switch(renderParam.rotation())
+    {
+    default:
+    case RotateBy0:
+        break;
+    case RotateBy90:
+        transform.rotate(90.0);
+        break;
+    case RotateBy180:
+        transform.rotate(180.0);
+        break;
+    case RotateBy270:
+        transform.rotate(270.0);
+        break;
+    }
+
+    return transform;
+}
+
 const qreal proxyPadding = 2.0;
 
 inline bool modifiersAreActive(const QGraphicsSceneMouseEvent* event, Qt::KeyboardModifiers modifiers)
@@ -77,6 +168,9 @@ PageItem::PageItem(Model::Page* page, int index, PaintMode paintMode, QGraphicsI
     m_cropRect(),
     m_index(index),
     m_paintMode(paintMode),
+    m_documentId(),
+    m_persistentDocumentId(false),
+    m_documentKey(TileCache::instance()->acquireDocument(QByteArray())),
     m_highlights(),
     m_loadInteractiveElements(),
     m_links(),
@@ -90,7 +184,9 @@ PageItem::PageItem(Model::Page* page, int index, PaintMode paintMode, QGraphicsI
     m_transform(),
     m_normalizedTransform(),
     m_boundingRect(),
-    m_tileItems()
+    m_tileItems(),
+    m_exposedTileItems(),
+    m_previewTileItem(nullptr)
 {
     if(s_settings == nullptr)
     {
@@ -109,6 +205,13 @@ PageItem::PageItem(Model::Page* page, int index, PaintMode paintMode, QGraphicsI
         m_tileItems.replace(0, new TileItem(this));
     }
 
+    if(useProgressiveRendering() || useIdlePrerendering())
+    {
+        m_previewTileItem = new TileItem(this, true);
+    }
+
+    connect(TileCache::instance(), SIGNAL(memoryPressure()), SLOT(dropObsoletePixmaps()));
+
     prepareGeometry();
 }
 
@@ -125,30 +228,46 @@ PageItem::~PageItem()
     hideAnnotationOverlay(false);
     hideFormFieldOverlay(false);
 
-    TileItem::dropCachedPixmaps(this);
+    TileCache::instance()->releaseDocument(m_documentKey);
 
     qDeleteAll(m_links);
     qDeleteAll(m_annotations);
     qDeleteAll(m_formFields);
 
     qDeleteAll(m_tileItems);
+    delete m_previewTileItem;
 }
 
-QRectF PageItem::boundingRect() const
+QRectF PageItem::uncroppedBoundingRect(const QSizeF& size, const RenderParam& renderParam)
+{
+    QRectF boundingRect = pageTransform(renderParam).mapRect(QRectF(QPointF(), size));
+
+    boundingRect.setWidth(qRound(boundingRect.width()));
+    boundingRect.setHeight(qRound(boundingRect.height()));
+
+    return boundingRect;
+}
+
+QRectF PageItem::croppedBoundingRect(const QRectF& boundingRect, const QRectF& cropRect)
 {
-    if(m_cropRect.isNull())
+    if(cropRect.isNull())
     {
-        return m_boundingRect;
+        return boundingRect;
     }
 
-    QRectF boundingRect;
+    QRectF croppedBoundingRect;
 
-    boundingRect.setLeft(m_boundingRect.left() + m_cropRect.left() * m_boundingRect.width());
-    boundingRect.setTop(m_boundingRect.top() + m_cropRect.top() * m_boundingRect.height());
-    boundingRect.setWidth(m_cropRect.width() * m_boundingRect.width());
-    boundingRect.setHeight(m_cropRect.height() * m_boundingRect.height());
+    croppedBoundingRect.setLeft(boundingRect.left() + cropRect.left() * boundingRect.width());
+    croppedBoundingRect.setTop(boundingRect.top() + cropRect.top() * boundingRect.height());
+    croppedBoundingRect.setWidth(cropRect.width() * boundingRect.width());
+    croppedBoundingRect.setHeight(cropRect.height() * boundingRect.height());
 
-    return boundingRect;
+    return croppedBoundingRect;
+}
+
+QRectF PageItem::boundingRect() const
+{
+    return croppedBoundingRect(m_boundingRect, m_cropRect);
 }
 
 void PageItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*)
@@ -170,23 +289,61 @@ QSizeF PageItem::displayedSize(const RenderParam& renderParam) const
 
     const bool useCropRect = !m_cropRect.isNull() && !rotationChanged && !flagsChanged;
 
-    const qreal cropWidth = useCropRect ? m_cropRect.width() : 1.0;
-    const qreal cropHeight = useCropRect ? m_cropRect.height() : 1.0;
+    return displayedSize(m_size, useCropRect ? m_cropRect : QRectF(), renderParam);
+}
+
+QSizeF PageItem::displayedSize(const QSizeF& size, const QRectF& cropRect, const RenderParam& renderParam)
+{
+    const qreal cropWidth = !cropRect.isNull() ? cropRect.width() : 1.0;
+    const qreal cropHeight = !cropRect.isNull() ? cropRect.height() : 1.0;
 
     switch(renderParam.rotation())
     {
     default:
     case RotateBy0:
     case RotateBy180:
-        return {renderParam.resolutionX() / 72.0 * cropWidth * m_size.width(),
-                renderParam.resolutionY() / 72.0 * cropHeight * m_size.height()};
+        return {renderParam.resolutionX() / 72.0 * cropWidth * size.width(),
+                renderParam.resolutionY() / 72.0 * cropHeight * size.height()};
     case RotateBy90:
     case RotateBy270:
-        return {renderParam.resolutionX() / 72.0 * cropHeight * m_size.height(),
-                renderParam.resolutionY() / 72.0 * cropWidth * m_size.width()};
+        return {renderParam.resolutionX() / 72.0 * cropHeight * size.height(),
+                renderParam.resolutionY() / 72.0 * cropWidth * size.width()};
+    }
+}
+
+void PageItem::setCropRect(const QRectF& cropRect)
+{
+    if(m_cropRect != cropRect)
+    {
+        prepareGeometryChange();
+
+        m_cropRect = cropRect;
     }
 }
 
+bool PageItem::isRendering() const
+{
+    foreach(const TileItem* tile, m_tileItems)
+    {
+        if(tile->isRendering())
+        {
+            return true;
+        }
+    }
+
+    return m_previewTileItem != nullptr && m_previewTileItem->isRendering();
+}
+
+bool PageItem::isPrerendered() const
+{
+    return m_previewTileItem == nullptr || m_previewTileItem->isPrerendered();
+}
+
+bool PageItem::isBusy() const
+{
+    return isRendering() || (m_loadInteractiveElements != nullptr && m_loadInteractiveElements->isRunning());
+}
+
 void PageItem::setHighlights(const QList< QRectF >& highlights)
 {
     m_highlights = highlights;
@@ -255,6 +412,11 @@ void PageItem::refresh(bool keepObsoletePixmaps, bool dropCachedPixmaps)
         }
     }
 
+    if(m_previewTileItem != nullptr)
+    {
+        m_previewTileItem->refresh(keepObsoletePixmaps);
+    }
+
     if(!keepObsoletePixmaps)
     {
         prepareGeometryChange();
@@ -270,6 +432,61 @@ void PageItem::refresh(bool keepObsoletePixmaps, bool dropCachedPixmaps)
     update();
 }
 
+void PageItem::setDocumentId(const QByteArray& documentId, bool persistent)
+{
+    // The new identity is acquired first, so that setting the same one again keeps its tiles.
+    TileCache* cache = TileCache::instance();
+
+    const quint32 documentKey = cache->acquireDocument(documentId);
+    cache->releaseDocument(m_documentKey);
+    m_documentKey = documentKey;
+
+    m_documentId = documentId;
+    m_persistentDocumentId = persistent;
+}
+
+void PageItem::dropObsoletePixmaps()
+{
+    foreach(TileItem* tile, m_tileItems)
+    {
+        tile->dropObsoletePixmap();
+    }
+
+    if(m_previewTileItem != nullptr)
+    {
+        m_previewTileItem->dropObsoletePixmap();
+    }
+}
+
+qint64 PageItem::estimatedPixmapSize() const
+{
+    const qreal devicePixelRatio = m_renderParam.devicePixelRatio();
+
+    return qRound64(m_boundingRect.width() * m_boundingRect.height() * devicePixelRatio * devicePixelRatio) * 4;
+}
+
+qreal PageItem::estimatedRenderTime() const
+{
+    const qreal throughput = RenderStatistics::instance()->throughput(m_page->backendName());
+
+    return throughput > 0.0 ? estimatedPixmapSize() / 4 / throughput : 0.0;
+}
+
+bool PageItem::startPrerender()
+{
+    return m_previewTileItem != nullptr && m_previewTileItem->startPrerender() > 0;
+}
+
+bool PageItem::cancelPrerender()
+{
+    return m_previewTileItem != nullptr && m_previewTileItem->cancelPrerender();
+}
+
+qreal PageItem::estimatedPrerenderTime() const
+{
+    return estimatedRenderTime() * TileItem::previewScale() * TileItem::previewScale();
+}
+
 int PageItem::startRender(bool prefetch)
 {
     int cost = 0;
@@ -304,6 +521,11 @@ void PageItem::cancelRender()
 
         m_exposedTileItems.clear();
     }
+
+    if(m_previewTileItem != nullptr)
+    {
+        m_previewTileItem->cancelRender();
+    }
 }
 
 void PageItem::showAnnotationOverlay(Model::Annotation* selectedAnnotation)
@@ -732,6 +954,37 @@ bool PageItem::useTiling() const
     return m_paintMode != ThumbnailMode && s_settings->pageItem().useTiling();
 }
 
+bool PageItem::useProgressiveRendering() const
+{
+    return m_paintMode != ThumbnailMode && s_settings->pageItem().progressiveRendering();
+}
+
+bool PageItem::useIdlePrerendering() const
+{
+    return m_paintMode == DefaultMode && s_settings->pageItem().idlePrerendering();
+}
+
+RenderPriority PageItem::renderPriority(const QRect& tileRect, bool prefetch) const
+{
+    const RenderPriority::Class priorityClass =
+            thumbnailMode() ? RenderPriority::ThumbnailClass :
+                              prefetch ? RenderPriority::PrefetchClass : RenderPriority::VisibleClass;
+
+    qreal distance = 0.0;
+
+    if(scene() != nullptr && !scene()->views().isEmpty())
+    {
+        const QGraphicsView* view = scene()->views().first();
+
+        const QPointF viewportCenter = view->mapToScene(view->viewport()->rect().center());
+        const QPointF tileCenter = mapToScene(QRectF(tileRect).translated(m_boundingRect.topLeft()).center());
+
+        distance = QLineF(viewportCenter, tileCenter).length();
+    }
+
+    return RenderPriority(priorityClass, distance);
+}
+
 void PageItem::startLoadInteractiveElements()
 {
     if(thumbnailMode() || m_loadInteractiveElements != nullptr)
@@ -1061,35 +1314,13 @@ void PageItem::setProxyGeometry(Model::FormField* formField, QGraphicsProxyWidge
 
 void PageItem::prepareGeometry()
 {
-    m_transform.reset();
-
-    m_transform.scale(m_renderParam.resolutionX() * m_renderParam.scaleFactor() / 72.0,
-                      m_renderParam.resolutionY() * m_renderParam.scaleFactor() / 72.0);
-
-    switch(m_renderParam.rotation())
-    {
-    default:
-    case RotateBy0:
-        break;
-    case RotateBy90:
-        m_transform.rotate(90.0);
-        break;
-    case RotateBy180:
-        m_transform.rotate(180.0);
-        break;
-    case RotateBy270:
-        m_transform.rotate(270.0);
-        break;
-    }
+    m_transform = pageTransform(m_renderParam);
 
     m_normalizedTransform = m_transform;
     m_normalizedTransform.scale(m_size.width(), m_size.height());
 
 
-    m_boundingRect = m_transform.mapRect(QRectF(QPointF(), m_size));
-
-    m_boundingRect.setWidth(qRound(m_boundingRect.width()));
-    m_boundingRect.setHeight(qRound(m_boundingRect.height()));
+    m_boundingRect = uncroppedBoundingRect(m_size, m_renderParam);
 
 
     prepareTiling();
@@ -1100,6 +1331,11 @@ void PageItem::prepareGeometry()
 
 void PageItem::prepareTiling()
 {
+    if(m_previewTileItem != nullptr)
+    {
+        m_previewTileItem->setRect(TileItem::previewRect(m_boundingRect));
+    }
+
     if(!useTiling())
     {
         m_tileItems.first()->setRect(QRect(0, 0, static_cast<int>(m_boundingRect.width()), static_cast<int>(m_boundingRect.height())));
@@ -1112,7 +1348,7 @@ void PageItem::prepareTiling()
     const qreal pageHeight = m_boundingRect.height();
     const qreal pageSize = std::max(pageWidth, pageHeight);
 
-    int tileSize = s_settings->pageItem().tileSize();
+    int tileSize = this->tileSize();
 
     if(tileSize * veryLargeTilesThreshold < pageSize)
     {
@@ -1174,6 +1410,52 @@ void PageItem::prepareTiling()
     }
 }
 
+int PageItem::tileSize() const
+{
+    // in device pixels
+    int tileSize = s_settings->pageItem().tileSize();
+
+    const qreal throughput = RenderStatistics::instance()->throughput(m_page->backendName());
+
+    if(throughput > 0.0)
+    {
+        tileSize = qRound(std::sqrt(throughput * targetTileRenderTime));
+    }
+
+    // Powers of two keep the tiling and hence the cached tiles stable while the measurement fluctuates.
+    tileSize = roundToPowerOfTwo(qBound(minimumTileSize, tileSize, maximumTileSize));
+
+    // in item coordinates
+    tileSize = qMax(1, qRound(tileSize / m_renderParam.devicePixelRatio()));
+
+    if(scene() != nullptr && !scene()->views().isEmpty())
+    {
+        const QSize viewportSize = scene()->views().first()->viewport()->size();
+        const int viewportTileSize = qMax(viewportSize.width(), viewportSize.height()) / minimumTilesPerViewport;
+
+        if(viewportTileSize > 0)
+        {
+            const int minimumItemTileSize = qMax(1, qRound(minimumTileSize / m_renderParam.devicePixelRatio()));
+
+            tileSize = qMin(tileSize, qMax(minimumItemTileSize, floorToPowerOfTwo(viewportTileSize)));
+        }
+    }
+
+    return tileSize;
+}
+
+QPointF PageItem::viewportCenter(const QRectF& exposedRect) const
+{
+    if(scene() != nullptr && !scene()->views().isEmpty())
+    {
+        const QGraphicsView* view = scene()->views().first();
+
+        return mapFromScene(view->mapToScene(view->viewport()->rect().center())) - m_boundingRect.topLeft();
+    }
+
+    return exposedRect.center();
+}
+
 inline void PageItem::paintPage(QPainter* painter, const QRectF& exposedRect) const
 {
     if(s_settings->pageItem().decoratePages() && !presentationMode())
@@ -1196,7 +1478,9 @@ inline void PageItem::paintPage(QPainter* painter, const QRectF& exposedRect) co
     {
         TileItem* tile = m_tileItems.first();
 
-        if(tile->paint(painter, m_boundingRect.topLeft()))
+        const bool hasPreview = !tile->isReady() && paintPreview(painter);
+
+        if(tile->paint(painter, m_boundingRect.topLeft(), hasPreview))
         {
             tile->dropPixmap();
         }
@@ -1222,11 +1506,31 @@ inline void PageItem::paintPage(QPainter* painter, const QRectF& exposedRect) co
             }
         }
 
+        // Painting the tiles requests their rendering, so this happens in a spiral from the centre
+        // of the viewport outwards and the area the user is looking at fills in first.
+        const QVector< TileItem* > exposedTileItems = spiralOrder(m_exposedTileItems, viewportCenter(translatedExposedRect));
+
+        // The preview is painted underneath and replaced tile by tile as they become ready.
+
+        bool hasPreview = false;
+
+        if(m_previewTileItem != nullptr)
+        {
+            foreach(TileItem* tile, exposedTileItems)
+            {
+                if(!tile->isReady())
+                {
+                    hasPreview = paintPreview(painter);
+                    break;
+                }
+            }
+        }
+
         bool allExposedPainted = true;
 
-        foreach(TileItem* tile, m_exposedTileItems)
+        foreach(TileItem* tile, exposedTileItems)
         {
-            if(!tile->paint(painter, m_boundingRect.topLeft()))
+            if(!tile->paint(painter, m_boundingRect.topLeft(), hasPreview))
             {
                 allExposedPainted = false;
             }
@@ -1234,7 +1538,7 @@ inline void PageItem::paintPage(QPainter* painter, const QRectF& exposedRect) co
 
         if(allExposedPainted)
         {
-            foreach(TileItem* tile, m_exposedTileItems)
+            foreach(TileItem* tile, exposedTileItems)
             {
                 tile->dropPixmap();
             }
@@ -1255,6 +1559,22 @@ inline void PageItem::paintPage(QPainter* painter, const QRectF& exposedRect) co
     }
 }
 
+inline bool PageItem::paintPreview(QPainter* painter) const
+{
+    if(m_previewTileItem == nullptr)
+    {
+        return false;
+    }
+
+    // Without progressive rendering, only previews which were prerendered are shown.
+    if(!useProgressiveRendering() && !m_previewTileItem->isPrerendered())
+    {
+        return false;
+    }
+
+    return m_previewTileItem->paintPreview(painter, m_boundingRect);
+}
+
 inline void PageItem::paintLinks(QPainter* painter) const
 {
     if(s_settings->pageItem().decorateLinks() && !presentationMode() && !m_links.isEmpty())
@@ -44,6 +44,7 @@ class Page;
 }
 
 class Settings;
+class RenderPriority;
 class RenderTask;
 class TileItem;
 
@@ -66,15 +67,48 @@ public:
 
     const QRectF& uncroppedBoundingRect() const { return m_boundingRect; }
 
+    // These give the geometry of a page without creating its item.
+    static QRectF uncroppedBoundingRect(const QSizeF& size, const RenderParam& renderParam);
+    static QRectF croppedBoundingRect(const QRectF& boundingRect, const QRectF& cropRect);
+
     QRectF boundingRect() const override;
     void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget*) override;
 
     int index() const { return m_index; }
 
+    // Page items showing the same document identity share identical renders and cached tiles.
+    // A persistent identity stays valid across sessions, so renders can be kept on disk.
+    const QByteArray& documentId() const { return m_documentId; }
+    bool hasPersistentDocumentId() const { return m_persistentDocumentId; }
+    void setDocumentId(const QByteArray& documentId, bool persistent = false);
+
     const QSizeF& size() const { return m_size; }
 
+    // the estimated size of the pixmaps of this page in bytes and the time to render them in milliseconds
+    qint64 estimatedPixmapSize() const;
+    qreal estimatedRenderTime() const;
+
+    // Renders the low-resolution preview into the caches behind all other tasks
+    // and returns whether this was necessary.
+    bool startPrerender();
+    // Cancels the prerender of the preview if it is still queued or running and returns whether it was.
+    bool cancelPrerender();
+    qreal estimatedPrerenderTime() const;
+
     QSizeF displayedSize() const { return displayedSize(renderParam()); }
     QSizeF displayedSize(const RenderParam& renderParam) const;
+    static QSizeF displayedSize(const QSizeF& size, const QRectF& cropRect, const RenderParam& renderParam);
+
+    // the trimmed part of the page in normalized coordinates or null if margins are not trimmed
+    const QRectF& cropRect() const { return m_cropRect; }
+    // Restores the crop rectangle of an earlier item of the same page, so that its geometry does not change when it is rendered.
+    void setCropRect(const QRectF& cropRect);
+
+    bool isRendering() const;
+    // true if there is no preview or it is ready in the cache or on disk
+    bool isPrerendered() const;
+    // true if rendering or loading interactive elements, i.e. if destroying the item would block
+    bool isBusy() const;
 
     DECL_UNUSED
     const QList< QRectF >& highlights() const { return m_highlights; }
@@ -115,6 +149,7 @@ signals:
 
 public slots:
     void refresh(bool keepObsoletePixmaps = false, bool dropCachedPixmaps = false);
+    void dropObsoletePixmaps();
 
     int startRender(bool prefetch = false);
     void cancelRender();
@@ -157,10 +192,18 @@ private:
     int m_index;
     PaintMode m_paintMode;
 
+    QByteArray m_documentId;
+    bool m_persistentDocumentId;
+    quint32 m_documentKey;
+
     bool presentationMode() const;
     bool thumbnailMode() const;
 
     bool useTiling() const;
+    bool useProgressiveRendering() const;
+    bool useIdlePrerendering() const;
+
+    RenderPriority renderPriority(const QRect& tileRect, bool prefetch) const;
 
     QList< QRectF > m_highlights;
 
@@ -214,11 +257,18 @@ private:
     QVector< TileItem* > m_tileItems;
     mutable QSet< TileItem* > m_exposedTileItems;
 
+    TileItem* m_previewTileItem;
+
+    int tileSize() const;
     void prepareTiling();
 
+    // the centre of the viewport in item coordinates relative to the bounding rectangle
+    QPointF viewportCenter(const QRectF& exposedRect) const;
+
     // paint
 
     void paintPage(QPainter* painter, const QRectF& exposedRect) const;
+    bool paintPreview(QPainter* painter) const;
 
     void paintLinks(QPainter* painter) const;
     void paintFormFields(QPainter* painter) const;
@@ -24,9 +24,13 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #include "pdfmodel.h"
 
 #include <QCache>
+#include <QDateTime>
+#include <QFileInfo>
 #include <QFormLayout>
 #include <QMessageBox>
+#include <QSet>
 #include <QSettings>
+#include <QSpinBox>
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,0,0)
 
@@ -65,6 +69,36 @@ namespace
 using namespace qpdfview;
 using namespace qpdfview::Model;
 
+#ifdef HAS_POPPLER_63
+
+bool shouldAbortRender(const QVariant& closure)
+{
+    return static_cast< const CancellationToken* >(closure.value< void* >())->isCanceled();
+}
+
+#endif // HAS_POPPLER_63
+
+QImage renderPage(Poppler::Page* page, qreal horizontalResolution, qreal verticalResolution, Poppler::Page::Rotation rotate,
+                  int x, int y, int w, int h, CancellationToken* cancellation)
+{
+#ifdef HAS_POPPLER_63
+
+    if(cancellation != nullptr)
+    {
+        return page->renderToImage(horizontalResolution, verticalResolution, x, y, w, h, rotate,
+                                   nullptr, nullptr, shouldAbortRender,
+                                   QVariant::fromValue(static_cast< void* >(cancellation)));
+    }
+
+#else
+
+    Q_UNUSED(cancellation)
+
+#endif // HAS_POPPLER_63
+
+    return page->renderToImage(horizontalResolution, verticalResolution, x, y, w, h, rotate);
+}
+
 Outline loadOutline(const QVector<Poppler::OutlineItem>& outlineItems, int numPages)
 {
     Outline outline;
@@ -216,6 +250,43 @@ inline void restoreRenderHint(Poppler::Document* document, const Poppler::Docume
     document->setRenderHint(hint, hints.testFlag(hint));
 }
 
+void restoreRenderHints(Poppler::Document* document, const Poppler::Document::RenderHints hints)
+{
+    restoreRenderHint(document, hints, Poppler::Document::Antialiasing);
+    restoreRenderHint(document, hints, Poppler::Document::TextAntialiasing);
+
+#ifdef HAS_POPPLER_14
+
+    restoreRenderHint(document, hints, Poppler::Document::TextHinting);
+
+#endif // HAS_POPPLER_14
+
+#ifdef HAS_POPPLER_18
+
+    restoreRenderHint(document, hints, Poppler::Document::TextSlightHinting);
+
+#endif // HAS_POPPLER_18
+
+#ifdef HAS_POPPLER_35
+
+    restoreRenderHint(document, hints, Poppler::Document::IgnorePaperColor);
+
+#endif // HAS_POPPLER_35
+
+#ifdef HAS_POPPLER_22
+
+    restoreRenderHint(document, hints, Poppler::Document::OverprintPreview);
+
+#endif // HAS_POPPLER_22
+
+#ifdef HAS_POPPLER_24
+
+    restoreRenderHint(document, hints, Poppler::Document::ThinLineSolid);
+    restoreRenderHint(document, hints, Poppler::Document::ThinLineShape);
+
+#endif // HAS_POPPLER_24
+}
+
 typedef QSharedPointer< Poppler::TextBox > TextBox;
 typedef QList< TextBox > TextBoxList;
 
@@ -296,6 +367,9 @@ const int thinLineMode = 0;
 
 const int backend = 0;
 
+// zero renders using the primary instance of the document only
+const int renderInstances = 0;
+
 } // Defaults
 
 } // anonymous
@@ -306,9 +380,217 @@ namespace qpdfview
 namespace Model
 {
 
-PdfAnnotation::PdfAnnotation(QMutex* mutex, Poppler::Annotation* annotation) : Annotation(),
+// Keeps additional instances of a document which are loaded on demand and used by one render at a time,
+// so that renders of a large document do not contend for the primary instance.
+// Pages with modified annotations or form fields are rendered using the primary instance
+// since the additional ones do not see these modifications.
+class PdfInstancePool
+{
+public:
+    struct Instance
+    {
+        explicit Instance(Poppler::Document* document) :
+            document(document),
+            pages(8),
+            paperColor()
+        {
+        }
+
+        ~Instance()
+        {
+            pages.clear();
+
+            delete document;
+        }
+
+        Poppler::Page* page(int index)
+        {
+            Poppler::Page* page = pages.object(index);
+
+            if(page == nullptr)
+            {
+                page = document->page(index);
+
+                if(page != nullptr)
+                {
+                    pages.insert(index, page);
+                }
+            }
+
+            return page;
+        }
+
+        Poppler::Document* document;
+
+        // Tiles of the same page are likely to be rendered one after the other.
+        QCache< int, Poppler::Page > pages;
+
+        QColor paperColor;
+
+    };
+
+    PdfInstancePool(const QString& filePath, int maximumCount, Poppler::Document::RenderHints renderHints, Poppler::Document::RenderBackend renderBackend) :
+        m_filePath(filePath),
+        m_lastModified(QFileInfo(filePath).lastModified()),
+        m_maximumCount(maximumCount),
+        m_renderHints(renderHints),
+        m_renderBackend(renderBackend),
+        m_mutex(),
+        m_instances(),
+        m_freeInstances(),
+        m_loadingCount(0),
+        m_loadFailed(false),
+        m_password(),
+        m_paperColor(),
+        m_modifiedPages()
+    {
+    }
+
+    ~PdfInstancePool()
+    {
+        qDeleteAll(m_instances);
+    }
+
+    // Returns null if the page should be rendered using the primary instance.
+    Instance* acquire(int index)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        if(m_modifiedPages.contains(index))
+        {
+            return nullptr;
+        }
+
+        if(m_freeInstances.isEmpty())
+        {
+            // If all instances are busy, the primary one is shared instead of waiting for them.
+            if(m_loadFailed || m_instances.count() + m_loadingCount >= m_maximumCount)
+            {
+                return nullptr;
+            }
+
+            const QByteArray password = m_password;
+
+            ++m_loadingCount;
+
+            mutexLocker.unlock();
+
+            Instance* instance = load(password);
+
+            mutexLocker.relock();
+
+            --m_loadingCount;
+
+            if(instance == nullptr)
+            {
+                m_loadFailed = true;
+
+                return nullptr;
+            }
+
+            m_instances.append(instance);
+            m_freeInstances.append(instance);
+        }
+
+        Instance* instance = m_freeInstances.takeLast();
+
+        if(instance->paperColor != m_paperColor)
+        {
+            instance->document->setPaperColor(m_paperColor);
+            instance->paperColor = m_paperColor;
+        }
+
+        return instance;
+    }
+
+    void release(Instance* instance)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_freeInstances.append(instance);
+    }
+
+    void markModified(int index)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_modifiedPages.insert(index);
+    }
+
+    void setPassword(const QByteArray& password)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_password = password;
+    }
+
+    void setPaperColor(const QColor& paperColor)
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_paperColor = paperColor;
+    }
+
+private:
+    Q_DISABLE_COPY(PdfInstancePool)
+
+    const QString m_filePath;
+    const QDateTime m_lastModified;
+
+    const int m_maximumCount;
+
+    const Poppler::Document::RenderHints m_renderHints;
+    const Poppler::Document::RenderBackend m_renderBackend;
+
+    QMutex m_mutex;
+
+    QVector< Instance* > m_instances;
+    QVector< Instance* > m_freeInstances;
+
+    int m_loadingCount;
+    bool m_loadFailed;
+
+    QByteArray m_password;
+    QColor m_paperColor;
+
+    QSet< int > m_modifiedPages;
+
+    Instance* load(const QByteArray& password) const
+    {
+        // The additional instances have to show the same revision of the file as the primary one.
+        if(QFileInfo(m_filePath).lastModified() != m_lastModified)
+        {
+            return nullptr;
+        }
+
+        Poppler::Document* document = Poppler::Document::load(m_filePath);
+
+        if(document == nullptr)
+        {
+            return nullptr;
+        }
+
+        if(document->isLocked() && document->unlock(password, password))
+        {
+            delete document;
+
+            return nullptr;
+        }
+
+        restoreRenderHints(document, m_renderHints);
+
+        document->setRenderBackend(m_renderBackend);
+
+        return new Instance(document);
+    }
+
+};
+
+PdfAnnotation::PdfAnnotation(QMutex* mutex, Poppler::Annotation* annotation, PdfInstancePool* instancePool, int index) : Annotation(),
     m_mutex(mutex),
-    m_annotation(annotation)
+    m_annotation(annotation),
+    m_instancePool(instancePool),
+    m_index(index)
 {
 }
 
@@ -339,6 +621,7 @@ QWidget* PdfAnnotation::createWidget()
     {
         widget = new AnnotationWidget(m_mutex, m_annotation);
 
+        connect(widget, SIGNAL(wasModified()), SLOT(onWidgetModified()));
         connect(widget, SIGNAL(wasModified()), SIGNAL(wasModified()));
     }
     else if(m_annotation->subType() == Poppler::Annotation::AFileAttachment)
@@ -351,9 +634,19 @@ QWidget* PdfAnnotation::createWidget()
     return widget;
 }
 
-PdfFormField::PdfFormField(QMutex* mutex, Poppler::FormField* formField) : FormField(),
+void PdfAnnotation::onWidgetModified()
+{
+    if(m_instancePool != nullptr)
+    {
+        m_instancePool->markModified(m_index);
+    }
+}
+
+PdfFormField::PdfFormField(QMutex* mutex, Poppler::FormField* formField, PdfInstancePool* instancePool, int index) : FormField(),
     m_mutex(mutex),
-    m_formField(formField)
+    m_formField(formField),
+    m_instancePool(instancePool),
+    m_index(index)
 {
 }
 
@@ -420,14 +713,25 @@ QWidget* PdfFormField::createWidget()
         }
     }
 
+    connect(widget, SIGNAL(wasModified()), SLOT(onWidgetModified()));
     connect(widget, SIGNAL(wasModified()), SIGNAL(wasModified()));
 
     return widget;
 }
 
-PdfPage::PdfPage(QMutex* mutex, Poppler::Page* page) :
+void PdfFormField::onWidgetModified()
+{
+    if(m_instancePool != nullptr)
+    {
+        m_instancePool->markModified(m_index);
+    }
+}
+
+PdfPage::PdfPage(QMutex* mutex, Poppler::Page* page, PdfInstancePool* instancePool, int index) :
     m_mutex(mutex),
-    m_page(page)
+    m_page(page),
+    m_instancePool(instancePool),
+    m_index(index)
 {
 }
 
@@ -445,9 +749,10 @@ QSizeF PdfPage::size() const
     return m_page->pageSizeF();
 }
 
-QImage PdfPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const
+QImage PdfPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const
 {
-    LOCK_PAGE
+    // The render hints belong to the document and are shared with concurrent renders.
+    Q_UNUSED(antialiasing)
 
     Poppler::Page::Rotation rotate;
 
@@ -481,7 +786,31 @@ QImage PdfPage::render(qreal horizontalResolution, qreal verticalResolution, Rot
         h = boundingRect.height();
     }
 
-    return m_page->renderToImage(horizontalResolution, verticalResolution, x, y, w, h, rotate);
+    if(m_instancePool != nullptr)
+    {
+        if(PdfInstancePool::Instance* instance = m_instancePool->acquire(m_index))
+        {
+            QImage image;
+
+            Poppler::Page* page = instance->page(m_index);
+
+            if(page != nullptr)
+            {
+                image = renderPage(page, horizontalResolution, verticalResolution, rotate, x, y, w, h, cancellation);
+            }
+
+            m_instancePool->release(instance);
+
+            if(page != nullptr)
+            {
+                return image;
+            }
+        }
+    }
+
+    LOCK_PAGE
+
+    return renderPage(m_page, horizontalResolution, verticalResolution, rotate, x, y, w, h, cancellation);
 }
 
 QString PdfPage::label() const
@@ -677,7 +1006,7 @@ QList< Annotation* > PdfPage::annotations() const
     {
         if(annotation->subType() == Poppler::Annotation::AText || annotation->subType() == Poppler::Annotation::AHighlight || annotation->subType() == Poppler::Annotation::AFileAttachment)
         {
-            annotations.append(new PdfAnnotation(m_mutex, annotation));
+            annotations.append(new PdfAnnotation(m_mutex, annotation, m_instancePool, m_index));
             continue;
         }
 
@@ -722,7 +1051,12 @@ Annotation* PdfPage::addTextAnnotation(const QRectF& boundary, const QColor& col
 
     m_page->addAnnotation(annotation);
 
-    return new PdfAnnotation(m_mutex, annotation);
+    if(m_instancePool != nullptr)
+    {
+        m_instancePool->markModified(m_index);
+    }
+
+    return new PdfAnnotation(m_mutex, annotation, m_instancePool, m_index);
 
 #else
 
@@ -762,7 +1096,12 @@ Annotation* PdfPage::addHighlightAnnotation(const QRectF& boundary, const QColor
 
     m_page->addAnnotation(annotation);
 
-    return new PdfAnnotation(m_mutex, annotation);
+    if(m_instancePool != nullptr)
+    {
+        m_instancePool->markModified(m_index);
+    }
+
+    return new PdfAnnotation(m_mutex, annotation, m_instancePool, m_index);
 
 #else
 
@@ -786,6 +1125,11 @@ void PdfPage::removeAnnotation(Annotation* annotation)
     m_page->removeAnnotation(pdfAnnotation->m_annotation);
     pdfAnnotation->m_annotation = nullptr;
 
+    if(m_instancePool != nullptr)
+    {
+        m_instancePool->markModified(m_index);
+    }
+
 #else
 
     Q_UNUSED(annotation);
@@ -813,7 +1157,7 @@ QList< FormField* > PdfPage::formFields() const
 
             if(formFieldText->textType() == Poppler::FormFieldText::Normal || formFieldText->textType() == Poppler::FormFieldText::Multiline)
             {
-                formFields.append(new PdfFormField(m_mutex, formField));
+                formFields.append(new PdfFormField(m_mutex, formField, m_instancePool, m_index));
                 continue;
             }
         }
@@ -823,7 +1167,7 @@ QList< FormField* > PdfPage::formFields() const
 
             if(formFieldChoice->choiceType() == Poppler::FormFieldChoice::ListBox || formFieldChoice->choiceType() == Poppler::FormFieldChoice::ComboBox)
             {
-                formFields.append(new PdfFormField(m_mutex, formField));
+                formFields.append(new PdfFormField(m_mutex, formField, m_instancePool, m_index));
                 continue;
             }
         }
@@ -833,7 +1177,7 @@ QList< FormField* > PdfPage::formFields() const
 
             if(formFieldButton->buttonType() == Poppler::FormFieldButton::CheckBox || formFieldButton->buttonType() == Poppler::FormFieldButton::Radio)
             {
-                formFields.append(new PdfFormField(m_mutex, formField));
+                formFields.append(new PdfFormField(m_mutex, formField, m_instancePool, m_index));
                 continue;
             }
         }
@@ -844,14 +1188,17 @@ QList< FormField* > PdfPage::formFields() const
     return formFields;
 }
 
-PdfDocument::PdfDocument(Poppler::Document* document) :
+PdfDocument::PdfDocument(Poppler::Document* document, PdfInstancePool* instancePool) :
     m_mutex(),
-    m_document(document)
+    m_document(document),
+    m_instancePool(instancePool)
 {
 }
 
 PdfDocument::~PdfDocument()
 {
+    m_instancePool.reset();
+
     delete m_document;
 }
 
@@ -868,12 +1215,36 @@ Page* PdfDocument::page(int index) const
 
     if(Poppler::Page* page = m_document->page(index))
     {
-        return new PdfPage(&m_mutex, page);
+        return new PdfPage(&m_mutex, page, m_instancePool.data(), index);
     }
 
     return nullptr;
 }
 
+QVector< QSizeF > PdfDocument::pageSizes() const
+{
+    LOCK_DOCUMENT
+
+    // Poppler needs a page object for its size, but at least the lock is taken only once
+    // and the page objects are not kept.
+
+    const int numberOfPages = m_document->numPages();
+
+    QVector< QSizeF > sizes(numberOfPages);
+
+    for(int index = 0; index < numberOfPages; ++index)
+    {
+        const QScopedPointer< Poppler::Page > page(m_document->page(index));
+
+        if(!page.isNull())
+        {
+            sizes[index] = page->pageSizeF();
+        }
+    }
+
+    return sizes;
+}
+
 bool PdfDocument::isLocked() const
 {
     LOCK_DOCUMENT
@@ -892,42 +1263,15 @@ bool PdfDocument::unlock(const QString& password)
 
     const bool ok = m_document->unlock(password.toLatin1(), password.toLatin1());
 
-    restoreRenderHint(m_document, hints, Poppler::Document::Antialiasing);
-    restoreRenderHint(m_document, hints, Poppler::Document::TextAntialiasing);
-
-#ifdef HAS_POPPLER_14
-
-    restoreRenderHint(m_document, hints, Poppler::Document::TextHinting);
-
-#endif // HAS_POPPLER_14
-
-#ifdef HAS_POPPLER_18
-
-    restoreRenderHint(m_document, hints, Poppler::Document::TextSlightHinting);
-
-#endif // HAS_POPPLER_18
-
-#ifdef HAS_POPPLER_35
-
-    restoreRenderHint(m_document, hints, Poppler::Document::IgnorePaperColor);
-
-#endif // HAS_POPPLER_35
-
-#ifdef HAS_POPPLER_22
-
-    restoreRenderHint(m_document, hints, Poppler::Document::OverprintPreview);
-
-#endif // HAS_POPPLER_22
-
-#ifdef HAS_POPPLER_24
-
-    restoreRenderHint(m_document, hints, Poppler::Document::ThinLineSolid);
-    restoreRenderHint(m_document, hints, Poppler::Document::ThinLineShape);
-
-#endif // HAS_POPPLER_24
+    restoreRenderHints(m_document, hints);
 
     m_document->setRenderBackend(backend);
 
+    if(m_instancePool != nullptr && !m_document->isLocked())
+    {
+        m_instancePool->setPassword(password.toLatin1());
+    }
+
     return ok;
 }
 
@@ -971,6 +1315,11 @@ void PdfDocument::setPaperColor(const QColor& paperColor)
     LOCK_DOCUMENT
 
     m_document->setPaperColor(paperColor);
+
+    if(m_instancePool != nullptr)
+    {
+        m_instancePool->setPaperColor(paperColor);
+    }
 }
 
 Outline PdfDocument::outline() const
@@ -1157,6 +1506,16 @@ PdfSettingsWidget::PdfSettingsWidget(QSettings* settings, QWidget* parent) : Set
     m_backendComboBox->setCurrentIndex(m_settings->value("backend", Defaults::backend).toInt());
 
     m_layout->addRow(tr("Backend:"), m_backendComboBox);
+
+    // render instances
+
+    m_renderInstancesSpinBox = new QSpinBox(this);
+    m_renderInstancesSpinBox->setRange(0, 64);
+    m_renderInstancesSpinBox->setSpecialValueText(tr("None"));
+    m_renderInstancesSpinBox->setToolTip(tr("Additional instances of each document used to render pages concurrently. Effective after reloading the document."));
+    m_renderInstancesSpinBox->setValue(m_settings->value("renderInstances", Defaults::renderInstances).toInt());
+
+    m_layout->addRow(tr("Render instances:"), m_renderInstancesSpinBox);
 }
 
 void PdfSettingsWidget::accept()
@@ -1193,6 +1552,8 @@ void PdfSettingsWidget::accept()
 #endif // HAS_POPPLER_24
 
     m_settings->setValue("backend", m_backendComboBox->currentIndex());
+
+    m_settings->setValue("renderInstances", m_renderInstancesSpinBox->value());
 }
 
 void PdfSettingsWidget::reset()
@@ -1229,6 +1590,8 @@ void PdfSettingsWidget::reset()
 #endif // HAS_POPPLER_24
 
     m_backendComboBox->setCurrentIndex(Defaults::backend);
+
+    m_renderInstancesSpinBox->setValue(Defaults::renderInstances);
 }
 
 PdfPlugin::PdfPlugin(QObject* parent) : QObject(parent)
@@ -1240,14 +1603,17 @@ PdfPlugin::PdfPlugin(QObject* parent) : QObject(parent)
 
 Model::Document* PdfPlugin::loadDocument(const QString& filePath) const
 {
+    // A separate settings object is used as documents are loaded by several threads at once.
+    const QSettings settings(m_settings->organizationName(), m_settings->applicationName());
+
     if(Poppler::Document* document = Poppler::Document::load(filePath))
     {
-        document->setRenderHint(Poppler::Document::Antialiasing, m_settings->value("antialiasing", Defaults::antialiasing).toBool());
-        document->setRenderHint(Poppler::Document::TextAntialiasing, m_settings->value("textAntialiasing", Defaults::textAntialiasing).toBool());
+        document->setRenderHint(Poppler::Document::Antialiasing, settings.value("antialiasing", Defaults::antialiasing).toBool());
+        document->setRenderHint(Poppler::Document::TextAntialiasing, settings.value("textAntialiasing", Defaults::textAntialiasing).toBool());
 
 #if defined(HAS_POPPLER_18)
 
-        switch(m_settings->value("textHinting", Defaults::textHinting).toInt())
+        switch(settings.value("textHinting", Defaults::textHinting).toInt())
         {
         default:
         case 0:
@@ -1265,25 +1631,25 @@ Model::Document* PdfPlugin::loadDocument(const QString& filePath) const
 
 #elif defined(HAS_POPPLER_14)
 
-        document->setRenderHint(Poppler::Document::TextHinting, m_settings->value("textHinting", Defaults::textHinting).toBool());
+        document->setRenderHint(Poppler::Document::TextHinting, settings.value("textHinting", Defaults::textHinting).toBool());
 
 #endif // HAS_POPPLER_18 HAS_POPPLER_14
 
 #ifdef HAS_POPPLER_35
 
-        document->setRenderHint(Poppler::Document::IgnorePaperColor, m_settings->value("ignorePaperColor", Defaults::ignorePaperColor).toBool());
+        document->setRenderHint(Poppler::Document::IgnorePaperColor, settings.value("ignorePaperColor", Defaults::ignorePaperColor).toBool());
 
 #endif // HAS_POPPLER_35
 
 #ifdef HAS_POPPLER_22
 
-        document->setRenderHint(Poppler::Document::OverprintPreview, m_settings->value("overprintPreview", Defaults::overprintPreview).toBool());
+        document->setRenderHint(Poppler::Document::OverprintPreview, settings.value("overprintPreview", Defaults::overprintPreview).toBool());
 
 #endif // HAS_POPPLER_22
 
 #ifdef HAS_POPPLER_24
 
-        switch(m_settings->value("thinLineMode", Defaults::thinLineMode).toInt())
+        switch(settings.value("thinLineMode", Defaults::thinLineMode).toInt())
         {
         default:
         case 0:
@@ -1302,7 +1668,7 @@ Model::Document* PdfPlugin::loadDocument(const QString& filePath) const
 
 #endif // HAS_POPPLER_24
 
-        switch(m_settings->value("backend", Defaults::backend).toInt())
+        switch(settings.value("backend", Defaults::backend).toInt())
         {
         default:
         case 0:
@@ -1313,7 +1679,16 @@ Model::Document* PdfPlugin::loadDocument(const QString& filePath) const
             break;
         }
 
-        return new Model::PdfDocument(document);
+        const int renderInstances = settings.value("renderInstances", Defaults::renderInstances).toInt();
+
+        Model::PdfInstancePool* instancePool = nullptr;
+
+        if(renderInstances > 0)
+        {
+            instancePool = new Model::PdfInstancePool(filePath, renderInstances, document->renderHints(), document->renderBackend());
+        }
+
+        return new Model::PdfDocument(document, instancePool);
     }
 
     return nullptr;
@@ -31,6 +31,7 @@ class QCheckBox;
 class QComboBox;
 class QFormLayout;
 class QSettings;
+class QSpinBox;
 
 namespace Poppler
 {
@@ -49,6 +50,8 @@ class PdfPlugin;
 
 namespace Model
 {
+    class PdfInstancePool;
+
     class PdfAnnotation : public Annotation
     {
         Q_OBJECT
@@ -63,14 +66,20 @@ namespace Model
 
         QWidget* createWidget() override;
 
+    private slots:
+        void onWidgetModified();
+
     private:
         Q_DISABLE_COPY(PdfAnnotation)
 
-        PdfAnnotation(QMutex* mutex, Poppler::Annotation* annotation);
+        PdfAnnotation(QMutex* mutex, Poppler::Annotation* annotation, PdfInstancePool* instancePool, int index);
 
         mutable QMutex* m_mutex;
         Poppler::Annotation* m_annotation;
 
+        PdfInstancePool* m_instancePool;
+        int m_index;
+
     };
 
     class PdfFormField : public FormField
@@ -87,14 +96,20 @@ namespace Model
 
         QWidget* createWidget() override;
 
+    private slots:
+        void onWidgetModified();
+
     private:
         Q_DISABLE_COPY(PdfFormField)
 
-        PdfFormField(QMutex* mutex, Poppler::FormField* formField);
+        PdfFormField(QMutex* mutex, Poppler::FormField* formField, PdfInstancePool* instancePool, int index);
 
         mutable QMutex* m_mutex;
         Poppler::FormField* m_formField;
 
+        PdfInstancePool* m_instancePool;
+        int m_index;
+
     };
 
     class PdfPage final : public Page
@@ -108,7 +123,9 @@ namespace Model
 
         QSizeF size() const final;
 
-        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const final;
+        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const final;
+
+        QString backendName() const final { return QStringLiteral("Poppler"); }
 
         QString label() const final;
 
@@ -131,11 +148,14 @@ namespace Model
     private:
         Q_DISABLE_COPY(PdfPage)
 
-        PdfPage(QMutex* mutex, Poppler::Page* page);
+        PdfPage(QMutex* mutex, Poppler::Page* page, PdfInstancePool* instancePool, int index);
 
         mutable QMutex* m_mutex;
         Poppler::Page* m_page;
 
+        PdfInstancePool* m_instancePool;
+        int m_index;
+
     };
 
     class PdfDocument final : public Document
@@ -153,6 +173,9 @@ namespace Model
         DECL_NODISCARD
         Page* page(int index) const final;
 
+        DECL_NODISCARD
+        QVector< QSizeF > pageSizes() const final;
+
         DECL_NODISCARD
         bool isLocked() const final;
         DECL_NODISCARD
@@ -193,11 +216,15 @@ namespace Model
     private:
         Q_DISABLE_COPY(PdfDocument)
 
-        explicit PdfDocument(Poppler::Document* document);
+        PdfDocument(Poppler::Document* document, PdfInstancePool* instancePool);
 
         mutable QMutex m_mutex;
         Poppler::Document* m_document;
 
+        // Pages are rendered using additional instances of the document if this is enabled,
+        // while everything else, and especially annotations and form fields, use the primary one.
+        QScopedPointer< PdfInstancePool > m_instancePool;
+
     };
 }
 
@@ -251,6 +278,8 @@ private:
 
     QComboBox* m_backendComboBox;
 
+    QSpinBox* m_renderInstancesSpinBox;
+
 };
 
 class PdfPlugin final : public QObject, Plugin
@@ -474,9 +474,19 @@ QStringList PluginHandler::openFilter()
 }
 
 Model::Document* PluginHandler::loadDocument(const QString& filePath)
+{
+    QString adjustedFilePath;
+    const FileType fileType = prepareFile(filePath, adjustedFilePath);
+
+    const Plugin* const plugin = this->plugin(fileType);
+
+    return plugin != nullptr ? loadDocument(plugin, adjustedFilePath) : nullptr;
+}
+
+PluginHandler::FileType PluginHandler::prepareFile(const QString& filePath, QString& adjustedFilePath)
 {
     FileType fileType = matchFileType(filePath);
-    QString adjustedFilePath = filePath;
+    adjustedFilePath = filePath;
 
     if(fileType == GZip || fileType == BZip2 || fileType == XZ)
     {
@@ -486,7 +496,7 @@ Model::Document* PluginHandler::loadDocument(const QString& filePath)
         {
             qWarning() << tr("Could not decompress '%1'!").arg(filePath);
 
-            return nullptr;
+            return Unknown;
         }
 
         fileType = matchFileType(adjustedFilePath);
@@ -495,7 +505,15 @@ Model::Document* PluginHandler::loadDocument(const QString& filePath)
     if(fileType == Unknown)
     {
         qWarning() << tr("Could not match file type of '%1'!").arg(filePath);
+    }
+
+    return fileType;
+}
 
+Plugin* PluginHandler::plugin(FileType fileType)
+{
+    if(fileType == Unknown)
+    {
         return nullptr;
     }
 
@@ -506,7 +524,12 @@ Model::Document* PluginHandler::loadDocument(const QString& filePath)
         return nullptr;
     }
 
-    return m_plugins.value(fileType)->loadDocument(adjustedFilePath);
+    return m_plugins.value(fileType);
+}
+
+Model::Document* PluginHandler::loadDocument(const Plugin* plugin, const QString& filePath)
+{
+    return plugin->loadDocument(filePath);
 }
 
 SettingsWidget* PluginHandler::createSettingsWidget(FileType fileType, QWidget* parent)
@@ -71,6 +71,17 @@ public:
 
     Model::Document* loadDocument(const QString& filePath);
 
+    // Loading a document is split into stages so that only loading the plug-in has to happen on the main thread.
+
+    // Matches the file type and decompresses the file if necessary. This is thread-safe.
+    static FileType prepareFile(const QString& filePath, QString& adjustedFilePath);
+
+    Plugin* plugin(FileType fileType);
+
+    // This is thread-safe and documents are loaded concurrently, as the plug-ins only share
+    // thread-safe state between documents and read their settings through separate objects.
+    static Model::Document* loadDocument(const Plugin* plugin, const QString& filePath);
+
     SettingsWidget* createSettingsWidget(FileType fileType, QWidget* parent = nullptr);
 
 private:
@@ -0,0 +1,976 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "postprocessing.h"
+
+#include <algorithm>
+
+#include <QAtomicPointer>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+
+#define POSTPROCESSING_SSE2
+#define POSTPROCESSING_AVX2
+
+#define TARGET_SSE2 __attribute__((target("sse2")))
+#define TARGET_AVX2 __attribute__((target("avx2")))
+
+#include <immintrin.h>
+
+#elif defined(_MSC_VER) && (defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+
+#define POSTPROCESSING_SSE2
+
+#define TARGET_SSE2
+
+#include <emmintrin.h>
+
+#endif // __GNUC__ || _MSC_VER
+
+namespace qpdfview
+{
+
+namespace PostProcessing
+{
+
+namespace
+{
+
+const QRgb alphaMask = 0xffu << 24;
+const QRgb colorMask = 0x00ffffffu;
+
+// How the alpha channel of a 32 bit pixel is to be interpreted.
+enum PixelLayout
+{
+    OpaqueLayout, // QImage::Format_RGB32
+    StraightLayout, // QImage::Format_ARGB32
+    PremultipliedLayout // QImage::Format_ARGB32_Premultiplied
+};
+
+bool toPixelLayout(QImage::Format format, PixelLayout& layout)
+{
+    switch(format)
+    {
+    case QImage::Format_RGB32:
+        layout = OpaqueLayout;
+        return true;
+    case QImage::Format_ARGB32:
+        layout = StraightLayout;
+        return true;
+    case QImage::Format_ARGB32_Premultiplied:
+        layout = PremultipliedLayout;
+        return true;
+    default:
+        return false;
+    }
+}
+
+PixelLayout prepareImage(QImage& image)
+{
+    PixelLayout layout;
+
+    if(!toPixelLayout(image.format(), layout))
+    {
+        image = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+        layout = PremultipliedLayout;
+    }
+
+    return layout;
+}
+
+inline QRgb* pixels(QImage& image)
+{
+    return reinterpret_cast< QRgb* >(image.bits());
+}
+
+inline int pixelCount(const QImage& image)
+{
+    return static_cast< int >(image.sizeInBytes() / sizeof(QRgb));
+}
+
+// Scalar kernels which also handle the tails of the vectorized ones
+
+inline uint divideBy255(uint value)
+{
+    return (value + (value >> 8) + 0x80) >> 8;
+}
+
+inline QRgb grayscalePixel(QRgb pixel)
+{
+    const int gray = qGray(pixel);
+
+    return qRgba(gray, gray, gray, qAlpha(pixel));
+}
+
+inline QRgb invertPixel(QRgb pixel, PixelLayout layout)
+{
+    if(layout == PremultipliedLayout && qAlpha(pixel) != 255)
+    {
+        return qPremultiply(qUnpremultiply(pixel) ^ colorMask);
+    }
+
+    return pixel ^ colorMask;
+}
+
+// Matches the darken and lighten composition of the raster paint engine on premultiplied pixels.
+inline QRgb composePremultiplied(QRgb destination, QRgb source, bool darken)
+{
+    const uint destinationAlpha = qAlpha(destination);
+    const uint sourceAlpha = qAlpha(source);
+
+    auto compose = [=](uint destinationValue, uint sourceValue)
+    {
+        const uint sourceTerm = sourceValue * destinationAlpha;
+        const uint destinationTerm = destinationValue * sourceAlpha;
+
+        return divideBy255((darken ? std::min(sourceTerm, destinationTerm) : std::max(sourceTerm, destinationTerm))
+                           + sourceValue * (255 - destinationAlpha)
+                           + destinationValue * (255 - sourceAlpha));
+    };
+
+    return qRgba(compose(qRed(destination), qRed(source)),
+                 compose(qGreen(destination), qGreen(source)),
+                 compose(qBlue(destination), qBlue(source)),
+                 sourceAlpha + destinationAlpha - divideBy255(sourceAlpha * destinationAlpha));
+}
+
+inline QRgb composePixel(QRgb pixel, QRgb color, PixelLayout layout, bool darken)
+{
+    switch(layout)
+    {
+    default:
+    case OpaqueLayout:
+        return composePremultiplied(pixel | alphaMask, color, darken);
+    case StraightLayout:
+        return qUnpremultiply(composePremultiplied(qPremultiply(pixel), color, darken));
+    case PremultipliedLayout:
+        return composePremultiplied(pixel, color, darken);
+    }
+}
+
+// Follows QImage::pixel which ignores the alpha channel of opaque images and unpremultiplies.
+inline bool isPaper(QRgb pixel, QRgb paperColor, PixelLayout layout)
+{
+    switch(layout)
+    {
+    default:
+    case OpaqueLayout:
+        return (pixel | alphaMask) == paperColor;
+    case StraightLayout:
+        break;
+    case PremultipliedLayout:
+        pixel = qUnpremultiply(pixel);
+        break;
+    }
+
+    return qAlpha(pixel) == 0 || (pixel | alphaMask) == paperColor;
+}
+
+void convertToGrayscaleScalar(QRgb* pixels, int count)
+{
+    for(QRgb* end = pixels + count; pixels != end; ++pixels)
+    {
+        *pixels = grayscalePixel(*pixels);
+    }
+}
+
+void invertColorsScalar(QRgb* pixels, int count, PixelLayout layout)
+{
+    for(QRgb* end = pixels + count; pixels != end; ++pixels)
+    {
+        *pixels = invertPixel(*pixels, layout);
+    }
+}
+
+void composeWithColorScalar(QRgb* pixels, int count, QRgb color, PixelLayout layout, bool darken)
+{
+    for(QRgb* end = pixels + count; pixels != end; ++pixels)
+    {
+        *pixels = composePixel(*pixels, color, layout, darken);
+    }
+}
+
+int findFirstNonPaperScalar(const QRgb* row, int count, QRgb paperColor, PixelLayout layout)
+{
+    for(int index = 0; index < count; ++index)
+    {
+        if(!isPaper(row[index], paperColor, layout))
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+int findLastNonPaperScalar(const QRgb* row, int count, QRgb paperColor, PixelLayout layout)
+{
+    for(int index = count - 1; index >= 0; --index)
+    {
+        if(!isPaper(row[index], paperColor, layout))
+        {
+            return index;
+        }
+    }
+
+    return -1;
+}
+
+#ifdef POSTPROCESSING_SSE2
+
+// SSE2 kernels processing four pixels at a time
+
+TARGET_SSE2
+inline __m128i grayscaleSSE2(__m128i pixel)
+{
+    const __m128i byteMask = _mm_set1_epi32(0xff);
+
+    const __m128i red = _mm_and_si128(_mm_srli_epi32(pixel, 16), byteMask);
+    const __m128i green = _mm_and_si128(_mm_srli_epi32(pixel, 8), byteMask);
+    const __m128i blue = _mm_and_si128(pixel, byteMask);
+
+    // (11 * red + 16 * green + 5 * blue) / 32 as computed by qGray
+    __m128i gray = _mm_mullo_epi16(red, _mm_set1_epi32(11));
+    gray = _mm_add_epi32(gray, _mm_slli_epi32(green, 4));
+    gray = _mm_add_epi32(gray, _mm_mullo_epi16(blue, _mm_set1_epi32(5)));
+    gray = _mm_srli_epi32(gray, 5);
+
+    gray = _mm_or_si128(_mm_or_si128(_mm_slli_epi32(gray, 16), _mm_slli_epi32(gray, 8)), gray);
+
+    return _mm_or_si128(_mm_and_si128(pixel, _mm_set1_epi32(static_cast< int >(alphaMask))), gray);
+}
+
+TARGET_SSE2
+inline bool isOpaqueSSE2(__m128i pixel)
+{
+    const __m128i alpha = _mm_set1_epi32(static_cast< int >(alphaMask));
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(pixel, alpha), alpha)) == 0xffff;
+}
+
+TARGET_SSE2
+inline int paperLanesSSE2(__m128i pixel, __m128i paperColor, PixelLayout layout)
+{
+    const __m128i alpha = _mm_set1_epi32(static_cast< int >(alphaMask));
+
+    const __m128i matches = _mm_cmpeq_epi32(_mm_or_si128(pixel, alpha), paperColor);
+
+    if(layout == OpaqueLayout)
+    {
+        return _mm_movemask_epi8(matches);
+    }
+
+    const __m128i pixelAlpha = _mm_and_si128(pixel, alpha);
+    const __m128i transparent = _mm_cmpeq_epi32(pixelAlpha, _mm_setzero_si128());
+
+    if(layout == StraightLayout)
+    {
+        return _mm_movemask_epi8(_mm_or_si128(matches, transparent));
+    }
+
+    // Partially transparent premultiplied pixels are left to the scalar check.
+    const __m128i opaque = _mm_cmpeq_epi32(pixelAlpha, alpha);
+
+    return _mm_movemask_epi8(_mm_or_si128(_mm_and_si128(matches, opaque), transparent));
+}
+
+TARGET_SSE2
+void convertToGrayscaleSSE2(QRgb* pixels, int count)
+{
+    int index = 0;
+
+    for(; index + 4 <= count; index += 4)
+    {
+        auto const pointer = reinterpret_cast< __m128i* >(pixels + index);
+
+        _mm_storeu_si128(pointer, grayscaleSSE2(_mm_loadu_si128(pointer)));
+    }
+
+    convertToGrayscaleScalar(pixels + index, count - index);
+}
+
+TARGET_SSE2
+void invertColorsSSE2(QRgb* pixels, int count, PixelLayout layout)
+{
+    const __m128i mask = _mm_set1_epi32(static_cast< int >(colorMask));
+
+    int index = 0;
+
+    for(; index + 4 <= count; index += 4)
+    {
+        auto const pointer = reinterpret_cast< __m128i* >(pixels + index);
+        const __m128i pixel = _mm_loadu_si128(pointer);
+
+        if(layout == PremultipliedLayout && !isOpaqueSSE2(pixel))
+        {
+            invertColorsScalar(pixels + index, 4, layout);
+            continue;
+        }
+
+        _mm_storeu_si128(pointer, _mm_xor_si128(pixel, mask));
+    }
+
+    invertColorsScalar(pixels + index, count - index, layout);
+}
+
+TARGET_SSE2
+void composeWithColorSSE2(QRgb* pixels, int count, QRgb color, PixelLayout layout, bool darken)
+{
+    if(qAlpha(color) != 255)
+    {
+        composeWithColorScalar(pixels, count, color, layout, darken);
+        return;
+    }
+
+    // With both source and destination opaque, darken and lighten reduce to the channel-wise minimum and maximum.
+    const __m128i source = _mm_set1_epi32(static_cast< int >(color));
+    const __m128i alpha = _mm_set1_epi32(static_cast< int >(alphaMask));
+
+    int index = 0;
+
+    for(; index + 4 <= count; index += 4)
+    {
+        auto const pointer = reinterpret_cast< __m128i* >(pixels + index);
+        const __m128i pixel = _mm_loadu_si128(pointer);
+
+        if(layout != OpaqueLayout && !isOpaqueSSE2(pixel))
+        {
+            composeWithColorScalar(pixels + index, 4, color, layout, darken);
+            continue;
+        }
+
+        const __m128i result = darken ? _mm_min_epu8(pixel, source) : _mm_max_epu8(pixel, source);
+
+        _mm_storeu_si128(pointer, _mm_or_si128(result, alpha));
+    }
+
+    composeWithColorScalar(pixels + index, count - index, color, layout, darken);
+}
+
+TARGET_SSE2
+int findFirstNonPaperSSE2(const QRgb* row, int count, QRgb paperColor, PixelLayout layout)
+{
+    const __m128i paper = _mm_set1_epi32(static_cast< int >(paperColor));
+
+    int index = 0;
+
+    for(; index + 4 <= count; index += 4)
+    {
+        const __m128i pixel = _mm_loadu_si128(reinterpret_cast< const __m128i* >(row + index));
+
+        if(paperLanesSSE2(pixel, paper, layout) != 0xffff)
+        {
+            const int lane = findFirstNonPaperScalar(row + index, 4, paperColor, layout);
+
+            if(lane >= 0)
+            {
+                return index + lane;
+            }
+        }
+    }
+
+    const int lane = findFirstNonPaperScalar(row + index, count - index, paperColor, layout);
+
+    return lane >= 0 ? index + lane : -1;
+}
+
+TARGET_SSE2
+int findLastNonPaperSSE2(const QRgb* row, int count, QRgb paperColor, PixelLayout layout)
+{
+    const __m128i paper = _mm_set1_epi32(static_cast< int >(paperColor));
+
+    int index = count;
+
+    for(; index - 4 >= 0; index -= 4)
+    {
+        const __m128i pixel = _mm_loadu_si128(reinterpret_cast< const __m128i* >(row + index - 4));
+
+        if(paperLanesSSE2(pixel, paper, layout) != 0xffff)
+        {
+            const int lane = findLastNonPaperScalar(row + index - 4, 4, paperColor, layout);
+
+            if(lane >= 0)
+            {
+                return index - 4 + lane;
+            }
+        }
+    }
+
+    return findLastNonPaperScalar(row, index, paperColor, layout);
+}
+
+#endif // POSTPROCESSING_SSE2
+
+#ifdef POSTPROCESSING_AVX2
+
+// AVX2 kernels processing eight pixels at a time
+
+TARGET_AVX2
+inline __m256i grayscaleAVX2(__m256i pixel)
+{
+    const __m256i byteMask = _mm256_set1_epi32(0xff);
+
+    const __m256i red = _mm256_and_si256(_mm256_srli_epi32(pixel, 16), byteMask);
+    const __m256i green = _mm256_and_si256(_mm256_srli_epi32(pixel, 8), byteMask);
+    const __m256i blue = _mm256_and_si256(pixel, byteMask);
+
+    __m256i gray = _mm256_mullo_epi16(red, _mm256_set1_epi32(11));
+    gray = _mm256_add_epi32(gray, _mm256_slli_epi32(green, 4));
+    gray = _mm256_add_epi32(gray, _mm256_mullo_epi16(blue, _mm256_set1_epi32(5)));
+    gray = _mm256_srli_epi32(gray, 5);
+
+    gray = _mm256_or_si256(_mm256_or_si256(_mm256_slli_epi32(gray, 16), _mm256_slli_epi32(gray, 8)), gray);
+
+    return _mm256_or_si256(_mm256_and_si256(pixel, _mm256_set1_epi32(static_cast< int >(alphaMask))), gray);
+}
+
+TARGET_AVX2
+inline bool isOpaqueAVX2(__m256i pixel)
+{
+    const __m256i alpha = _mm256_set1_epi32(static_cast< int >(alphaMask));
+
+    return _mm256_movemask_epi8(_mm256_cmpeq_epi32(_mm256_and_si256(pixel, alpha), alpha)) == -1;
+}
+
+TARGET_AVX2
+inline int paperLanesAVX2(__m256i pixel, __m256i paperColor, PixelLayout layout)
+{
+    const __m256i alpha = _mm256_set1_epi32(static_cast< int >(alphaMask));
+
+    const __m256i matches = _mm256_cmpeq_epi32(_mm256_or_si256(pixel, alpha), paperColor);
+
+    if(layout == OpaqueLayout)
+    {
+        return _mm256_movemask_epi8(matches);
+    }
+
+    const __m256i pixelAlpha = _mm256_and_si256(pixel, alpha);
+    const __m256i transparent = _mm256_cmpeq_epi32(pixelAlpha, _mm256_setzero_si256());
+
+    if(layout == StraightLayout)
+    {
+        return _mm256_movemask_epi8(_mm256_or_si256(matches, transparent));
+    }
+
+    const __m256i opaque = _mm256_cmpeq_epi32(pixelAlpha, alpha);
+
+    return _mm256_movemask_epi8(_mm256_or_si256(_mm256_and_si256(matches, opaque), transparent));
+}
+
+TARGET_AVX2
+void convertToGrayscaleAVX2(QRgb* pixels, int count)
+{
+    int index = 0;
+
+    for(; index + 8 <= count; index += 8)
+    {
+        auto const pointer = reinterpret_cast< __m256i* >(pixels + index);
+
+        _mm256_storeu_si256(pointer, grayscaleAVX2(_mm256_loadu_si256(pointer)));
+    }
+
+    convertToGrayscaleScalar(pixels + index, count - index);
+}
+
+TARGET_AVX2
+void invertColorsAVX2(QRgb* pixels, int count, PixelLayout layout)
+{
+    const __m256i mask = _mm256_set1_epi32(static_cast< int >(colorMask));
+
+    int index = 0;
+
+    for(; index + 8 <= count; index += 8)
+    {
+        auto const pointer = reinterpret_cast< __m256i* >(pixels + index);
+        const __m256i pixel = _mm256_loadu_si256(pointer);
+
+        if(layout == PremultipliedLayout && !isOpaqueAVX2(pixel))
+        {
+            invertColorsScalar(pixels + index, 8, layout);
+            continue;
+        }
+
+        _mm256_storeu_si256(pointer, _mm256_xor_si256(pixel, mask));
+    }
+
+    invertColorsScalar(pixels + index, count - index, layout);
+}
+
+TARGET_AVX2
+void composeWithColorAVX2(QRgb* pixels, int count, QRgb color, PixelLayout layout, bool darken)
+{
+    if(qAlpha(color) != 255)
+    {
+        composeWithColorScalar(pixels, count, color, layout, darken);
+        return;
+    }
+
+    const __m256i source = _mm256_set1_epi32(static_cast< int >(color));
+    const __m256i alpha = _mm256_set1_epi32(static_cast< int >(alphaMask));
+
+    int index = 0;
+
+    for(; index + 8 <= count; index += 8)
+    {
+        auto const pointer = reinterpret_cast< __m256i* >(pixels + index);
+        const __m256i pixel = _mm256_loadu_si256(pointer);
+
+        if(layout != OpaqueLayout && !isOpaqueAVX2(pixel))
+        {
+            composeWithColorScalar(pixels + index, 8, color, layout, darken);
+            continue;
+        }
+
+        const __m256i result = darken ? _mm256_min_epu8(pixel, source) : _mm256_max_epu8(pixel, source);
+
+        _mm256_storeu_si256(pointer, _mm256_or_si256(result, alpha));
+    }
+
+    composeWithColorScalar(pixels + index, count - index, color, layout, darken);
+}
+
+TARGET_AVX2
+int findFirstNonPaperAVX2(const QRgb* row, int count, QRgb paperColor, PixelLayout layout)
+{
+    const __m256i paper = _mm256_set1_epi32(static_cast< int >(paperColor));
+
+    int index = 0;
+
+    for(; index + 8 <= count; index += 8)
+    {
+        const __m256i pixel = _mm256_loadu_si256(reinterpret_cast< const __m256i* >(row + index));
+
+        if(paperLanesAVX2(pixel, paper, layout) != -1)
+        {
+            const int lane = findFirstNonPaperScalar(row + index, 8, paperColor, layout);
+
+            if(lane >= 0)
+            {
+                return index + lane;
+            }
+        }
+    }
+
+    const int lane = findFirstNonPaperScalar(row + index, count - index, paperColor, layout);
+
+    return lane >= 0 ? index + lane : -1;
+}
+
+TARGET_AVX2
+int findLastNonPaperAVX2(const QRgb* row, int count, QRgb paperColor, PixelLayout layout)
+{
+    const __m256i paper = _mm256_set1_epi32(static_cast< int >(paperColor));
+
+    int index = count;
+
+    for(; index - 8 >= 0; index -= 8)
+    {
+        const __m256i pixel = _mm256_loadu_si256(reinterpret_cast< const __m256i* >(row + index - 8));
+
+        if(paperLanesAVX2(pixel, paper, layout) != -1)
+        {
+            const int lane = findLastNonPaperScalar(row + index - 8, 8, paperColor, layout);
+
+            if(lane >= 0)
+            {
+                return index - 8 + lane;
+            }
+        }
+    }
+
+    return findLastNonPaperScalar(row, index, paperColor, layout);
+}
+
+#endif // POSTPROCESSING_AVX2
+
+struct Kernels
+{
+    InstructionSet instructionSet;
+
+    void (*convertToGrayscale)(QRgb* pixels, int count);
+    void (*invertColors)(QRgb* pixels, int count, PixelLayout layout);
+    void (*composeWithColor)(QRgb* pixels, int count, QRgb color, PixelLayout layout, bool darken);
+
+    int (*findFirstNonPaper)(const QRgb* row, int count, QRgb paperColor, PixelLayout layout);
+    int (*findLastNonPaper)(const QRgb* row, int count, QRgb paperColor, PixelLayout layout);
+};
+
+const Kernels scalarKernels =
+{
+    ScalarInstructions,
+    convertToGrayscaleScalar,
+    invertColorsScalar,
+    composeWithColorScalar,
+    findFirstNonPaperScalar,
+    findLastNonPaperScalar
+};
+
+#ifdef POSTPROCESSING_SSE2
+
+const Kernels sse2Kernels =
+{
+    SSE2Instructions,
+    convertToGrayscaleSSE2,
+    invertColorsSSE2,
+    composeWithColorSSE2,
+    findFirstNonPaperSSE2,
+    findLastNonPaperSSE2
+};
+
+#endif // POSTPROCESSING_SSE2
+
+#ifdef POSTPROCESSING_AVX2
+
+const Kernels avx2Kernels =
+{
+    AVX2Instructions,
+    convertToGrayscaleAVX2,
+    invertColorsAVX2,
+    composeWithColorAVX2,
+    findFirstNonPaperAVX2,
+    findLastNonPaperAVX2
+};
+
+#endif // POSTPROCESSING_AVX2
+
+InstructionSet detectInstructionSet()
+{
+#if defined(__GNUC__) && defined(POSTPROCESSING_SSE2)
+
+    __builtin_cpu_init();
+
+#ifdef POSTPROCESSING_AVX2
+
+    if(__builtin_cpu_supports("avx2"))
+    {
+        return AVX2Instructions;
+    }
+
+#endif // POSTPROCESSING_AVX2
+
+    if(__builtin_cpu_supports("sse2"))
+    {
+        return SSE2Instructions;
+    }
+
+#elif defined(POSTPROCESSING_SSE2)
+
+    return SSE2Instructions;
+
+#endif // __GNUC__ && POSTPROCESSING_SSE2
+
+    return ScalarInstructions;
+}
+
+const Kernels* kernelsFor(InstructionSet instructionSet)
+{
+    switch(std::min(instructionSet, supportedInstructionSet()))
+    {
+    default:
+    case ScalarInstructions:
+        return &scalarKernels;
+#ifdef POSTPROCESSING_SSE2
+    case SSE2Instructions:
+        return &sse2Kernels;
+#endif // POSTPROCESSING_SSE2
+#ifdef POSTPROCESSING_AVX2
+    case AVX2Instructions:
+        return &avx2Kernels;
+#endif // POSTPROCESSING_AVX2
+    }
+}
+
+QAtomicPointer< const Kernels > currentKernels;
+
+const Kernels* kernels()
+{
+    const Kernels* kernels = currentKernels.loadAcquire();
+
+    if(kernels == nullptr)
+    {
+        kernels = kernelsFor(supportedInstructionSet());
+
+        currentKernels.testAndSetOrdered(nullptr, kernels);
+    }
+
+    return kernels;
+}
+
+void composeWithColor(QImage& image, QRgb color, bool darken)
+{
+    if(image.isNull())
+    {
+        return;
+    }
+
+    const PixelLayout layout = prepareImage(image);
+
+    kernels()->composeWithColor(pixels(image), pixelCount(image), qPremultiply(color), layout, darken);
+}
+
+// The number of pixels processed per band by the pipeline, i.e. 256 KiB worth of pixels
+const int bandSize = 64 * 1024;
+
+// Accumulates the bounding box of all non-paper pixels row by row
+// instead of walking the image column by column.
+class MarginStatistics
+{
+public:
+    MarginStatistics(int width, int height) :
+        m_width(width),
+        m_height(height),
+        m_left(width),
+        m_right(-1),
+        m_top(height),
+        m_bottom(-1)
+    {
+    }
+
+    void addRow(const Kernels* kernels, int y, const QRgb* row, QRgb paperColor, PixelLayout layout)
+    {
+        const int first = kernels->findFirstNonPaper(row, m_width, paperColor, layout);
+
+        if(first < 0)
+        {
+            return;
+        }
+
+        m_top = std::min(m_top, y);
+        m_bottom = std::max(m_bottom, y);
+
+        m_left = std::min(m_left, first);
+
+        // Only pixels right of the current right edge can still extend it.
+        const int from = std::max(first, m_right + 1);
+        const int last = kernels->findLastNonPaper(row + from, m_width - from, paperColor, layout);
+
+        if(last >= 0)
+        {
+            m_right = from + last;
+        }
+    }
+
+    QRectF cropRect() const
+    {
+        int left = std::min(m_left, m_width / 3);
+        int right = std::max(m_right, 2 * m_width / 3);
+
+        int top = std::min(m_top, m_height / 3);
+        int bottom = std::max(m_bottom, 2 * m_height / 3);
+
+        left = std::max(left - m_width / 100, 0);
+        top = std::max(top - m_height / 100, 0);
+
+        right = std::min(right + m_width / 100, m_width);
+        bottom = std::min(bottom + m_height / 100, m_height);
+
+        return {static_cast< qreal >(left) / m_width,
+                static_cast< qreal >(top) / m_height,
+                static_cast< qreal >(right - left) / m_width,
+                static_cast< qreal >(bottom - top) / m_height};
+    }
+
+private:
+    int m_width;
+    int m_height;
+
+    int m_left;
+    int m_right;
+    int m_top;
+    int m_bottom;
+
+};
+
+} // anonymous
+
+InstructionSet supportedInstructionSet()
+{
+    static const InstructionSet instructionSet = detectInstructionSet();
+
+    return instructionSet;
+}
+
+InstructionSet instructionSet()
+{
+    return kernels()->instructionSet;
+}
+
+void setInstructionSet(InstructionSet instructionSet)
+{
+    currentKernels.storeRelease(kernelsFor(instructionSet));
+}
+
+const char* instructionSetName(InstructionSet instructionSet)
+{
+    switch(instructionSet)
+    {
+    default:
+    case ScalarInstructions:
+        return "scalar";
+    case SSE2Instructions:
+        return "SSE2";
+    case AVX2Instructions:
+        return "AVX2";
+    }
+}
+
+void convertToGrayscale(QImage& image)
+{
+    if(image.isNull())
+    {
+        return;
+    }
+
+    prepareImage(image);
+
+    kernels()->convertToGrayscale(pixels(image), pixelCount(image));
+}
+
+void invertColors(QImage& image)
+{
+    if(image.isNull())
+    {
+        return;
+    }
+
+    const PixelLayout layout = prepareImage(image);
+
+    kernels()->invertColors(pixels(image), pixelCount(image), layout);
+}
+
+void darkenWithColor(QImage& image, QRgb color)
+{
+    composeWithColor(image, color, true);
+}
+
+void lightenWithColor(QImage& image, QRgb color)
+{
+    composeWithColor(image, color, false);
+}
+
+QRectF trimMargins(QRgb paperColor, const QImage& image)
+{
+    if(image.isNull())
+    {
+        return {0.0, 0.0, 1.0, 1.0};
+    }
+
+    QImage source = image;
+    const PixelLayout layout = prepareImage(source);
+
+    const Kernels* const kernels = PostProcessing::kernels();
+
+    paperColor |= alphaMask;
+
+    const int width = source.width();
+    const int height = source.height();
+
+    MarginStatistics statistics(width, height);
+
+    for(int y = 0; y < height; ++y)
+    {
+        statistics.addRow(kernels, y, reinterpret_cast< const QRgb* >(source.constScanLine(y)), paperColor, layout);
+    }
+
+    return statistics.cropRect();
+}
+
+Pipeline::Pipeline(RenderFlags flags, QRgb paperColor) :
+    m_compose(flags.testFlag(DarkenWithPaperColor) || flags.testFlag(LightenWithPaperColor)),
+    m_darken(flags.testFlag(DarkenWithPaperColor)),
+    m_trimMargins(flags.testFlag(TrimMargins)),
+    m_convertToGrayscale(flags.testFlag(ConvertToGrayscale)),
+    m_invertColors(flags.testFlag(InvertColors)),
+    m_color(qPremultiply(paperColor)),
+    m_paperColor(paperColor | alphaMask)
+{
+}
+
+bool Pipeline::run(QImage& image, QRectF& cropRect, const std::function< bool() >& canceled) const
+{
+    if(image.isNull() || isEmpty())
+    {
+        return true;
+    }
+
+    const PixelLayout layout = prepareImage(image);
+
+    const Kernels* const kernels = PostProcessing::kernels();
+
+    const int width = image.width();
+    const int height = image.height();
+    const qsizetype bytesPerLine = image.bytesPerLine();
+
+    uchar* const bits = image.bits();
+
+    MarginStatistics statistics(width, height);
+
+    // Bands of rows small enough to stay cached between the stages
+    const int bandHeight = std::max(1, bandSize / std::max(1, width));
+
+    for(int band = 0; band < height; band += bandHeight)
+    {
+        if(canceled && canceled())
+        {
+            return false;
+        }
+
+        const int bandEnd = std::min(band + bandHeight, height);
+
+        for(int y = band; y < bandEnd; ++y)
+        {
+            auto const row = reinterpret_cast< QRgb* >(bits + y * bytesPerLine);
+
+            // The stages are applied in the order in which RenderTask used to apply them one image at a time.
+
+            if(m_compose)
+            {
+                kernels->composeWithColor(row, width, m_color, layout, m_darken);
+            }
+
+            if(m_trimMargins)
+            {
+                statistics.addRow(kernels, y, row, m_paperColor, layout);
+            }
+
+            if(m_convertToGrayscale)
+            {
+                kernels->convertToGrayscale(row, width);
+            }
+
+            if(m_invertColors)
+            {
+                kernels->invertColors(row, width, layout);
+            }
+        }
+    }
+
+    if(m_trimMargins)
+    {
+        cropRect = statistics.cropRect();
+    }
+
+    return true;
+}
+
+} // PostProcessing
+
+} // qpdfview
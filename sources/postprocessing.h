@@ -0,0 +1,101 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef POSTPROCESSING_H
+#define POSTPROCESSING_H
+
+#include <functional>
+
+#include <QImage>
+#include <QRectF>
+
+#include "renderparam.h"
+
+namespace qpdfview
+{
+
+namespace PostProcessing
+{
+
+enum InstructionSet
+{
+    ScalarInstructions = 0,
+    SSE2Instructions = 1,
+    AVX2Instructions = 2
+};
+
+// The best instruction set supported by the running processor.
+DECL_NODISCARD
+InstructionSet supportedInstructionSet();
+
+// The instruction set used by the kernels below which defaults to the supported one.
+DECL_NODISCARD
+InstructionSet instructionSet();
+// Selects the kernels for a specific instruction set, e.g. for benchmarking.
+// Unsupported instruction sets are downgraded to the supported one.
+void setInstructionSet(InstructionSet instructionSet);
+
+DECL_NODISCARD
+const char* instructionSetName(InstructionSet instructionSet);
+
+// The kernels below work in-place on 32 bit images and convert any other format to
+// QImage::Format_ARGB32_Premultiplied first. They yield the same pixels as the QPainter and QImage
+// operations they replace.
+
+void convertToGrayscale(QImage& image);
+void invertColors(QImage& image);
+
+void darkenWithColor(QImage& image, QRgb color);
+void lightenWithColor(QImage& image, QRgb color);
+
+DECL_NODISCARD
+QRectF trimMargins(QRgb paperColor, const QImage& image);
+
+// Applies the post-processing enabled by the render flags in a single row-major sweep,
+// i.e. each band of rows is composed, scanned for margins, converted and inverted while it is still cached.
+class Pipeline
+{
+public:
+    Pipeline(RenderFlags flags, QRgb paperColor);
+
+    DECL_NODISCARD
+    bool isEmpty() const { return !m_compose && !m_trimMargins && !m_convertToGrayscale && !m_invertColors; }
+
+    // Returns false if the sweep was aborted because canceled returned true between two bands.
+    bool run(QImage& image, QRectF& cropRect, const std::function< bool() >& canceled) const;
+
+private:
+    bool m_compose;
+    bool m_darken;
+    bool m_trimMargins;
+    bool m_convertToGrayscale;
+    bool m_invertColors;
+
+    QRgb m_color;
+    QRgb m_paperColor;
+
+};
+
+} // PostProcessing
+
+} // qpdfview
+
+#endif // POSTPROCESSING_H
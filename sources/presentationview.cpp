@@ -50,9 +50,10 @@ namespace qpdfview
 
 Settings* PresentationView::s_settings = nullptr;
 
-PresentationView::PresentationView(const QVector< Model::Page* >& pages, QWidget* parent) : QGraphicsView(parent),
+PresentationView::PresentationView(const QVector< Model::Page* >& pages, const QByteArray& documentId, QWidget* parent) : QGraphicsView(parent),
     m_prefetchTimer(nullptr),
     m_pages(pages),
+    m_documentId(documentId),
     m_currentPage(1),
     m_past(),
     m_future(),
@@ -546,6 +547,8 @@ void PresentationView::preparePages()
     {
         auto page = new PageItem(m_pages.at(index), index, PageItem::PresentationMode);
 
+        page->setDocumentId(m_documentId);
+
         scene()->addItem(page);
         m_pageItems.append(page);
 
@@ -42,7 +42,7 @@ class PresentationView final : public QGraphicsView
     Q_OBJECT
 
 public:
-    explicit PresentationView(const QVector< Model::Page* >& pages, QWidget* parent = nullptr);
+    explicit PresentationView(const QVector< Model::Page* >& pages, const QByteArray& documentId = QByteArray(), QWidget* parent = nullptr);
     ~PresentationView() final;
 
     DECL_NODISCARD
@@ -116,6 +116,7 @@ private:
     QTimer* m_prefetchTimer;
 
     QVector< Model::Page* > m_pages;
+    QByteArray m_documentId;
 
     int m_currentPage;
 
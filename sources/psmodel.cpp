@@ -77,8 +77,10 @@ QSizeF PsPage::size() const
     return {w * 1.0, h * 1.0};
 }
 
-QImage PsPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const
+QImage PsPage::render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const
 {
+    Q_UNUSED(cancellation)
+
     QMutexLocker mutexLocker(m_mutex);
 
     double xscale;
@@ -134,8 +136,22 @@ QImage PsPage::render(qreal horizontalResolution, qreal verticalResolution, Rota
     unsigned char* pageData = nullptr;
     int rowLength = 0;
 
+    int graphicsAntialiasBits = 0;
+    int textAntialiasBits = 0;
+
+    if(!antialiasing)
+    {
+        spectre_render_context_get_antialias_bits(m_renderContext, &graphicsAntialiasBits, &textAntialiasBits);
+        spectre_render_context_set_antialias_bits(m_renderContext, 1, 1);
+    }
+
     spectre_page_render(m_page, m_renderContext, &pageData, &rowLength);
 
+    if(!antialiasing)
+    {
+        spectre_render_context_set_antialias_bits(m_renderContext, graphicsAntialiasBits, textAntialiasBits);
+    }
+
     if (spectre_page_status(m_page) != SPECTRE_STATUS_SUCCESS)
     {
         free(pageData);
@@ -291,6 +307,9 @@ PsPlugin::PsPlugin(QObject* parent) : QObject(parent)
 
 Model::Document* PsPlugin::loadDocument(const QString& filePath) const
 {
+    // A separate settings object is used as documents are loaded by several threads at once.
+    const QSettings settings(m_settings->organizationName(), m_settings->applicationName());
+
     SpectreDocument* document = spectre_document_new();
 
     spectre_document_load(document, QFile::encodeName(filePath));
@@ -305,8 +324,8 @@ Model::Document* PsPlugin::loadDocument(const QString& filePath) const
     SpectreRenderContext* renderContext = spectre_render_context_new();
 
     spectre_render_context_set_antialias_bits(renderContext,
-                                              m_settings->value("graphicsAntialiasBits", Defaults::graphicsAntialiasBits).toInt(),
-                                              m_settings->value("textAntialiasBits", Defaults::textAntialiasBits).toInt());
+                                              settings.value("graphicsAntialiasBits", Defaults::graphicsAntialiasBits).toInt(),
+                                              settings.value("textAntialiasBits", Defaults::textAntialiasBits).toInt());
 
     return new Model::PsDocument(document, renderContext);
 }
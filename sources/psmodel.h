@@ -52,7 +52,9 @@ namespace Model
 
         QSizeF size() const final;
 
-        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect) const final;
+        QImage render(qreal horizontalResolution, qreal verticalResolution, Rotation rotation, QRect boundingRect, CancellationToken* cancellation, bool antialiasing) const final;
+
+        QString backendName() const final { return QStringLiteral("libspectre"); }
 
     private:
         Q_DISABLE_COPY(PsPage)
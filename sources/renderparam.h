@@ -35,7 +35,8 @@ enum RenderFlag
     ConvertToGrayscale = 1 << 1,
     TrimMargins = 1 << 2,
     DarkenWithPaperColor = 1 << 3,
-    LightenWithPaperColor = 1 << 4
+    LightenWithPaperColor = 1 << 4,
+    DisableAntialiasing = 1 << 5
 };
 
 Q_DECLARE_FLAGS(RenderFlags, RenderFlag)
@@ -120,6 +121,11 @@ public:
     DECL_UNUSED
     void setLightenWithPaperColor(bool lightenWithPaperColor) { setFlag(LightenWithPaperColor, lightenWithPaperColor); }
 
+    DECL_NODISCARD
+    bool disableAntialiasing() const { return d->flags.testFlag(DisableAntialiasing); }
+    DECL_UNUSED
+    void setDisableAntialiasing(bool disableAntialiasing) { setFlag(DisableAntialiasing, disableAntialiasing); }
+
     bool operator==(const RenderParam& other) const
     {
         if(d == other.d)
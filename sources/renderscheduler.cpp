@@ -0,0 +1,523 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "renderscheduler.h"
+
+#include <QApplication>
+#include <QThread>
+
+#include "rendertask.h"
+#include "settings.h"
+
+namespace qpdfview
+{
+
+class RenderScheduler::Worker : public QThread
+{
+public:
+    explicit Worker(RenderScheduler* scheduler) : QThread(),
+        m_scheduler(scheduler)
+    {
+        setObjectName(QStringLiteral("RenderWorker"));
+    }
+
+protected:
+    void run() override
+    {
+        while(RenderTask* task = m_scheduler->take())
+        {
+            task->run();
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(Worker)
+
+    RenderScheduler* m_scheduler;
+
+};
+
+RenderScheduler* RenderScheduler::s_instance = nullptr;
+
+Settings* RenderScheduler::s_settings = nullptr;
+
+RenderScheduler* RenderScheduler::instance()
+{
+    if(s_instance == nullptr)
+    {
+        s_instance = new RenderScheduler(qApp);
+    }
+
+    return s_instance;
+}
+
+RenderScheduler::~RenderScheduler()
+{
+    m_mutex.lock();
+
+    m_quit = true;
+
+    const QList< RenderTask* > tasks = m_queue.keys() + m_followers.keys();
+    m_queue.clear();
+    m_order.clear();
+    m_backgroundCount = 0;
+    m_leaders.clear();
+    m_followers.clear();
+    m_followersByLeader.clear();
+
+    m_mutex.unlock();
+
+    m_queueNotEmpty.wakeAll();
+
+    foreach(RenderTask* task, tasks)
+    {
+        task->setCancellation(true);
+        task->finish(true);
+    }
+
+    foreach(Worker* worker, m_workers)
+    {
+        worker->wait();
+    }
+
+    qDeleteAll(m_workers);
+
+    s_instance = nullptr;
+}
+
+int RenderScheduler::workerCount() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_activeWorkerCount;
+}
+
+int RenderScheduler::queuedCount() const
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_queue.count();
+}
+
+void RenderScheduler::schedule(RenderTask* task, const RenderPriority& priority)
+{
+    adjustWorkers();
+
+    m_mutex.lock();
+
+    const TileCacheKey& sharingKey = task->m_sharingKey;
+
+    if(!sharingKey.isNull())
+    {
+        RenderTask* const leader = m_leaders.value(sharingKey);
+
+        if(leader != nullptr && leader != task)
+        {
+            addFollower(task, leader, Entry{priority, m_sequence++});
+
+            const auto entry = m_queue.find(leader);
+
+            if(entry != m_queue.end() && priority < entry->priority)
+            {
+                setPriority(entry, priority);
+            }
+
+            m_mutex.unlock();
+
+            return;
+        }
+
+        m_leaders.insert(sharingKey, task);
+    }
+
+    enqueue(task, Entry{priority, m_sequence++});
+
+    const QVector< RenderTask* > discardedTasks = trimQueue();
+
+    m_mutex.unlock();
+
+    m_queueNotEmpty.wakeOne();
+
+    foreach(RenderTask* discardedTask, discardedTasks)
+    {
+        discardedTask->setCancellation(true);
+        discardedTask->finish(true);
+    }
+}
+
+bool RenderScheduler::reprioritize(RenderTask* task, const RenderPriority& priority)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    const auto follower = m_followers.find(task);
+
+    if(follower != m_followers.end())
+    {
+        follower->entry.priority = priority;
+
+        const auto entry = m_queue.find(follower->leader);
+
+        if(entry != m_queue.end() && priority < entry->priority)
+        {
+            setPriority(entry, priority);
+        }
+
+        return true;
+    }
+
+    const auto entry = m_queue.find(task);
+
+    if(entry == m_queue.end())
+    {
+        return false;
+    }
+
+    setPriority(entry, mostUrgentPriority(task, priority));
+
+    return true;
+}
+
+bool RenderScheduler::demote(RenderTask* task, const RenderPriority& priority)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    const auto follower = m_followers.find(task);
+
+    if(follower != m_followers.end())
+    {
+        follower->entry.priority = priority;
+
+        task->m_prefetch = true;
+
+        return true;
+    }
+
+    const auto entry = m_queue.find(task);
+
+    if(entry == m_queue.end())
+    {
+        return false;
+    }
+
+    // A leader keeps the priority of its most urgent follower.
+    setPriority(entry, mostUrgentPriority(task, priority));
+
+    // The task has not started yet, so it can still be turned into a prefetch
+    // whose result goes into the cache instead of being thrown away.
+    task->m_prefetch = true;
+
+    return true;
+}
+
+bool RenderScheduler::unschedule(RenderTask* task)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    const auto entry = m_queue.find(task);
+
+    if(entry != m_queue.end())
+    {
+        dequeue(entry);
+
+        return true;
+    }
+
+    return removeFollower(task);
+}
+
+QVector< RenderTask* > RenderScheduler::share(RenderTask* task)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    if(task->m_sharingKey.isNull() || m_leaders.value(task->m_sharingKey) != task)
+    {
+        return {};
+    }
+
+    m_leaders.remove(task->m_sharingKey);
+
+    return takeFollowers(task);
+}
+
+void RenderScheduler::retire(RenderTask* task)
+{
+    m_mutex.lock();
+
+    removeFollower(task);
+
+    if(task->m_sharingKey.isNull() || m_leaders.value(task->m_sharingKey) != task)
+    {
+        m_mutex.unlock();
+
+        return;
+    }
+
+    m_leaders.remove(task->m_sharingKey);
+
+    RenderTask* nextLeader = nullptr;
+    Entry nextEntry{RenderPriority(), 0};
+
+    for(auto follower = m_followersByLeader.constFind(task); follower != m_followersByLeader.constEnd() && follower.key() == task; ++follower)
+    {
+        const Entry& entry = m_followers.find(follower.value())->entry;
+
+        if(nextLeader == nullptr || entry < nextEntry)
+        {
+            nextLeader = follower.value();
+            nextEntry = entry;
+        }
+    }
+
+    if(nextLeader == nullptr)
+    {
+        m_mutex.unlock();
+
+        return;
+    }
+
+    removeFollower(nextLeader);
+
+    const QList< RenderTask* > followers = m_followersByLeader.values(task);
+    m_followersByLeader.remove(task);
+
+    foreach(RenderTask* follower, followers)
+    {
+        m_followers[follower].leader = nextLeader;
+        m_followersByLeader.insert(nextLeader, follower);
+    }
+
+    m_leaders.insert(nextLeader->m_sharingKey, nextLeader);
+    enqueue(nextLeader, nextEntry);
+
+    m_mutex.unlock();
+
+    m_queueNotEmpty.wakeOne();
+}
+
+RenderScheduler::RenderScheduler(QObject* parent) : QObject(parent),
+    m_workers(),
+    m_mutex(),
+    m_queueNotEmpty(),
+    m_queue(),
+    m_sequence(0),
+    m_order(),
+    m_backgroundCount(0),
+    m_leaders(),
+    m_followers(),
+    m_followersByLeader(),
+    m_activeWorkerCount(0),
+    m_targetWorkerCount(0),
+    m_quit(false)
+{
+    if(s_settings == nullptr)
+    {
+        s_settings = Settings::instance();
+    }
+}
+
+void RenderScheduler::adjustWorkers()
+{
+    int targetWorkerCount = s_settings->pageItem().renderThreadCount();
+
+    if(targetWorkerCount <= 0)
+    {
+        targetWorkerCount = qMax(1, QThread::idealThreadCount());
+    }
+
+    for(auto worker = m_workers.begin(); worker != m_workers.end();)
+    {
+        if((*worker)->isFinished())
+        {
+            delete *worker;
+            worker = m_workers.erase(worker);
+        }
+        else
+        {
+            ++worker;
+        }
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_targetWorkerCount = targetWorkerCount;
+
+    if(m_activeWorkerCount > m_targetWorkerCount)
+    {
+        // Surplus workers exit the next time they look for a task.
+        m_queueNotEmpty.wakeAll();
+    }
+
+    for(; m_activeWorkerCount < m_targetWorkerCount; ++m_activeWorkerCount)
+    {
+        auto worker = new Worker(this);
+        m_workers.append(worker);
+
+        worker->start();
+    }
+}
+
+RenderTask* RenderScheduler::take()
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    while(true)
+    {
+        if(m_quit)
+        {
+            return nullptr;
+        }
+
+        if(m_activeWorkerCount > m_targetWorkerCount)
+        {
+            --m_activeWorkerCount;
+
+            return nullptr;
+        }
+
+        if(!m_queue.isEmpty())
+        {
+            break;
+        }
+
+        m_queueNotEmpty.wait(&m_mutex);
+    }
+
+    RenderTask* task = m_order.first();
+    dequeue(m_queue.find(task));
+
+    return task;
+}
+
+void RenderScheduler::enqueue(RenderTask* task, const Entry& entry)
+{
+    m_queue.insert(task, entry);
+    m_order.insert(entry, task);
+
+    if(entry.isBackground())
+    {
+        ++m_backgroundCount;
+    }
+}
+
+void RenderScheduler::dequeue(QHash< RenderTask*, Entry >::iterator entry)
+{
+    m_order.remove(*entry);
+
+    if(entry->isBackground())
+    {
+        --m_backgroundCount;
+    }
+
+    m_queue.erase(entry);
+}
+
+void RenderScheduler::setPriority(QHash< RenderTask*, Entry >::iterator entry, const RenderPriority& priority)
+{
+    m_order.remove(*entry);
+
+    if(entry->isBackground())
+    {
+        --m_backgroundCount;
+    }
+
+    entry->priority = priority;
+
+    m_order.insert(*entry, entry.key());
+
+    if(entry->isBackground())
+    {
+        ++m_backgroundCount;
+    }
+}
+
+void RenderScheduler::addFollower(RenderTask* task, RenderTask* leader, const Entry& entry)
+{
+    m_followers.insert(task, Follower{leader, entry});
+    m_followersByLeader.insert(leader, task);
+}
+
+bool RenderScheduler::removeFollower(RenderTask* task)
+{
+    const auto follower = m_followers.find(task);
+
+    if(follower == m_followers.end())
+    {
+        return false;
+    }
+
+    m_followersByLeader.remove(follower->leader, task);
+    m_followers.erase(follower);
+
+    return true;
+}
+
+QVector< RenderTask* > RenderScheduler::takeFollowers(RenderTask* leader)
+{
+    QVector< RenderTask* > followers;
+
+    for(auto follower = m_followersByLeader.find(leader); follower != m_followersByLeader.end() && follower.key() == leader;)
+    {
+        followers.append(follower.value());
+        m_followers.remove(follower.value());
+
+        follower = m_followersByLeader.erase(follower);
+    }
+
+    return followers;
+}
+
+RenderPriority RenderScheduler::mostUrgentPriority(RenderTask* leader, RenderPriority priority) const
+{
+    for(auto follower = m_followersByLeader.constFind(leader); follower != m_followersByLeader.constEnd() && follower.key() == leader; ++follower)
+    {
+        const RenderPriority& followerPriority = m_followers.constFind(follower.value())->entry.priority;
+
+        if(followerPriority < priority)
+        {
+            priority = followerPriority;
+        }
+    }
+
+    return priority;
+}
+
+QVector< RenderTask* > RenderScheduler::trimQueue()
+{
+    QVector< RenderTask* > discardedTasks;
+
+    // Visible tiles are never discarded, otherwise they would be scheduled again by the next paint.
+    // As they are the most urgent ones, the least urgent task is not visible as long as any such task is queued
+    // and of those with the same priority, the most recently scheduled one is discarded first.
+
+    const int queueDepth = s_settings->pageItem().renderQueueDepth();
+
+    while(m_backgroundCount > queueDepth)
+    {
+        RenderTask* task = m_order.last();
+        dequeue(m_queue.find(task));
+
+        discardedTasks.append(task);
+    }
+
+    return discardedTasks;
+}
+
+} // qpdfview
@@ -0,0 +1,183 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef RENDERSCHEDULER_H
+#define RENDERSCHEDULER_H
+
+#include <QHash>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QVector>
+#include <QWaitCondition>
+
+#include "global.h"
+#include "tilecache.h"
+
+namespace qpdfview
+{
+
+class Settings;
+class RenderTask;
+
+class RenderPriority
+{
+public:
+    enum Class
+    {
+        VisibleClass = 0,
+        PrefetchClass = 1,
+        ThumbnailClass = 2,
+        IdleClass = 3
+    };
+
+    explicit RenderPriority(Class priorityClass = VisibleClass, qreal distance = 0.0) :
+        m_class(priorityClass),
+        m_distance(distance)
+    {
+    }
+
+    DECL_NODISCARD
+    Class priorityClass() const { return m_class; }
+
+    // distance from the center of the viewport in scene coordinates
+    DECL_NODISCARD
+    qreal distance() const { return m_distance; }
+
+    // true if this priority is more urgent than the other one
+    bool operator<(const RenderPriority& other) const
+    {
+        return m_class != other.m_class ? m_class < other.m_class : m_distance < other.m_distance;
+    }
+
+private:
+    Class m_class;
+    qreal m_distance;
+
+};
+
+// Runs render tasks on a dedicated set of worker threads so that they do not compete with
+// searches and text extraction in the global thread pool. Queued tasks can be re-prioritised
+// while they wait, e.g. when the viewport moves.
+//
+// Tasks scheduled with the same non-null sharing key while another one is in flight are attached to it
+// as followers instead of being queued and receive its result when it finishes.
+class RenderScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+    static RenderScheduler* instance();
+    ~RenderScheduler() override;
+
+    DECL_NODISCARD
+    int workerCount() const;
+    DECL_NODISCARD
+    int queuedCount() const;
+
+    void schedule(RenderTask* task, const RenderPriority& priority);
+
+    // These return whether the task was still queued or attached to another one.
+    bool reprioritize(RenderTask* task, const RenderPriority& priority);
+    bool demote(RenderTask* task, const RenderPriority& priority);
+    bool unschedule(RenderTask* task);
+
+    // Detaches the followers of a task which finished successfully so that they can share its result.
+    QVector< RenderTask* > share(RenderTask* task);
+    // Hands the followers of a task which was canceled over to the most urgent one of them.
+    void retire(RenderTask* task);
+
+private:
+    Q_DISABLE_COPY(RenderScheduler)
+
+    explicit RenderScheduler(QObject* parent = nullptr);
+
+    static RenderScheduler* s_instance;
+
+    static Settings* s_settings;
+
+    class Worker;
+    friend class Worker;
+
+    QVector< Worker* > m_workers;
+
+    void adjustWorkers();
+
+    mutable QMutex m_mutex;
+    QWaitCondition m_queueNotEmpty;
+
+    struct Entry
+    {
+        RenderPriority priority;
+        quint64 sequence;
+
+        DECL_NODISCARD
+        bool isBackground() const { return priority.priorityClass() != RenderPriority::VisibleClass; }
+
+        // Tasks of the same priority are taken in the order they were scheduled.
+        bool operator<(const Entry& other) const
+        {
+            return priority < other.priority || (!(other.priority < priority) && sequence < other.sequence);
+        }
+    };
+
+    QHash< RenderTask*, Entry > m_queue;
+    quint64 m_sequence;
+
+    // the queued tasks from the most to the least urgent one
+    QMap< Entry, RenderTask* > m_order;
+
+    // the number of queued tasks which are not visible
+    int m_backgroundCount;
+
+    void enqueue(RenderTask* task, const Entry& entry);
+    void dequeue(QHash< RenderTask*, Entry >::iterator entry);
+    void setPriority(QHash< RenderTask*, Entry >::iterator entry, const RenderPriority& priority);
+
+    struct Follower
+    {
+        RenderTask* leader;
+        Entry entry;
+    };
+
+    QHash< TileCacheKey, RenderTask* > m_leaders;
+    QHash< RenderTask*, Follower > m_followers;
+    QMultiHash< RenderTask*, RenderTask* > m_followersByLeader;
+
+    void addFollower(RenderTask* task, RenderTask* leader, const Entry& entry);
+    bool removeFollower(RenderTask* task);
+
+    QVector< RenderTask* > takeFollowers(RenderTask* leader);
+    RenderPriority mostUrgentPriority(RenderTask* leader, RenderPriority priority) const;
+
+    int m_activeWorkerCount;
+    int m_targetWorkerCount;
+    bool m_quit;
+
+    RenderTask* take();
+
+    QVector< RenderTask* > trimQueue();
+
+};
+
+} // qpdfview
+
+#endif // RENDERSCHEDULER_H
@@ -0,0 +1,339 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "renderstatistics.h"
+
+#include <QAtomicInteger>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QtAlgorithms>
+#include <qmath.h>
+
+#include "renderscheduler.h"
+
+namespace qpdfview
+{
+
+namespace
+{
+
+// Latencies are counted in microseconds using log-linear buckets,
+// i.e. each power of two is split into eight buckets which yields a resolution of about 12%.
+const int subBucketBits = 3;
+const int subBucketCount = 1 << subBucketBits;
+const int bucketCount = 36 * subBucketCount;
+
+// The throughput is only estimated after a few renders and only over the recent ones.
+const quint64 minimumThroughputSamples = 4;
+const quint64 maximumThroughputSamples = 256;
+
+int bucketIndex(qint64 nanoseconds)
+{
+    const quint64 microseconds = static_cast< quint64 >(qMax(qint64(0), nanoseconds / 1000));
+
+    if(microseconds < static_cast< quint64 >(subBucketCount))
+    {
+        return static_cast< int >(microseconds);
+    }
+
+    const int exponent = 63 - static_cast< int >(qCountLeadingZeroBits(microseconds));
+    const int mantissa = static_cast< int >(microseconds >> (exponent - subBucketBits)) & (subBucketCount - 1);
+
+    return qMin(bucketCount - 1, (exponent - subBucketBits + 1) * subBucketCount + mantissa);
+}
+
+// the center of a bucket in microseconds
+qreal bucketValue(int index)
+{
+    if(index < subBucketCount)
+    {
+        return index + 0.5;
+    }
+
+    const int exponent = index / subBucketCount - 1 + subBucketBits;
+    const int mantissa = index % subBucketCount;
+
+    const qreal width = static_cast< qreal >(quint64(1) << (exponent - subBucketBits));
+
+    return (subBucketCount + mantissa) * width + 0.5 * width;
+}
+
+} // anonymous
+
+class RenderStatistics::Histograms
+{
+public:
+    Histograms() : m_counts(), m_pixels(0), m_nanoseconds(0), m_samples(0) {}
+
+    void record(Stage stage, qint64 nanoseconds)
+    {
+        m_counts[stage][bucketIndex(nanoseconds)].fetchAndAddRelaxed(1);
+    }
+
+    quint64 count(Stage stage) const
+    {
+        quint64 count = 0;
+
+        for(int index = 0; index < bucketCount; ++index)
+        {
+            count += m_counts[stage][index].loadRelaxed();
+        }
+
+        return count;
+    }
+
+    // in milliseconds
+    qreal percentile(Stage stage, quint64 count, qreal fraction) const
+    {
+        if(count == 0)
+        {
+            return 0.0;
+        }
+
+        const quint64 rank = qMax(quint64(1), static_cast< quint64 >(qCeil(fraction * count)));
+
+        quint64 cumulativeCount = 0;
+
+        for(int index = 0; index < bucketCount; ++index)
+        {
+            cumulativeCount += m_counts[stage][index].loadRelaxed();
+
+            if(cumulativeCount >= rank)
+            {
+                return bucketValue(index) / 1000.0;
+            }
+        }
+
+        return bucketValue(bucketCount - 1) / 1000.0;
+    }
+
+    void recordThroughput(qint64 pixels, qint64 nanoseconds)
+    {
+        // Halving the sums now and then lets old samples fade out. The sums are not updated atomically
+        // together, but the estimate does not need to be exact.
+        if(m_samples.fetchAndAddRelaxed(1) >= maximumThroughputSamples)
+        {
+            m_samples.storeRelaxed(maximumThroughputSamples / 2);
+            m_pixels.storeRelaxed(m_pixels.loadRelaxed() / 2);
+            m_nanoseconds.storeRelaxed(m_nanoseconds.loadRelaxed() / 2);
+        }
+
+        m_pixels.fetchAndAddRelaxed(static_cast< quint64 >(qMax(qint64(0), pixels)));
+        m_nanoseconds.fetchAndAddRelaxed(static_cast< quint64 >(qMax(qint64(0), nanoseconds)));
+    }
+
+    // in pixels per millisecond
+    qreal throughput() const
+    {
+        const quint64 nanoseconds = m_nanoseconds.loadRelaxed();
+
+        if(m_samples.loadRelaxed() < minimumThroughputSamples || nanoseconds == 0)
+        {
+            return 0.0;
+        }
+
+        return m_pixels.loadRelaxed() * 1.0e6 / nanoseconds;
+    }
+
+    void reset()
+    {
+        for(int stage = 0; stage < NumberOfStages; ++stage)
+        {
+            for(int index = 0; index < bucketCount; ++index)
+            {
+                m_counts[stage][index].storeRelaxed(0);
+            }
+        }
+
+        m_pixels.storeRelaxed(0);
+        m_nanoseconds.storeRelaxed(0);
+        m_samples.storeRelaxed(0);
+    }
+
+private:
+    Q_DISABLE_COPY(Histograms)
+
+    QAtomicInteger< quint32 > m_counts[NumberOfStages][bucketCount];
+
+    QAtomicInteger< quint64 > m_pixels;
+    QAtomicInteger< quint64 > m_nanoseconds;
+    QAtomicInteger< quint64 > m_samples;
+
+};
+
+RenderStatistics* RenderStatistics::s_instance = nullptr;
+
+QString RenderStatistics::stageName(Stage stage)
+{
+    switch(stage)
+    {
+    default:
+    case QueueStage:
+        return QLatin1String("queue");
+    case RasterizeStage:
+        return QLatin1String("rasterize");
+    case PostProcessStage:
+        return QLatin1String("postProcess");
+    case DeliveryStage:
+        return QLatin1String("delivery");
+    case UploadStage:
+        return QLatin1String("upload");
+    case FinishStage:
+        return QLatin1String("finish");
+    case TotalStage:
+        return QLatin1String("total");
+    }
+}
+
+RenderStatistics* RenderStatistics::instance()
+{
+    if(s_instance == nullptr)
+    {
+        // The scheduler owns the statistics, so that they are only destroyed
+        // after its workers, which record into them, have been joined.
+        s_instance = new RenderStatistics(RenderScheduler::instance());
+    }
+
+    return s_instance;
+}
+
+RenderStatistics::~RenderStatistics()
+{
+    qDeleteAll(m_histograms);
+
+    s_instance = nullptr;
+}
+
+void RenderStatistics::record(const QString& backend, Stage stage, qint64 nanoseconds)
+{
+    histograms(backend)->record(stage, nanoseconds);
+}
+
+void RenderStatistics::recordThroughput(const QString& backend, qint64 pixels, qint64 nanoseconds)
+{
+    histograms(backend)->recordThroughput(pixels, nanoseconds);
+}
+
+qreal RenderStatistics::throughput(const QString& backend) const
+{
+    QReadLocker readLocker(&m_lock);
+
+    const Histograms* histograms = m_histograms.value(backend);
+
+    return histograms != nullptr ? histograms->throughput() : 0.0;
+}
+
+QVector< RenderStatistics::Summary > RenderStatistics::summaries() const
+{
+    QReadLocker readLocker(&m_lock);
+
+    QVector< Summary > summaries;
+
+    for(auto histograms = m_histograms.constBegin(); histograms != m_histograms.constEnd(); ++histograms)
+    {
+        for(int index = 0; index < NumberOfStages; ++index)
+        {
+            const auto stage = static_cast< Stage >(index);
+            const quint64 count = histograms.value()->count(stage);
+
+            if(count == 0)
+            {
+                continue;
+            }
+
+            summaries.append(Summary{histograms.key(), stage, count,
+                                     histograms.value()->percentile(stage, count, 0.50),
+                                     histograms.value()->percentile(stage, count, 0.95),
+                                     histograms.value()->percentile(stage, count, 0.99)});
+        }
+    }
+
+    return summaries;
+}
+
+QByteArray RenderStatistics::toJson() const
+{
+    QJsonObject backends;
+
+    foreach(const Summary& summary, summaries())
+    {
+        QJsonObject stage;
+
+        stage.insert(QLatin1String("count"), static_cast< qint64 >(summary.count));
+        stage.insert(QLatin1String("p50"), summary.p50);
+        stage.insert(QLatin1String("p95"), summary.p95);
+        stage.insert(QLatin1String("p99"), summary.p99);
+
+        QJsonObject stages = backends.value(summary.backend).toObject();
+        stages.insert(stageName(summary.stage), stage);
+        backends.insert(summary.backend, stages);
+    }
+
+    foreach(const QString& backend, backends.keys())
+    {
+        QJsonObject stages = backends.value(backend).toObject();
+        stages.insert(QLatin1String("throughput"), throughput(backend));
+        backends.insert(backend, stages);
+    }
+
+    return QJsonDocument(backends).toJson();
+}
+
+void RenderStatistics::reset()
+{
+    QReadLocker readLocker(&m_lock);
+
+    foreach(Histograms* histograms, m_histograms)
+    {
+        histograms->reset();
+    }
+}
+
+RenderStatistics::RenderStatistics(QObject* parent) : QObject(parent),
+    m_lock(),
+    m_histograms()
+{
+}
+
+RenderStatistics::Histograms* RenderStatistics::histograms(const QString& backend)
+{
+    {
+        QReadLocker readLocker(&m_lock);
+
+        if(Histograms* histograms = m_histograms.value(backend))
+        {
+            return histograms;
+        }
+    }
+
+    QWriteLocker writeLocker(&m_lock);
+
+    Histograms*& histograms = m_histograms[backend];
+
+    if(histograms == nullptr)
+    {
+        histograms = new Histograms;
+    }
+
+    return histograms;
+}
+
+} // qpdfview
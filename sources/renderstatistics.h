@@ -0,0 +1,107 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+#include <QHash>
+#include <QObject>
+#include <QReadWriteLock>
+#include <QVector>
+
+#include "global.h"
+
+namespace qpdfview
+{
+
+// Collects latency histograms of the stages of rendering a tile per backend.
+// Recording only takes a shared lock and increments an atomic counter, so it can be done from any thread.
+class RenderStatistics : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Stage
+    {
+        QueueStage = 0,         // from scheduling until a worker picks up the task
+        RasterizeStage = 1,     // the backend rendering the page
+        PostProcessStage = 2,   // the post-processing pipeline
+        DeliveryStage = 3,      // from the finished task until the main thread delivers the result
+        UploadStage = 4,        // converting the image into a pixmap
+        FinishStage = 5,        // the tile handling the result
+        TotalStage = 6,         // from scheduling until the tile handled the result
+        NumberOfStages = 7
+    };
+
+    static QString stageName(Stage stage);
+
+    static RenderStatistics* instance();
+    ~RenderStatistics() override;
+
+    void record(const QString& backend, Stage stage, qint64 nanoseconds);
+
+    // Records the size of a rasterized image, so that tiles can be sized according to the throughput of the backend.
+    void recordThroughput(const QString& backend, qint64 pixels, qint64 nanoseconds);
+
+    // in pixels per millisecond or zero if there are not enough samples yet
+    DECL_NODISCARD
+    qreal throughput(const QString& backend) const;
+
+    struct Summary
+    {
+        QString backend;
+        Stage stage;
+
+        quint64 count;
+
+        // in milliseconds
+        qreal p50;
+        qreal p95;
+        qreal p99;
+    };
+
+    DECL_NODISCARD
+    QVector< Summary > summaries() const;
+
+    DECL_NODISCARD
+    QByteArray toJson() const;
+
+public slots:
+    void reset();
+
+private:
+    Q_DISABLE_COPY(RenderStatistics)
+
+    static RenderStatistics* s_instance;
+    explicit RenderStatistics(QObject* parent = nullptr);
+
+    class Histograms;
+
+    mutable QReadWriteLock m_lock;
+    QHash< QString, Histograms* > m_histograms;
+
+    Histograms* histograms(const QString& backend);
+
+};
+
+} // qpdfview
+
+#endif // RENDERSTATISTICS_H
@@ -0,0 +1,164 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "renderstatisticsdialog.h"
+
+#include <QDialogButtonBox>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTableWidget>
+#include <QTimer>
+#include <QVBoxLayout>
+
+#include "memorymonitor.h"
+#include "renderstatistics.h"
+#include "tilecache.h"
+
+namespace qpdfview
+{
+
+namespace
+{
+
+QTableWidgetItem* createItem(const QString& text, Qt::Alignment alignment = Qt::AlignLeft | Qt::AlignVCenter)
+{
+    auto item = new QTableWidgetItem(text);
+    item->setTextAlignment(alignment);
+
+    return item;
+}
+
+QTableWidgetItem* createItem(qreal milliseconds)
+{
+    return createItem(QString::number(milliseconds, 'f', 3), Qt::AlignRight | Qt::AlignVCenter);
+}
+
+QString cacheTierText(const QString& name, TileCache::Tier tier)
+{
+    const TileCache* cache = TileCache::instance();
+
+    return RenderStatisticsDialog::tr("%1: %2 hits, %3 misses, %4 evictions, %5 of %6 MB")
+            .arg(name)
+            .arg(cache->hitCount(tier)).arg(cache->missCount(tier)).arg(cache->evictionCount(tier))
+            .arg(cache->totalCost(tier) / 1024.0, 0, 'f', 1).arg(cache->maxCost(tier) / 1024);
+}
+
+QString memoryText()
+{
+    if(!TileCache::instance()->isAdaptive())
+    {
+        return RenderStatisticsDialog::tr("Adaptive cache size: off");
+    }
+
+    const MemoryMonitor::Sample& sample = MemoryMonitor::instance()->sample();
+
+    return RenderStatisticsDialog::tr("Adaptive cache size: %1 of %2 MB available, %3 % memory pressure")
+            .arg(sample.available / 1024).arg(sample.limit / 1024)
+            .arg(sample.pressure, 0, 'f', 2);
+}
+
+} // anonymous
+
+RenderStatisticsDialog::RenderStatisticsDialog(QWidget* parent) : QDialog(parent)
+{
+    setWindowTitle(tr("Render statistics") + QLatin1String(" - qpdfview"));
+
+    m_tableWidget = new QTableWidget(0, 6, this);
+    m_tableWidget->setHorizontalHeaderLabels(QStringList() << tr("Backend") << tr("Stage") << tr("Count")
+                                             << tr("p50 (ms)") << tr("p95 (ms)") << tr("p99 (ms)"));
+
+    m_tableWidget->setAlternatingRowColors(true);
+    m_tableWidget->setEditTriggers(QAbstractItemView::NoEditTriggers);
+    m_tableWidget->setHorizontalScrollMode(QAbstractItemView::ScrollPerPixel);
+
+    m_tableWidget->horizontalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+    m_tableWidget->verticalHeader()->setSectionResizeMode(QHeaderView::ResizeToContents);
+
+    m_tableWidget->verticalHeader()->setVisible(false);
+
+    m_cacheLabel = new QLabel(this);
+
+    // The budgets and evictions of the cache change continuously, especially in adaptive mode.
+    m_cacheTimer = new QTimer(this);
+    m_cacheTimer->setInterval(1000);
+    connect(m_cacheTimer, SIGNAL(timeout()), SLOT(on_cacheTimer_timeout()));
+    m_cacheTimer->start();
+
+    m_dialogButtonBox = new QDialogButtonBox(QDialogButtonBox::Ok, Qt::Horizontal, this);
+    connect(m_dialogButtonBox, SIGNAL(accepted()), SLOT(accept()));
+    connect(m_dialogButtonBox, SIGNAL(rejected()), SLOT(reject()));
+
+    m_refreshButton = m_dialogButtonBox->addButton(tr("Re&fresh"), QDialogButtonBox::ActionRole);
+    connect(m_refreshButton, SIGNAL(clicked()), SLOT(on_refresh_clicked()));
+
+    m_resetButton = m_dialogButtonBox->addButton(tr("&Reset"), QDialogButtonBox::ResetRole);
+    connect(m_resetButton, SIGNAL(clicked()), SLOT(on_reset_clicked()));
+
+    setLayout(new QVBoxLayout(this));
+    layout()->addWidget(m_tableWidget);
+    layout()->addWidget(m_cacheLabel);
+    layout()->addWidget(m_dialogButtonBox);
+
+    resize(640, 480);
+
+    on_refresh_clicked();
+}
+
+void RenderStatisticsDialog::on_refresh_clicked()
+{
+    const QVector< RenderStatistics::Summary > summaries = RenderStatistics::instance()->summaries();
+
+    m_tableWidget->clearContents();
+    m_tableWidget->setRowCount(summaries.count());
+
+    for(int row = 0; row < summaries.count(); ++row)
+    {
+        const RenderStatistics::Summary& summary = summaries.at(row);
+
+        m_tableWidget->setItem(row, 0, createItem(summary.backend));
+        m_tableWidget->setItem(row, 1, createItem(RenderStatistics::stageName(summary.stage)));
+        m_tableWidget->setItem(row, 2, createItem(QString::number(summary.count), Qt::AlignRight | Qt::AlignVCenter));
+        m_tableWidget->setItem(row, 3, createItem(summary.p50));
+        m_tableWidget->setItem(row, 4, createItem(summary.p95));
+        m_tableWidget->setItem(row, 5, createItem(summary.p99));
+    }
+
+    on_cacheTimer_timeout();
+}
+
+void RenderStatisticsDialog::on_cacheTimer_timeout()
+{
+    m_cacheLabel->setText(cacheTierText(tr("Pixmap cache"), TileCache::PixmapTier)
+                          + QLatin1Char('\n')
+                          + cacheTierText(tr("Compressed cache"), TileCache::CompressedTier)
+                          + QLatin1Char('\n')
+                          + memoryText());
+}
+
+void RenderStatisticsDialog::on_reset_clicked()
+{
+    RenderStatistics::instance()->reset();
+
+    on_refresh_clicked();
+}
+
+} // qpdfview
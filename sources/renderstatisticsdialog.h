@@ -0,0 +1,64 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef RENDERSTATISTICSDIALOG_H
+#define RENDERSTATISTICSDIALOG_H
+
+#include <QDialog>
+
+class QDialogButtonBox;
+class QLabel;
+class QPushButton;
+class QTableWidget;
+class QTimer;
+
+namespace qpdfview
+{
+
+class RenderStatisticsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit RenderStatisticsDialog(QWidget* parent = nullptr);
+
+protected slots:
+    void on_refresh_clicked();
+    void on_reset_clicked();
+
+    void on_cacheTimer_timeout();
+
+private:
+    Q_DISABLE_COPY(RenderStatisticsDialog)
+
+    QTableWidget* m_tableWidget;
+    QLabel* m_cacheLabel;
+    QTimer* m_cacheTimer;
+
+    QDialogButtonBox* m_dialogButtonBox;
+    QPushButton* m_refreshButton;
+    QPushButton* m_resetButton;
+
+};
+
+} // qpdfview
+
+#endif // RENDERSTATISTICSDIALOG_H
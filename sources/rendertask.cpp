@@ -23,10 +23,12 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QApplication>
 #include <qmath.h>
-#include <QPainter>
-#include <QThreadPool>
+#include <QScreen>
+#include <QTransform>
 
 #include "model.h"
+#include "postprocessing.h"
+#include "renderstatistics.h"
 #include "settings.h"
 
 namespace qpdfview
@@ -57,188 +59,39 @@ qreal scaledResolutionY(const RenderParam& renderParam)
             * renderParam.scaleFactor();
 }
 
-const QRgb alphaMask = 0xffu << 24;
-
-bool columnHasPaperColor(int x, QRgb paperColor, const QImage& image)
-{
-    const int height = image.height();
-
-    for(int y = 0; y < height; ++y)
-    {
-        const QRgb color = image.pixel(x, y);
-
-        if(qAlpha(color) != 0 && paperColor != (color | alphaMask))
-        {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-bool rowHasPaperColor(int y, QRgb paperColor, const QImage& image)
-{
-    const int width = image.width();
-
-    for(int x = 0; x < width; ++x)
-    {
-        const QRgb color = image.pixel(x, y);
-
-        if(qAlpha(color) != 0 && paperColor != (color | alphaMask))
-        {
-            return false;
-        }
-    }
-
-    return true;
-}
-
-QRectF trimMargins(QRgb paperColor, const QImage& image)
-{
-    if(image.isNull())
-    {
-        return {0.0, 0.0, 1.0, 1.0};
-    }
-
-    const int width = image.width();
-    const int height = image.height();
-
-    int left;
-    for(left = 0; left < width; ++left)
-    {
-        if(!columnHasPaperColor(left, paperColor, image))
-        {
-            break;
-        }
-    }
-    left = std::min(left, width / 3);
-
-    int right;
-    for(right = width - 1; right >= left; --right)
-    {
-        if(!columnHasPaperColor(right, paperColor, image))
-        {
-            break;
-        }
-    }
-    right = std::max(right, 2 * width / 3);
-
-    int top;
-    for(top = 0; top < height; ++top)
-    {
-        if(!rowHasPaperColor(top, paperColor, image))
-        {
-            break;
-        }
-    }
-    top = std::min(top, height / 3);
-
-    int bottom;
-    for(bottom = height - 1; bottom >= top; --bottom)
-    {
-        if(!rowHasPaperColor(bottom, paperColor, image))
-        {
-            break;
-        }
-    }
-    bottom = std::max(bottom, 2 * height / 3);
-
-    left = std::max(left - width / 100, 0);
-    top = std::max(top - height / 100, 0);
-
-    right = std::min(right + width / 100, width);
-    bottom = std::min(bottom + height / 100, height);
-
-    return {static_cast< qreal >(left) / width,
-            static_cast< qreal >(top) / height,
-            static_cast< qreal >(right - left) / width,
-            static_cast< qreal >(bottom - top) / height};
-}
-
-void convertToGrayscale(QImage& image)
-{
-    auto const begin = reinterpret_cast< QRgb* >(image.bits());
-    auto const end = reinterpret_cast< QRgb* >(image.bits() + image.sizeInBytes());
-
-    for(QRgb* pointer = begin; pointer != end; ++pointer)
-    {
-        const int gray = qGray(*pointer);
-        const int alpha = qAlpha(*pointer);
-
-        *pointer = qRgba(gray, gray, gray, alpha);
-    }
-}
-
-void composeWithColor(QPainter::CompositionMode mode, const QColor& color, QImage& image)
-{
-    QPainter painter(&image);
-
-    painter.setCompositionMode(mode);
-    painter.fillRect(image.rect(), color);
-}
-
 } // anonymous
 
-struct RenderTaskFinishedEvent : public QEvent
+struct RenderTaskDispatcher::Result
 {
-    static QEvent::Type registeredType;
+    Result* next;
 
-    RenderTaskFinishedEvent(RenderTaskParent* const parent,
-                            RenderParam renderParam,
-                            const QRect& rect,
-                            const bool prefetch,
-                            QImage image,
-                            const QRectF& cropRect)
-        : QEvent(registeredType)
-        , parent(parent)
-        , renderParam(std::move(renderParam))
-        , rect(rect)
-        , prefetch(prefetch)
-        , image(std::move(image))
-        , cropRect(cropRect)
-    {
-    }
-    ~RenderTaskFinishedEvent() override = default;
+    RenderTaskParent* parent;
+    bool canceled;
 
-    void dispatch() const
-    {
-        parent->onFinished(renderParam,
-                           rect, prefetch,
-                           image, cropRect);
-    }
-
-    RenderTaskParent* const parent;
+    RenderParam renderParam;
+    QRect rect;
+    bool prefetch;
+    QImage image;
+    QPixmap pixmap;
+    QRectF cropRect;
 
-    const RenderParam renderParam;
-    const QRect rect;
-    const bool prefetch;
-    const QImage image;
-    const QRectF cropRect;
+    QString backend;
+    QElapsedTimer scheduled;
+    QElapsedTimer finished;
 };
 
-QEvent::Type RenderTaskFinishedEvent::registeredType = QEvent::None;
-
-struct RenderTaskCanceledEvent : public QEvent
+struct RenderResultsPendingEvent : public QEvent
 {
-
     static QEvent::Type registeredType;
 
-    explicit RenderTaskCanceledEvent(RenderTaskParent* parent)
+    RenderResultsPendingEvent()
         : QEvent(registeredType)
-        , parent(parent)
     {
     }
-    ~RenderTaskCanceledEvent() override = default;
-
-    void dispatch() const
-    {
-        parent->onCanceled();
-    }
-
-    RenderTaskParent* const parent;
+    ~RenderResultsPendingEvent() override = default;
 };
 
-QEvent::Type RenderTaskCanceledEvent::registeredType = QEvent::None;
+QEvent::Type RenderResultsPendingEvent::registeredType = QEvent::None;
 
 struct DeleteParentLaterEvent : public QEvent
 {
@@ -302,31 +155,59 @@ private:
     const QSet< RenderTaskParent* >& m_activeParents;
 };
 
+int frameInterval()
+{
+    const QScreen* const screen = QGuiApplication::primaryScreen();
+
+    const qreal refreshRate = screen != nullptr ? screen->refreshRate() : 0.0;
+
+    return refreshRate > 1.0 ? qRound(1000.0 / refreshRate) : 16;
+}
+
 } // anonymous
 
-RenderTaskDispatcher::RenderTaskDispatcher(QObject* parent) : QObject(parent)
+RenderTaskDispatcher::RenderTaskDispatcher(QObject* parent) : QObject(parent),
+    m_activeParents(),
+    m_results(nullptr),
+    m_deliveryTimer(),
+    m_lastDelivery()
 {
     registerEventType(DeleteParentLaterEvent::registeredType);
-    registerEventType(RenderTaskFinishedEvent::registeredType);
-    registerEventType(RenderTaskCanceledEvent::registeredType);
+    registerEventType(RenderResultsPendingEvent::registeredType);
+
+    m_deliveryTimer.setSingleShot(true);
+    m_deliveryTimer.setTimerType(Qt::PreciseTimer);
+
+    connect(&m_deliveryTimer, &QTimer::timeout, this, &RenderTaskDispatcher::deliverResults);
+}
+
+RenderTaskDispatcher::~RenderTaskDispatcher()
+{
+    for(Result* result = m_results.fetchAndStoreAcquire(nullptr); result != nullptr;)
+    {
+        Result* const next = result->next;
+        delete result;
+        result = next;
+    }
 }
 
 void RenderTaskDispatcher::finished(RenderTaskParent* parent,
                                     const RenderParam& renderParam,
                                     const QRect& rect, bool prefetch,
-                                    const QImage& image, const QRectF& cropRect)
+                                    const QImage& image, const QRectF& cropRect,
+                                    const QString& backend, const QElapsedTimer& scheduled)
 {
-    auto const event = new RenderTaskFinishedEvent(parent,
-                                                   renderParam,
-                                                   rect, prefetch,
-                                                   image, cropRect);
+    QElapsedTimer finished;
+    finished.start();
 
-    QApplication::postEvent(this, event, Qt::HighEventPriority);
+    pushResult(new Result{nullptr, parent, false, renderParam, rect, prefetch, image, QPixmap(), cropRect,
+                          backend, scheduled, finished});
 }
 
 void RenderTaskDispatcher::canceled(RenderTaskParent* parent)
 {
-    QApplication::postEvent(this, new RenderTaskCanceledEvent(parent), Qt::HighEventPriority);
+    pushResult(new Result{nullptr, parent, true, RenderParam(), QRect(), false, QImage(), QPixmap(), QRectF(),
+                          QString(), QElapsedTimer(), QElapsedTimer()});
 }
 
 void RenderTaskDispatcher::deleteParentLater(RenderTaskParent* parent)
@@ -336,11 +217,16 @@ void RenderTaskDispatcher::deleteParentLater(RenderTaskParent* parent)
 
 bool RenderTaskDispatcher::event(QEvent* event)
 {
+    if(event->type() == RenderResultsPendingEvent::registeredType)
+    {
+        scheduleDelivery();
+
+        return true;
+    }
+
     DispatchChain chain(event, m_activeParents);
 
-    chain.dispatch< RenderTaskFinishedEvent >()
-        .dispatch< RenderTaskCanceledEvent >()
-        .dispatch< DeleteParentLaterEvent >();
+    chain.dispatch< DeleteParentLaterEvent >();
 
     return chain.wasDispatched() || QObject::event(event);
 }
@@ -355,8 +241,124 @@ void RenderTaskDispatcher::removeActiveParent(RenderTaskParent* parent)
     m_activeParents.remove(parent);
 }
 
+void RenderTaskDispatcher::pushResult(Result* result)
+{
+    Result* head;
+
+    do
+    {
+        head = m_results.loadAcquire();
+        result->next = head;
+    }
+    while(!m_results.testAndSetRelease(head, result));
+
+    // Only the first result after a delivery needs to wake up the main thread.
+    if(head == nullptr)
+    {
+        QApplication::postEvent(this, new RenderResultsPendingEvent(), Qt::HighEventPriority);
+    }
+}
+
+void RenderTaskDispatcher::scheduleDelivery()
+{
+    if(m_deliveryTimer.isActive())
+    {
+        return;
+    }
+
+    const int interval = frameInterval();
+    const qint64 elapsed = m_lastDelivery.isValid() ? m_lastDelivery.elapsed() : interval;
+
+    m_deliveryTimer.start(static_cast< int >(qMax(qint64(0), interval - elapsed)));
+}
+
+void RenderTaskDispatcher::deliverResults()
+{
+    m_lastDelivery.start();
+
+    // The stack yields the newest result first, so it is reversed to deliver them in order.
+    Result* results = nullptr;
+
+    for(Result* result = m_results.fetchAndStoreAcquire(nullptr); result != nullptr;)
+    {
+        Result* const next = result->next;
+        result->next = results;
+        results = result;
+        result = next;
+    }
+
+    RenderStatistics* const statistics = RenderStatistics::instance();
+
+    // All images are uploaded in one go before any parent is notified...
+    QHash< qint64, QPixmap > uploads;
+
+    for(Result* result = results; result != nullptr; result = result->next)
+    {
+        if(result->canceled || !m_activeParents.contains(result->parent))
+        {
+            continue;
+        }
+
+        statistics->record(result->backend, RenderStatistics::DeliveryStage, result->finished.nsecsElapsed());
+
+        if(!result->image.isNull())
+        {
+            // Results shared by several tasks are uploaded only once.
+            QPixmap& pixmap = uploads[result->image.cacheKey()];
+
+            if(pixmap.isNull())
+            {
+                QElapsedTimer upload;
+                upload.start();
+
+                pixmap = QPixmap::fromImage(result->image);
+
+                statistics->record(result->backend, RenderStatistics::UploadStage, upload.nsecsElapsed());
+            }
+
+            result->pixmap = pixmap;
+        }
+    }
+
+    // ...and since the parents are notified within a single event,
+    // the scene merges their updates into one repaint.
+    while(results != nullptr)
+    {
+        Result* const result = results;
+        results = result->next;
+
+        if(m_activeParents.contains(result->parent))
+        {
+            if(result->canceled)
+            {
+                result->parent->onCanceled();
+            }
+            else
+            {
+                QElapsedTimer finish;
+                finish.start();
+
+                result->parent->onFinished(result->renderParam,
+                                           result->rect, result->prefetch,
+                                           result->image, result->pixmap, result->cropRect);
+
+                statistics->record(result->backend, RenderStatistics::FinishStage, finish.nsecsElapsed());
+                statistics->record(result->backend, RenderStatistics::TotalStage, result->scheduled.nsecsElapsed());
+            }
+        }
+
+        delete result;
+    }
+}
+
+RenderScheduler* RenderTask::s_scheduler = nullptr;
+
 RenderTaskDispatcher* RenderTask::s_dispatcher = nullptr;
 
+RenderStatistics* RenderTask::s_statistics = nullptr;
+
+TileCache* RenderTask::s_cache = nullptr;
+
 Settings* RenderTask::s_settings = nullptr;
 
 const RenderParam RenderTask::s_defaultRenderParam;
@@ -365,21 +367,42 @@ RenderTask::RenderTask(Model::Page* page, RenderTaskParent* parent) : QRunnable(
     m_parent(parent),
     m_isRunning(),
     m_wasCanceled(NotCanceled),
+    m_cancellation(),
     m_page(page),
     m_renderParam(s_defaultRenderParam),
     m_rect(),
-    m_prefetch()
+    m_prefetch(),
+    m_sharingKey(),
+    m_cacheKey(),
+    m_scheduled()
 {
     if(s_settings == nullptr)
     {
         s_settings = Settings::instance();
     }
 
+    // The scheduler must be created first so that it is destroyed before the dispatcher.
+    if(s_scheduler == nullptr)
+    {
+        s_scheduler = RenderScheduler::instance();
+    }
+
     if(s_dispatcher == nullptr)
     {
         s_dispatcher = new RenderTaskDispatcher(qApp);
     }
 
+    // The statistics are owned by the scheduler and therefore outlive its workers.
+    if(s_statistics == nullptr)
+    {
+        s_statistics = RenderStatistics::instance();
+    }
+
+    if(s_cache == nullptr)
+    {
+        s_cache = TileCache::instance();
+    }
+
     setAutoDelete(false);
 
     s_dispatcher->addActiveParent(m_parent);
@@ -413,9 +436,54 @@ void RenderTask::run()
 
     CANCELLATION_POINT
 
+    const QString backend = m_page->backendName();
+
+    s_statistics->record(backend, RenderStatistics::QueueStage, m_scheduled.nsecsElapsed());
+
     QImage image;
     QRectF cropRect;
 
+    // Tiles kept compressed by the cache are promoted back into its first tier by delivering them like rendered ones.
+    if(m_cacheKey.isNull() || !s_cache->decompress(m_cacheKey, image, cropRect))
+    {
+        if(!render(backend, image, cropRect))
+        {
+            finish(true);
+            return;
+        }
+    }
+
+    CANCELLATION_POINT
+
+    s_dispatcher->finished(m_parent,
+                           m_renderParam,
+                           m_rect, m_prefetch,
+                           image, cropRect,
+                           backend, m_scheduled);
+
+    foreach(RenderTask* follower, s_scheduler->share(this))
+    {
+        s_dispatcher->finished(follower->m_parent,
+                               follower->m_renderParam,
+                               follower->m_rect, follower->m_prefetch,
+                               image, cropRect,
+                               backend, follower->m_scheduled);
+
+        follower->finish(false);
+    }
+
+    finish(false);
+
+#undef CANCELLATION_POINT
+}
+
+bool RenderTask::render(const QString& backend, QImage& image, QRectF& cropRect)
+{
+#define CANCELLATION_POINT if(testCancellation()) { return false; }
+
+    QElapsedTimer stage;
+    stage.start();
+
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
     const qreal devicePixelRatio = m_renderParam.devicePixelRatio();
@@ -432,7 +500,16 @@ void RenderTask::run()
 #endif // QT_VERSION
 
     image = m_page->render(scaledResolutionX(m_renderParam), scaledResolutionY(m_renderParam),
-                           m_renderParam.rotation(), rect);
+                           m_renderParam.rotation(), rect, &m_cancellation,
+                           !m_renderParam.disableAntialiasing());
+
+    // An aborted render yields a partial or null image which must not be mistaken for an error.
+    CANCELLATION_POINT
+
+    const qint64 rasterizeTime = stage.nsecsElapsed();
+
+    s_statistics->record(backend, RenderStatistics::RasterizeStage, rasterizeTime);
+    s_statistics->recordThroughput(backend, qint64(image.width()) * image.height(), rasterizeTime);
 
 #if QT_VERSION >= QT_VERSION_CHECK(5,1,0)
 
@@ -440,67 +517,71 @@ void RenderTask::run()
 
 #endif // QT_VERSION
 
-    if(m_renderParam.darkenWithPaperColor())
-    {
-        CANCELLATION_POINT
+    const PostProcessing::Pipeline pipeline(m_renderParam.flags(), s_settings->pageItem().paperColor().rgba());
 
-        composeWithColor(QPainter::CompositionMode_Darken, s_settings->pageItem().paperColor(), image);
-    }
-    else if(m_renderParam.lightenWithPaperColor())
+    if(!pipeline.isEmpty())
     {
         CANCELLATION_POINT
 
-        composeWithColor(QPainter::CompositionMode_Lighten, s_settings->pageItem().paperColor(), image);
-    }
+        stage.restart();
 
-    if(m_renderParam.trimMargins())
-    {
-        CANCELLATION_POINT
-
-        cropRect = trimMargins(s_settings->pageItem().paperColor().rgb() | alphaMask, image);
-    }
-
-    if(m_renderParam.convertToGrayscale())
-    {
-        CANCELLATION_POINT
-
-        convertToGrayscale(image);
-    }
-
-    if(m_renderParam.invertColors())
-    {
-        CANCELLATION_POINT
+        if(!pipeline.run(image, cropRect, [this]() { return testCancellation(); }))
+        {
+            return false;
+        }
 
-        image.invertPixels();
+        s_statistics->record(backend, RenderStatistics::PostProcessStage, stage.nsecsElapsed());
     }
 
-    CANCELLATION_POINT
-
-    s_dispatcher->finished(m_parent,
-                           m_renderParam,
-                           m_rect, m_prefetch,
-                           image, cropRect);
-
-    finish(false);
+    return true;
 
 #undef CANCELLATION_POINT
 }
 
 void RenderTask::start(const RenderParam& renderParam,
-                       const QRect& rect, bool prefetch)
+                       const QRect& rect, bool prefetch,
+                       const RenderPriority& priority,
+                       const TileCacheKey& sharingKey,
+                       const TileCacheKey& cacheKey)
 {
     m_renderParam = renderParam;
 
     m_rect = rect;
     m_prefetch = prefetch;
 
+    m_sharingKey = sharingKey;
+    m_cacheKey = cacheKey;
+
+    m_scheduled.start();
+
     m_mutex.lock();
     m_isRunning = true;
     m_mutex.unlock();
 
     resetCancellation();
 
-    QThreadPool::globalInstance()->start(this, prefetch ? 1 : 2);
+    s_scheduler->schedule(this, priority);
+}
+
+void RenderTask::reprioritize(const RenderPriority& priority)
+{
+    s_scheduler->reprioritize(this, priority);
+}
+
+bool RenderTask::demote(const RenderPriority& priority)
+{
+    return s_scheduler->demote(this, priority);
+}
+
+void RenderTask::cancel(bool force)
+{
+    setCancellation(force);
+
+    // A task which has not started yet is finished right away instead of occupying the queue.
+    if(testCancellation() && s_scheduler->unschedule(this))
+    {
+        finish(true);
+    }
 }
 
 void RenderTask::deleteParentLater()
@@ -510,6 +591,8 @@ void RenderTask::deleteParentLater()
 
 void RenderTask::finish(bool canceled)
 {
+    s_scheduler->retire(this);
+
     m_renderParam = s_defaultRenderParam;
 
     if(canceled)
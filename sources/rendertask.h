@@ -22,37 +22,39 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef RENDERTASK_H
 #define RENDERTASK_H
 
+#include <QElapsedTimer>
 #include <QImage>
 #include <QMutex>
+#include <QPixmap>
 #include <QRunnable>
 #include <QSet>
+#include <QTimer>
 #include <QWaitCondition>
 
+#include "model.h"
 #include "renderparam.h"
+#include "renderscheduler.h"
+#include "tilecache.h"
 
 namespace qpdfview
 {
 
-namespace Model
-{
-class Page;
-}
-
+class RenderStatistics;
 class Settings;
 
 class RenderTaskParent
 {
-    friend struct RenderTaskFinishedEvent;
-    friend struct RenderTaskCanceledEvent;
+    friend class RenderTaskDispatcher;
     friend struct DeleteParentLaterEvent;
 
 public:
     virtual ~RenderTaskParent() = default;
 
 private:
+    // The image is the one the pixmap was uploaded from, so that it can be kept without reading the pixmap back.
     virtual void onFinished(const RenderParam& renderParam,
                             const QRect& rect, bool prefetch,
-                            const QImage& image, const QRectF& cropRect) = 0;
+                            const QImage& image, const QPixmap& pixmap, const QRectF& cropRect) = 0;
     virtual void onCanceled() = 0;
 };
 
@@ -71,12 +73,15 @@ private:
     void finished(RenderTaskParent* parent,
                   const RenderParam& renderParam,
                   const QRect& rect, bool prefetch,
-                  const QImage& image, const QRectF& cropRect);
+                  const QImage& image, const QRectF& cropRect,
+                  const QString& backend, const QElapsedTimer& scheduled);
     void canceled(RenderTaskParent* parent);
 
     void deleteParentLater(RenderTaskParent* parent);
 
 public:
+    ~RenderTaskDispatcher() override;
+
     bool event(QEvent* event) override;
 
 private:
@@ -85,10 +90,26 @@ private:
     void addActiveParent(RenderTaskParent* parent);
     void removeActiveParent(RenderTaskParent* parent);
 
+    // Results are pushed by the render threads onto a lock-free stack
+    // which is drained by the main thread at most once per frame.
+    struct Result;
+
+    QAtomicPointer< Result > m_results;
+
+    void pushResult(Result* result);
+
+    QTimer m_deliveryTimer;
+    QElapsedTimer m_lastDelivery;
+
+    void scheduleDelivery();
+    void deliverResults();
+
 };
 
 class RenderTask : public QRunnable
 {
+    friend class RenderScheduler;
+
 public:
     explicit RenderTask(Model::Page* page, RenderTaskParent* parent = nullptr);
     ~RenderTask() override;
@@ -108,10 +129,20 @@ public:
 
     void run() override;
 
+    // Tasks started with the same non-null sharing key while one of them is in flight share its result.
+    // If the tile of the non-null cache key is kept compressed by the tile cache, it is decompressed instead of rendered.
     void start(const RenderParam& renderParam,
-               const QRect& rect, bool prefetch);
+               const QRect& rect, bool prefetch,
+               const RenderPriority& priority = RenderPriority(),
+               const TileCacheKey& sharingKey = TileCacheKey(),
+               const TileCacheKey& cacheKey = TileCacheKey());
 
-    void cancel(bool force = false) { setCancellation(force); }
+    void reprioritize(const RenderPriority& priority);
+    // Turns a task which has not started yet into a prefetch with the given priority.
+    DECL_NODISCARD
+    bool demote(const RenderPriority& priority);
+
+    void cancel(bool force = false);
 
     void deleteParentLater();
 
@@ -120,7 +151,14 @@ private:
 
     static Settings* s_settings;
 
+    static RenderScheduler* s_scheduler;
+
     static RenderTaskDispatcher* s_dispatcher;
+
+    static RenderStatistics* s_statistics;
+
+    static TileCache* s_cache;
+
     RenderTaskParent* m_parent;
 
     mutable QMutex m_mutex;
@@ -128,6 +166,7 @@ private:
 
     bool m_isRunning;
     QAtomicInt m_wasCanceled;
+    Model::CancellationToken m_cancellation;
 
     enum
     {
@@ -145,6 +184,9 @@ private:
 
     void finish(bool canceled);
 
+    // This returns false if the task was canceled meanwhile.
+    bool render(const QString& backend, QImage& image, QRectF& cropRect);
+
 
     Model::Page* m_page;
 
@@ -154,6 +196,11 @@ private:
     QRect m_rect;
     bool m_prefetch;
 
+    TileCacheKey m_sharingKey;
+    TileCacheKey m_cacheKey;
+
+    QElapsedTimer m_scheduled;
+
 };
 
 #if QT_VERSION > QT_VERSION_CHECK(5,0,0)
@@ -161,11 +208,18 @@ private:
 inline void RenderTask::setCancellation(bool force)
 {
     m_wasCanceled.storeRelease(force ? CanceledForcibly : CanceledNormally);
+
+    if(force || !m_prefetch)
+    {
+        m_cancellation.cancel();
+    }
 }
 
 inline void RenderTask::resetCancellation()
 {
     m_wasCanceled.storeRelease(NotCanceled);
+
+    m_cancellation.reset();
 }
 
 inline bool RenderTask::testCancellation()
@@ -185,11 +239,18 @@ inline int RenderTask::loadCancellation() const
 inline void RenderTask::setCancellation(bool force)
 {
     m_wasCanceled.fetchAndStoreRelease(force ? CanceledForcibly : CanceledNormally);
+
+    if(force || !m_prefetch)
+    {
+        m_cancellation.cancel();
+    }
 }
 
 inline void RenderTask::resetCancellation()
 {
     m_wasCanceled.fetchAndStoreRelease(NotCanceled);
+
+    m_cancellation.reset();
 }
 
 inline bool RenderTask::testCancellation()
@@ -0,0 +1,110 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "scrollpredictor.h"
+
+#include <cmath>
+
+namespace qpdfview
+{
+
+namespace
+{
+
+// Samples closer together are merged as both scroll bars report a diagonal movement separately.
+const qint64 minimumSampleInterval = 1000000;
+
+// Scrolling is considered to have stopped if there is no sample for this long.
+const qint64 maximumSampleInterval = 250000000;
+
+// the time constant of smoothing the velocity in milliseconds
+const qreal smoothingTime = 100.0;
+
+} // anonymous
+
+ScrollPredictor::ScrollPredictor() :
+    m_timer(),
+    m_position(),
+    m_velocity()
+{
+}
+
+void ScrollPredictor::addSample(const QPointF& position, qreal maximumDisplacement)
+{
+    if(!m_timer.isValid())
+    {
+        m_timer.start();
+        m_position = position;
+
+        return;
+    }
+
+    const qint64 interval = m_timer.nsecsElapsed();
+
+    if(interval < minimumSampleInterval)
+    {
+        return;
+    }
+
+    const QPointF displacement = position - m_position;
+
+    m_timer.restart();
+    m_position = position;
+
+    if(interval > maximumSampleInterval || displacement.manhattanLength() > maximumDisplacement)
+    {
+        m_velocity = QPointF();
+
+        return;
+    }
+
+    const qreal milliseconds = interval / 1.0e6;
+
+    // Longer intervals weigh more, so that the estimate does not depend on the rate of the samples.
+    const qreal weight = 1.0 - std::exp(-milliseconds / smoothingTime);
+
+    m_velocity += weight * (displacement / milliseconds - m_velocity);
+}
+
+void ScrollPredictor::reset()
+{
+    m_timer.invalidate();
+
+    m_position = QPointF();
+    m_velocity = QPointF();
+}
+
+QPointF ScrollPredictor::velocity() const
+{
+    if(!m_timer.isValid() || m_timer.nsecsElapsed() > maximumSampleInterval)
+    {
+        return {};
+    }
+
+    return m_velocity;
+}
+
+QRectF ScrollPredictor::sweptRect(const QRectF& visibleRect, int milliseconds) const
+{
+    return visibleRect.united(visibleRect.translated(velocity() * milliseconds));
+}
+
+} // qpdfview
@@ -0,0 +1,66 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef SCROLLPREDICTOR_H
+#define SCROLLPREDICTOR_H
+
+#include <QElapsedTimer>
+#include <QPointF>
+#include <QRectF>
+
+#include "global.h"
+
+namespace qpdfview
+{
+
+// Estimates the velocity of scrolling from the successive positions of the viewport,
+// so that the area which will become visible soon can be prefetched first.
+class ScrollPredictor
+{
+public:
+    ScrollPredictor();
+
+    // Positions are in scene coordinates and displacements larger than the maximum are jumps which stop the estimate.
+    void addSample(const QPointF& position, qreal maximumDisplacement);
+    void reset();
+
+    // in scene coordinates per millisecond or null if not scrolling
+    DECL_NODISCARD
+    QPointF velocity() const;
+
+    DECL_NODISCARD
+    bool isScrolling() const { return !velocity().isNull(); }
+
+    // the area covered by the visible rectangle within the given number of milliseconds at the current velocity
+    DECL_NODISCARD
+    QRectF sweptRect(const QRectF& visibleRect, int milliseconds) const;
+
+private:
+    QElapsedTimer m_timer;
+
+    QPointF m_position;
+    QPointF m_velocity;
+
+};
+
+} // qpdfview
+
+#endif // SCROLLPREDICTOR_H
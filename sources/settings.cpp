@@ -116,10 +116,23 @@ Settings::~Settings()
 void Settings::PageItem::sync()
 {
     m_cacheSize = dataSize(m_settings, "pageItem/cacheSize", Defaults::PageItem::cacheSize());
+    m_adaptiveCacheSize = m_settings->value("pageItem/adaptiveCacheSize", Defaults::PageItem::adaptiveCacheSize()).toBool();
+    m_compressedCacheSize = dataSize(m_settings, "pageItem/compressedCacheSize", Defaults::PageItem::compressedCacheSize());
+    m_diskCacheSize = dataSize(m_settings, "pageItem/diskCacheSize", Defaults::PageItem::diskCacheSize());
 
     m_useTiling = m_settings->value("pageItem/useTiling", Defaults::PageItem::useTiling()).toBool();
     m_tileSize = m_settings->value("pageItem/tileSize", Defaults::PageItem::tileSize()).toInt();
 
+    m_progressiveRendering = m_settings->value("pageItem/progressiveRendering", Defaults::PageItem::progressiveRendering()).toBool();
+
+    m_renderThreadCount = m_settings->value("pageItem/renderThreadCount", Defaults::PageItem::renderThreadCount()).toInt();
+    m_renderQueueDepth = m_settings->value("pageItem/renderQueueDepth", Defaults::PageItem::renderQueueDepth()).toInt();
+
+    m_openPageCount = m_settings->value("pageItem/openPageCount", Defaults::PageItem::openPageCount()).toInt();
+
+    m_idlePrerendering = m_settings->value("pageItem/idlePrerendering", Defaults::PageItem::idlePrerendering()).toBool();
+    m_idlePrerenderingShare = m_settings->value("pageItem/idlePrerenderingShare", Defaults::PageItem::idlePrerenderingShare()).toInt();
+
     m_keepObsoletePixmaps = m_settings->value("pageItem/keepObsoletePixmaps", Defaults::PageItem::keepObsoletePixmaps()).toBool();
     m_useDevicePixelRatio = m_settings->value("pageItem/useDevicePixelRatio", Defaults::PageItem::useDevicePixelRatio()).toBool();
 
@@ -142,12 +155,84 @@ void Settings::PageItem::setCacheSize(int cacheSize)
     }
 }
 
+void Settings::PageItem::setAdaptiveCacheSize(bool adaptiveCacheSize)
+{
+    m_adaptiveCacheSize = adaptiveCacheSize;
+    m_settings->setValue("pageItem/adaptiveCacheSize", adaptiveCacheSize);
+}
+
+void Settings::PageItem::setCompressedCacheSize(int compressedCacheSize)
+{
+    if(compressedCacheSize >= 0)
+    {
+        m_compressedCacheSize = compressedCacheSize;
+        setDataSize(m_settings, "pageItem/compressedCacheSize", compressedCacheSize);
+    }
+}
+
+void Settings::PageItem::setDiskCacheSize(int diskCacheSize)
+{
+    if(diskCacheSize >= 0)
+    {
+        m_diskCacheSize = diskCacheSize;
+        setDataSize(m_settings, "pageItem/diskCacheSize", diskCacheSize);
+    }
+}
+
 void Settings::PageItem::setUseTiling(bool useTiling)
 {
     m_useTiling = useTiling;
     m_settings->setValue("pageItem/useTiling", useTiling);
 }
 
+void Settings::PageItem::setProgressiveRendering(bool progressiveRendering)
+{
+    m_progressiveRendering = progressiveRendering;
+    m_settings->setValue("pageItem/progressiveRendering", progressiveRendering);
+}
+
+void Settings::PageItem::setRenderThreadCount(int renderThreadCount)
+{
+    if(renderThreadCount >= 0)
+    {
+        m_renderThreadCount = renderThreadCount;
+        m_settings->setValue("pageItem/renderThreadCount", renderThreadCount);
+    }
+}
+
+void Settings::PageItem::setRenderQueueDepth(int renderQueueDepth)
+{
+    if(renderQueueDepth > 0)
+    {
+        m_renderQueueDepth = renderQueueDepth;
+        m_settings->setValue("pageItem/renderQueueDepth", renderQueueDepth);
+    }
+}
+
+void Settings::PageItem::setOpenPageCount(int openPageCount)
+{
+    if(openPageCount > 0)
+    {
+        m_openPageCount = openPageCount;
+        m_settings->setValue("pageItem/openPageCount", openPageCount);
+    }
+}
+
+void Settings::PageItem::setIdlePrerendering(bool idlePrerendering)
+{
+    m_idlePrerendering = idlePrerendering;
+    m_settings->setValue("pageItem/idlePrerendering", idlePrerendering);
+}
+
+void Settings::PageItem::setIdlePrerenderingShare(int idlePrerenderingShare)
+{
+    if(idlePrerenderingShare > 0 && idlePrerenderingShare <= 100)
+    {
+        m_idlePrerenderingShare = idlePrerenderingShare;
+        m_settings->setValue("pageItem/idlePrerenderingShare", idlePrerenderingShare);
+    }
+}
+
 void Settings::PageItem::setKeepObsoletePixmaps(bool keepObsoletePixmaps)
 {
     m_keepObsoletePixmaps = keepObsoletePixmaps;
@@ -269,8 +354,17 @@ void Settings::PageItem::setFormFieldOverlay(bool overlay)
 Settings::PageItem::PageItem(QSettings* settings) :
     m_settings(settings),
     m_cacheSize(Defaults::PageItem::cacheSize()),
+    m_adaptiveCacheSize(Defaults::PageItem::adaptiveCacheSize()),
+    m_compressedCacheSize(Defaults::PageItem::compressedCacheSize()),
+    m_diskCacheSize(Defaults::PageItem::diskCacheSize()),
     m_useTiling(Defaults::PageItem::useTiling()),
     m_tileSize(Defaults::PageItem::tileSize()),
+    m_progressiveRendering(Defaults::PageItem::progressiveRendering()),
+    m_renderThreadCount(Defaults::PageItem::renderThreadCount()),
+    m_renderQueueDepth(Defaults::PageItem::renderQueueDepth()),
+    m_openPageCount(Defaults::PageItem::openPageCount()),
+    m_idlePrerendering(Defaults::PageItem::idlePrerendering()),
+    m_idlePrerenderingShare(Defaults::PageItem::idlePrerenderingShare()),
     m_progressIcon(),
     m_errorIcon(),
     m_keepObsoletePixmaps(Defaults::PageItem::keepObsoletePixmaps()),
@@ -393,6 +487,11 @@ int Settings::DocumentView::prefetchTimeout() const
     return m_settings->value("documentView/prefetchTimeout", Defaults::DocumentView::prefetchTimeout()).toInt();
 }
 
+int Settings::DocumentView::prefetchHorizon() const
+{
+    return m_settings->value("documentView/prefetchHorizon", Defaults::DocumentView::prefetchHorizon()).toInt();
+}
+
 void Settings::DocumentView::setPagesPerRow(int pagesPerRow)
 {
     if(pagesPerRow > 0)
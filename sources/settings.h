@@ -57,13 +57,57 @@ public:
         int cacheSize() const { return m_cacheSize; }
         void setCacheSize(int cacheSize);
 
+        // grows and shrinks the budget of the cache depending on the available memory and memory pressure,
+        // using the cache size as its lower bound
+        DECL_NODISCARD
+        bool adaptiveCacheSize() const { return m_adaptiveCacheSize; }
+        void setAdaptiveCacheSize(bool adaptiveCacheSize);
+
+        // the budget of the second tier keeping evicted tiles in compressed form
+        DECL_NODISCARD
+        int compressedCacheSize() const { return m_compressedCacheSize; }
+        void setCompressedCacheSize(int compressedCacheSize);
+
+        // the budget of the cache keeping thumbnails and previews on disk
+        DECL_NODISCARD
+        int diskCacheSize() const { return m_diskCacheSize; }
+        void setDiskCacheSize(int diskCacheSize);
+
         DECL_NODISCARD
         bool useTiling() const { return m_useTiling; }
         void setUseTiling(bool useTiling);
 
+        // the tile size in device pixels until the throughput of the backend has been measured
         DECL_NODISCARD
         int tileSize() const { return m_tileSize; }
 
+        DECL_NODISCARD
+        bool progressiveRendering() const { return m_progressiveRendering; }
+        void setProgressiveRendering(bool progressiveRendering);
+
+        DECL_NODISCARD
+        int renderThreadCount() const { return m_renderThreadCount; }
+        void setRenderThreadCount(int renderThreadCount);
+
+        DECL_NODISCARD
+        int renderQueueDepth() const { return m_renderQueueDepth; }
+        void setRenderQueueDepth(int renderQueueDepth);
+
+        // the number of pages of the backend kept open per document, the others are opened on demand
+        DECL_NODISCARD
+        int openPageCount() const { return m_openPageCount; }
+        void setOpenPageCount(int openPageCount);
+
+        // renders low-resolution previews of the whole document while the application is idle
+        DECL_NODISCARD
+        bool idlePrerendering() const { return m_idlePrerendering; }
+        void setIdlePrerendering(bool idlePrerendering);
+
+        // the share of the time of one render thread used for idle prerendering in percent
+        DECL_NODISCARD
+        int idlePrerenderingShare() const { return m_idlePrerenderingShare; }
+        void setIdlePrerenderingShare(int idlePrerenderingShare);
+
         DECL_NODISCARD
         const QIcon& progressIcon() const { return m_progressIcon; }
         void setProgressIcon(const QIcon& progressIcon) { m_progressIcon = progressIcon; }
@@ -139,10 +183,23 @@ public:
         QSettings* m_settings;
 
         int m_cacheSize;
+        bool m_adaptiveCacheSize;
+        int m_compressedCacheSize;
+        int m_diskCacheSize;
 
         bool m_useTiling;
         int m_tileSize;
 
+        bool m_progressiveRendering;
+
+        int m_renderThreadCount;
+        int m_renderQueueDepth;
+
+        int m_openPageCount;
+
+        bool m_idlePrerendering;
+        int m_idlePrerenderingShare;
+
         QIcon m_progressIcon;
         QIcon m_errorIcon;
 
@@ -214,6 +271,10 @@ public:
         DECL_NODISCARD
         int prefetchTimeout() const;
 
+        // how far ahead of scrolling pages are prefetched in milliseconds
+        DECL_NODISCARD
+        int prefetchHorizon() const;
+
         DECL_NODISCARD
         int pagesPerRow() const { return m_pagesPerRow; }
         void setPagesPerRow(int pagesPerRow);
@@ -613,10 +674,24 @@ public:
     {
     public:
         static int cacheSize() { return 32 * 1024; }
+        static bool adaptiveCacheSize() { return false; }
+        static int compressedCacheSize() { return 32 * 1024; }
+        static int diskCacheSize() { return 256 * 1024; }
 
         static bool useTiling() { return false; }
         static int tileSize() { return 1024; }
 
+        static bool progressiveRendering() { return false; }
+
+        // zero selects the ideal thread count
+        static int renderThreadCount() { return 0; }
+        static int renderQueueDepth() { return 256; }
+
+        static int openPageCount() { return 64; }
+
+        static bool idlePrerendering() { return false; }
+        static int idlePrerenderingShare() { return 25; }
+
         static bool keepObsoletePixmaps() { return false; }
         static bool useDevicePixelRatio() { return false; }
 
@@ -669,6 +744,7 @@ public:
         static int prefetchDistance() { return 1; }
 
         static int prefetchTimeout() { return 250; }
+        static int prefetchHorizon() { return 500; }
 
         static int pagesPerRow() { return 3; }
 
@@ -384,6 +384,9 @@ void SettingsDialog::createGraphicsTab()
     m_useTilingCheckBox = addCheckBox(m_graphicsLayout, tr("Use tiling:"), QString(),
                                       s_settings->pageItem().useTiling());
 
+    m_progressiveRenderingCheckBox = addCheckBox(m_graphicsLayout, tr("Progressive rendering:"), tr("Show a low-resolution preview of each page until it is fully rendered"),
+                                                 s_settings->pageItem().progressiveRendering());
+
     m_keepObsoletePixmapsCheckBox = addCheckBox(m_graphicsLayout, tr("Keep obsolete pixmaps:"), QString(),
                                                 s_settings->pageItem().keepObsoletePixmaps());
 
@@ -435,16 +438,41 @@ void SettingsDialog::createGraphicsTab()
     m_cacheSizeComboBox = addDataSizeComboBox(m_graphicsLayout, tr("Cache size:"), QString(),
                                               s_settings->pageItem().cacheSize());
 
+    m_adaptiveCacheSizeCheckBox = addCheckBox(m_graphicsLayout, tr("Adaptive cache size:"), tr("Grow the cache beyond its size while memory is free and shrink it back under memory pressure."),
+                                              s_settings->pageItem().adaptiveCacheSize());
+
+    m_compressedCacheSizeComboBox = addDataSizeComboBox(m_graphicsLayout, tr("Compressed cache size:"), tr("Tiles evicted from the cache are kept compressed up to this size."),
+                                                        s_settings->pageItem().compressedCacheSize());
+
+    m_diskCacheSizeComboBox = addDataSizeComboBox(m_graphicsLayout, tr("Disk cache size:"), tr("Thumbnails and previews are kept on disk up to this size."),
+                                                  s_settings->pageItem().diskCacheSize());
+
     m_prefetchCheckBox = addCheckBox(m_graphicsLayout, tr("Prefetch:"), QString(),
                                      s_settings->documentView().prefetch());
 
     m_prefetchDistanceSpinBox = addSpinBox(m_graphicsLayout, tr("Prefetch distance:"), QString(), QString(), QString(),
                                            1, 10, 1, s_settings->documentView().prefetchDistance());
+
+    m_renderThreadCountSpinBox = addSpinBox(m_graphicsLayout, tr("Render threads:"), QString(), QString(), tr("Automatic"),
+                                            0, 64, 1, s_settings->pageItem().renderThreadCount());
+
+    m_renderQueueDepthSpinBox = addSpinBox(m_graphicsLayout, tr("Render queue depth:"), tr("Maximum number of queued prefetch and thumbnail render tasks"), QString(), QString(),
+                                           16, 4096, 16, s_settings->pageItem().renderQueueDepth());
+
+    m_openPageCountSpinBox = addSpinBox(m_graphicsLayout, tr("Open pages:"), tr("Maximum number of pages kept open by the backend per document. Effective after reloading the document."), QString(), QString(),
+                                        4, 4096, 4, s_settings->pageItem().openPageCount());
+
+    m_idlePrerenderingCheckBox = addCheckBox(m_graphicsLayout, tr("Idle prerendering:"), tr("Render low-resolution previews of the whole document while the application is idle"),
+                                             s_settings->pageItem().idlePrerendering());
+
+    m_idlePrerenderingShareSpinBox = addSpinBox(m_graphicsLayout, tr("Idle prerendering share:"), tr("Share of the time of one render thread used for idle prerendering"), tr(" %"), QString(),
+                                                1, 100, 5, s_settings->pageItem().idlePrerenderingShare());
 }
 
 void SettingsDialog::acceptGraphicsTab()
 {
     s_settings->pageItem().setUseTiling(m_useTilingCheckBox->isChecked());
+    s_settings->pageItem().setProgressiveRendering(m_progressiveRenderingCheckBox->isChecked());
     s_settings->pageItem().setKeepObsoletePixmaps(m_keepObsoletePixmapsCheckBox->isChecked());
     s_settings->pageItem().setUseDevicePixelRatio(m_useDevicePixelRatioCheckBox->isChecked());
 
@@ -464,9 +492,20 @@ void SettingsDialog::acceptGraphicsTab()
     s_settings->documentView().setThumbnailSize(m_thumbnailSizeSpinBox->value());
 
     s_settings->pageItem().setCacheSize(dataFromCurrentIndex(m_cacheSizeComboBox));
+    s_settings->pageItem().setAdaptiveCacheSize(m_adaptiveCacheSizeCheckBox->isChecked());
+    s_settings->pageItem().setCompressedCacheSize(dataFromCurrentIndex(m_compressedCacheSizeComboBox));
+    s_settings->pageItem().setDiskCacheSize(dataFromCurrentIndex(m_diskCacheSizeComboBox));
     s_settings->documentView().setPrefetch(m_prefetchCheckBox->isChecked());
     s_settings->documentView().setPrefetchDistance(m_prefetchDistanceSpinBox->value());
 
+    s_settings->pageItem().setRenderThreadCount(m_renderThreadCountSpinBox->value());
+    s_settings->pageItem().setRenderQueueDepth(m_renderQueueDepthSpinBox->value());
+
+    s_settings->pageItem().setOpenPageCount(m_openPageCountSpinBox->value());
+
+    s_settings->pageItem().setIdlePrerendering(m_idlePrerenderingCheckBox->isChecked());
+    s_settings->pageItem().setIdlePrerenderingShare(m_idlePrerenderingShareSpinBox->value());
+
     if(m_pdfSettingsWidget != nullptr)
     {
         m_pdfSettingsWidget->accept();
@@ -491,6 +530,7 @@ void SettingsDialog::acceptGraphicsTab()
 void SettingsDialog::resetGraphicsTab()
 {
     m_useTilingCheckBox->setChecked(Defaults::PageItem::useTiling());
+    m_progressiveRenderingCheckBox->setChecked(Defaults::PageItem::progressiveRendering());
     m_keepObsoletePixmapsCheckBox->setChecked(Defaults::PageItem::keepObsoletePixmaps());
     m_useDevicePixelRatioCheckBox->setChecked(Defaults::PageItem::useDevicePixelRatio());
 
@@ -510,9 +550,20 @@ void SettingsDialog::resetGraphicsTab()
     m_thumbnailSizeSpinBox->setValue(Defaults::DocumentView::thumbnailSize());
 
     setCurrentIndexFromData(m_cacheSizeComboBox, Defaults::PageItem::cacheSize());
+    m_adaptiveCacheSizeCheckBox->setChecked(Defaults::PageItem::adaptiveCacheSize());
+    setCurrentIndexFromData(m_compressedCacheSizeComboBox, Defaults::PageItem::compressedCacheSize());
+    setCurrentIndexFromData(m_diskCacheSizeComboBox, Defaults::PageItem::diskCacheSize());
     m_prefetchCheckBox->setChecked(Defaults::DocumentView::prefetch());
     m_prefetchDistanceSpinBox->setValue(Defaults::DocumentView::prefetchDistance());
 
+    m_renderThreadCountSpinBox->setValue(Defaults::PageItem::renderThreadCount());
+    m_renderQueueDepthSpinBox->setValue(Defaults::PageItem::renderQueueDepth());
+
+    m_openPageCountSpinBox->setValue(Defaults::PageItem::openPageCount());
+
+    m_idlePrerenderingCheckBox->setChecked(Defaults::PageItem::idlePrerendering());
+    m_idlePrerenderingShareSpinBox->setValue(Defaults::PageItem::idlePrerenderingShare());
+
     if(m_pdfSettingsWidget != nullptr)
     {
         m_pdfSettingsWidget->reset();
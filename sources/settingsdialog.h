@@ -122,6 +122,7 @@ private:
     // graphics
 
     QCheckBox* m_useTilingCheckBox {};
+    QCheckBox* m_progressiveRenderingCheckBox {};
     QCheckBox* m_keepObsoletePixmapsCheckBox {};
     QCheckBox* m_useDevicePixelRatioCheckBox {};
 
@@ -141,9 +142,20 @@ private:
     QDoubleSpinBox* m_thumbnailSizeSpinBox {};
 
     QComboBox* m_cacheSizeComboBox {};
+    QCheckBox* m_adaptiveCacheSizeCheckBox {};
+    QComboBox* m_compressedCacheSizeComboBox {};
+    QComboBox* m_diskCacheSizeComboBox {};
     QCheckBox* m_prefetchCheckBox {};
     QSpinBox* m_prefetchDistanceSpinBox {};
 
+    QSpinBox* m_renderThreadCountSpinBox {};
+    QSpinBox* m_renderQueueDepthSpinBox {};
+
+    QSpinBox* m_openPageCountSpinBox {};
+
+    QCheckBox* m_idlePrerenderingCheckBox {};
+    QSpinBox* m_idlePrerenderingShareSpinBox {};
+
     void createGraphicsTab();
     void acceptGraphicsTab();
     void resetGraphicsTab();
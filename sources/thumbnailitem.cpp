@@ -104,6 +104,21 @@ qreal ThumbnailItem::textHeight() const
 #endif // QT_VERSION
 }
 
+qreal ThumbnailItem::textHeight(const QString& text)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(4,7,0)
+
+    return 2.0 * QStaticText(text).size().height();
+
+#else
+
+    Q_UNUSED(text)
+
+    return 2.0 * QFontMetrics(QFont()).height();
+
+#endif // QT_VERSION
+}
+
 void ThumbnailItem::setHighlighted(bool highlighted)
 {
     if(m_isHighlighted != highlighted)
@@ -66,6 +66,8 @@ public:
 
     DECL_NODISCARD
     qreal textHeight() const;
+    // the height of a label with the given text without creating an item
+    static qreal textHeight(const QString& text);
 
     DECL_UNUSED
     DECL_NODISCARD
@@ -0,0 +1,946 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "tilecache.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include <QApplication>
+#include <QtConcurrentRun>
+#include <qmath.h>
+
+#include "memorymonitor.h"
+
+namespace qpdfview
+{
+
+namespace
+{
+
+inline int cacheCost(const QPixmap& pixmap)
+{
+    return std::max(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+}
+
+inline int cacheCost(const QByteArray& data)
+{
+    return std::max(1, data.size() / 1024);
+}
+
+// Rendered pages are mostly uniform and compress well even at the fastest level.
+const int compressionLevel = 1;
+
+// Tiles more than eight times larger or smaller than the requested ones are not worth stretching.
+const int maximumLevelDistance = 3;
+
+// The adaptive budget of the first tier is kept between these bounds in kilobytes.
+const int minimumAdaptiveCost = 8 * 1024;
+const int maximumAdaptiveCost = 1024 * 1024 * 1024;
+
+// Memory pressure in percent above which the budgets are halved and below which they may grow
+const qreal highMemoryPressure = 10.0;
+const qreal lowMemoryPressure = 1.0;
+
+inline uint combineHash(uint hash, uint value)
+{
+    return hash ^ (value + 0x9e3779b9u + (hash << 6) + (hash >> 2));
+}
+
+} // anonymous
+
+TileCacheKey::TileCacheKey(quint32 document, int index, const RenderParam& renderParam, const QRect& rect) :
+    m_document(document),
+    m_index(index),
+    m_resolutionX(renderParam.resolutionX()),
+    m_resolutionY(renderParam.resolutionY()),
+    m_devicePixelRatio(renderParam.devicePixelRatio()),
+    m_scaleFactor(renderParam.scaleFactor()),
+    m_rotation(renderParam.rotation()),
+    m_flags(static_cast< int >(renderParam.flags())),
+    m_rect(rect),
+    m_level(qFloor(std::log2(qMax(m_scaleFactor, 1.0e-3)))),
+    m_hash(::qHash(pageId()))
+{
+    m_hash = combineHash(m_hash, ::qHash(m_resolutionX));
+    m_hash = combineHash(m_hash, ::qHash(m_resolutionY));
+    m_hash = combineHash(m_hash, ::qHash(m_devicePixelRatio));
+    m_hash = combineHash(m_hash, ::qHash(m_scaleFactor));
+    m_hash = combineHash(m_hash, ::qHash(m_rotation));
+    m_hash = combineHash(m_hash, ::qHash(m_flags));
+    m_hash = combineHash(m_hash, ::qHash(m_rect.x()));
+    m_hash = combineHash(m_hash, ::qHash(m_rect.y()));
+    m_hash = combineHash(m_hash, ::qHash(m_rect.width()));
+    m_hash = combineHash(m_hash, ::qHash(m_rect.height()));
+}
+
+QSizeF TileCacheKey::itemSize(const QSizeF& pageSize) const
+{
+    const QSizeF size = m_rotation == RotateBy90 || m_rotation == RotateBy270 ? pageSize.transposed() : pageSize;
+
+    return QSizeF(qRound(size.width() * m_resolutionX * m_scaleFactor / 72.0),
+                  qRound(size.height() * m_resolutionY * m_scaleFactor / 72.0));
+}
+
+class TileCache::Entry
+{
+public:
+    Entry(TileCache* cache, const Key& key, const QPixmap& pixmap, const QRectF& cropRect) :
+        m_cache(cache),
+        m_key(key),
+        m_object{pixmap, cropRect},
+        m_demote(true)
+    {
+    }
+
+    // QCache deletes entries when evicting them which is when they are demoted into the second tier.
+    ~Entry()
+    {
+        m_cache->onEntryDeleted(m_key, m_demote);
+    }
+
+    void discard() { m_demote = false; }
+
+    const Object& object() const { return m_object; }
+
+private:
+    Q_DISABLE_COPY(Entry)
+
+    TileCache* m_cache;
+    Key m_key;
+    Object m_object;
+    bool m_demote;
+
+};
+
+// Compressed objects are only created, accessed and deleted while holding the mutex of the cache.
+class TileCache::CompressedObject
+{
+public:
+    CompressedObject(const QByteArray& data, const QImage& image, const QRectF& cropRect) :
+        m_cache(nullptr),
+        m_key(),
+        data(data),
+        size(image.size()),
+        format(image.format()),
+        devicePixelRatio(image.devicePixelRatio()),
+        cropRect(cropRect)
+    {
+    }
+
+    // Objects which are still indexed when deleted were evicted by the cache.
+    ~CompressedObject()
+    {
+        if(m_cache != nullptr)
+        {
+            m_cache->onCompressedObjectDeleted(m_key);
+        }
+    }
+
+    void addToIndex(TileCache* cache, const Key& key)
+    {
+        m_cache = cache;
+        m_key = key;
+
+        TileCache::addToIndex(cache->m_compressedIndex, key);
+    }
+
+    void removeFromIndex()
+    {
+        if(m_cache != nullptr)
+        {
+            TileCache::removeFromIndex(m_cache->m_compressedIndex, m_key);
+
+            m_cache = nullptr;
+        }
+    }
+
+private:
+    Q_DISABLE_COPY(CompressedObject)
+
+    TileCache* m_cache;
+    Key m_key;
+
+public:
+    const QByteArray data;
+    const QSize size;
+    const QImage::Format format;
+    const qreal devicePixelRatio;
+    const QRectF cropRect;
+
+};
+
+TileCache* TileCache::s_instance = nullptr;
+
+TileCache* TileCache::instance()
+{
+    if(s_instance == nullptr)
+    {
+        s_instance = new TileCache(qApp);
+    }
+
+    return s_instance;
+}
+
+TileCache::~TileCache()
+{
+    m_demote = false;
+
+    m_compressionPool.waitForDone();
+
+    m_pixmaps.clear();
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    m_compressed.clear();
+
+    foreach(const Blob& blob, m_blobs)
+    {
+        delete blob.object;
+    }
+
+    m_blobs.clear();
+
+    s_instance = nullptr;
+}
+
+void TileCache::setMaxCost(int pixmapCost, int compressedCost)
+{
+    m_initialMaxCost[PixmapTier] = pixmapCost;
+    m_initialMaxCost[CompressedTier] = compressedCost;
+
+    if(!m_adaptive)
+    {
+        applyMaxCost(pixmapCost, compressedCost);
+    }
+}
+
+void TileCache::setAdaptive(bool adaptive)
+{
+    MemoryMonitor* monitor = MemoryMonitor::instance();
+
+    if(m_adaptive == adaptive || !monitor->isSupported())
+    {
+        return;
+    }
+
+    m_adaptive = adaptive;
+
+    if(m_adaptive)
+    {
+        connect(monitor, SIGNAL(sampled()), SLOT(onMemorySampled()));
+    }
+    else
+    {
+        disconnect(monitor, SIGNAL(sampled()), this, SLOT(onMemorySampled()));
+
+        applyMaxCost(m_initialMaxCost[PixmapTier], m_initialMaxCost[CompressedTier]);
+    }
+
+    monitor->setEnabled(m_adaptive);
+}
+
+int TileCache::totalCost(Tier tier) const
+{
+    if(tier == PixmapTier)
+    {
+        return m_pixmaps.totalCost();
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_compressed.totalCost();
+}
+
+int TileCache::maxCost(Tier tier) const
+{
+    if(tier == PixmapTier)
+    {
+        return m_pixmaps.maxCost();
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_compressed.maxCost();
+}
+
+quint64 TileCache::hitCount(Tier tier) const
+{
+    if(tier == PixmapTier)
+    {
+        return m_hitCount[PixmapTier];
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_hitCount[CompressedTier];
+}
+
+quint64 TileCache::missCount(Tier tier) const
+{
+    if(tier == PixmapTier)
+    {
+        return m_missCount[PixmapTier];
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_missCount[CompressedTier];
+}
+
+quint64 TileCache::evictionCount(Tier tier) const
+{
+    if(tier == PixmapTier)
+    {
+        return m_evictionCount[PixmapTier];
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_evictionCount[CompressedTier];
+}
+
+bool TileCache::contains(const Key& key) const
+{
+    if(m_pixmaps.contains(key))
+    {
+        return true;
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    return m_compressed.contains(key);
+}
+
+const TileCache::Object* TileCache::object(const Key& key)
+{
+    if(const Entry* entry = m_pixmaps.object(key))
+    {
+        ++m_hitCount[PixmapTier];
+
+        m_prefetchedKeys.remove(key);
+
+        return &entry->object();
+    }
+
+    ++m_missCount[PixmapTier];
+
+    // Tiles in the second tier are decompressed by a render task instead of while painting.
+    return nullptr;
+}
+
+void TileCache::insert(const Key& key, const QImage& image, const QPixmap& pixmap, const QRectF& cropRect, bool prefetched)
+{
+    Blob blob;
+
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        // A replaced entry shows the same tile, so its compressed form is kept for its successor...
+        blob = m_blobs.take(key);
+        blob.demoted = false;
+
+        // ...as is that of a tile in the second tier which is moved back into the first one.
+        if(CompressedObject* compressedObject = m_compressed.take(key))
+        {
+            compressedObject->removeFromIndex();
+
+            if(blob.isEmpty())
+            {
+                blob.object = compressedObject;
+            }
+            else
+            {
+                delete compressedObject;
+            }
+        }
+    }
+
+    // A replaced entry is not evicted and hence not demoted.
+    if(Entry* entry = m_pixmaps.take(key))
+    {
+        entry->discard();
+        delete entry;
+    }
+
+    const int cost = cacheCost(pixmap);
+
+    if(cost > m_pixmaps.maxCost())
+    {
+        // A running compression finds its tile gone.
+        delete blob.object;
+
+        return;
+    }
+
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        if(blob.isEmpty() && !image.isNull() && m_demote && m_compressed.maxCost() > 0)
+        {
+            blob.ticket = ++m_nextTicket;
+
+            compressLater(key, image, cropRect, blob.ticket);
+        }
+
+        if(!blob.isEmpty())
+        {
+            m_blobs.insert(key, blob);
+        }
+    }
+
+    if(m_pixmaps.insert(key, new Entry(this, key, pixmap, cropRect), cost))
+    {
+        addToIndex(m_pixmapIndex, key);
+
+        if(prefetched)
+        {
+            m_prefetchedKeys.insert(key);
+        }
+    }
+}
+
+bool TileCache::decompress(const Key& key, QImage& image, QRectF& cropRect)
+{
+    QByteArray data;
+    QSize size;
+    QImage::Format format;
+    qreal devicePixelRatio;
+
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        const CompressedObject* compressedObject = m_compressed.object(key);
+
+        if(compressedObject == nullptr)
+        {
+            ++m_missCount[CompressedTier];
+
+            return false;
+        }
+
+        ++m_hitCount[CompressedTier];
+
+        // The object stays in the second tier until the tile is inserted into the first one.
+        data = compressedObject->data;
+        size = compressedObject->size;
+        format = compressedObject->format;
+        devicePixelRatio = compressedObject->devicePixelRatio;
+        cropRect = compressedObject->cropRect;
+    }
+
+    image = decompress(data, size, format, devicePixelRatio);
+
+    return !image.isNull();
+}
+
+QVector< TileCache::Fallback > TileCache::fallbacks(const Key& key, const QRectF& normalizedRect, const QSizeF& pageSize) const
+{
+    QVector< Fallback > fallbacks;
+
+    const auto pyramid = m_pixmapIndex.constFind(key.pageId());
+
+    if(pyramid == m_pixmapIndex.constEnd())
+    {
+        return fallbacks;
+    }
+
+    // Sharper levels are preferred over blurrier ones at the same distance.
+    for(int distance = 0; distance <= maximumLevelDistance && fallbacks.isEmpty(); ++distance)
+    {
+        for(int level : {key.level() + distance, key.level() - distance})
+        {
+            const auto keys = pyramid->constFind(level);
+
+            if(keys == pyramid->constEnd())
+            {
+                continue;
+            }
+
+            foreach(const Key& otherKey, *keys)
+            {
+                if(otherKey == key || !otherKey.isSameLayer(key))
+                {
+                    continue;
+                }
+
+                const QSizeF itemSize = otherKey.itemSize(pageSize);
+
+                if(itemSize.isEmpty())
+                {
+                    continue;
+                }
+
+                const QRect& rect = otherKey.rect();
+
+                const QRectF otherNormalizedRect = rect.isNull()
+                        ? QRectF(0.0, 0.0, 1.0, 1.0)
+                        : QRectF(rect.x() / itemSize.width(), rect.y() / itemSize.height(),
+                                 rect.width() / itemSize.width(), rect.height() / itemSize.height());
+
+                if(!otherNormalizedRect.intersects(normalizedRect))
+                {
+                    continue;
+                }
+
+                if(const Entry* entry = m_pixmaps.object(otherKey))
+                {
+                    fallbacks.append(Fallback{entry->object().pixmap, otherNormalizedRect, otherKey.scaleFactor()});
+                }
+            }
+
+            if(!fallbacks.isEmpty() || distance == 0)
+            {
+                break;
+            }
+        }
+    }
+
+    const auto dissimilarity = [&key](const Fallback& fallback)
+    {
+        return qAbs(std::log2(fallback.scaleFactor / key.scaleFactor()));
+    };
+
+    std::sort(fallbacks.begin(), fallbacks.end(), [&dissimilarity](const Fallback& left, const Fallback& right)
+    {
+        return dissimilarity(left) > dissimilarity(right);
+    });
+
+    return fallbacks;
+}
+
+quint32 TileCache::acquireDocument(const QByteArray& documentId)
+{
+    quint32 document = documentId.isEmpty() ? 0 : m_documentKeys.value(documentId);
+
+    if(document == 0)
+    {
+        document = m_nextDocument++;
+
+        if(!documentId.isEmpty())
+        {
+            m_documentKeys.insert(documentId, document);
+        }
+
+        m_documents.insert(document, Document{documentId, 0});
+    }
+
+    ++m_documents[document].users;
+
+    return document;
+}
+
+void TileCache::releaseDocument(quint32 document)
+{
+    const auto entry = m_documents.find(document);
+
+    if(entry == m_documents.end() || --entry->users > 0)
+    {
+        return;
+    }
+
+    m_documentKeys.remove(entry->id);
+    m_documents.erase(entry);
+
+    remove(document);
+}
+
+void TileCache::remove(quint32 document, int index)
+{
+    const quint64 pageId = Key::pageId(document, index);
+
+    foreach(const QSet< Key >& keys, m_pixmapIndex.take(pageId))
+    {
+        foreach(const Key& key, keys)
+        {
+            if(Entry* entry = m_pixmaps.take(key))
+            {
+                entry->discard();
+                delete entry;
+            }
+        }
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    foreach(const QSet< Key >& keys, m_compressedIndex.take(pageId))
+    {
+        foreach(const Key& key, keys)
+        {
+            discardCompressed(key);
+        }
+    }
+
+    ++m_generations[pageId];
+}
+
+void TileCache::remove(quint32 document)
+{
+    QSet< int > indices;
+
+    for(auto pyramid = m_pixmapIndex.constBegin(); pyramid != m_pixmapIndex.constEnd(); ++pyramid)
+    {
+        if(quint32(pyramid.key() >> 32) == document)
+        {
+            indices.insert(int(quint32(pyramid.key())));
+        }
+    }
+
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        for(auto pyramid = m_compressedIndex.constBegin(); pyramid != m_compressedIndex.constEnd(); ++pyramid)
+        {
+            if(quint32(pyramid.key() >> 32) == document)
+            {
+                indices.insert(int(quint32(pyramid.key())));
+            }
+        }
+
+        // This also covers pages whose tiles are only being compressed.
+        ++m_generations[Key::pageId(document, -1)];
+    }
+
+    foreach(int index, indices)
+    {
+        remove(document, index);
+    }
+
+    QMutexLocker mutexLocker(&m_mutex);
+
+    // As documents are never given the same key again, the generation of the document itself is kept,
+    // but those of its pages are not needed anymore.
+    for(auto generation = m_generations.begin(); generation != m_generations.end();)
+    {
+        if(quint32(generation.key() >> 32) == document && generation.key() != Key::pageId(document, -1))
+        {
+            generation = m_generations.erase(generation);
+        }
+        else
+        {
+            ++generation;
+        }
+    }
+}
+
+TileCache::TileCache(QObject* parent) : QObject(parent),
+    m_documentKeys(),
+    m_documents(),
+    m_nextDocument(1),
+    m_pixmaps(),
+    m_prefetchedKeys(),
+    m_pixmapIndex(),
+    m_initialMaxCost(),
+    m_adaptive(false),
+    m_mutex(),
+    m_compressed(),
+    m_compressedIndex(),
+    m_blobs(),
+    m_nextTicket(0),
+    m_generations(),
+    m_compressionPool(),
+    m_demote(true),
+    m_hitCount(),
+    m_missCount(),
+    m_evictionCount()
+{
+    m_compressionPool.setMaxThreadCount(1);
+}
+
+void TileCache::addToIndex(Index& index, const Key& key)
+{
+    index[key.pageId()][key.level()].insert(key);
+}
+
+void TileCache::removeFromIndex(Index& index, const Key& key)
+{
+    const auto pyramid = index.find(key.pageId());
+
+    if(pyramid == index.end())
+    {
+        return;
+    }
+
+    const auto keys = pyramid->find(key.level());
+
+    if(keys != pyramid->end())
+    {
+        keys->remove(key);
+
+        if(keys->isEmpty())
+        {
+            pyramid->erase(keys);
+        }
+    }
+
+    if(pyramid->isEmpty())
+    {
+        index.erase(pyramid);
+    }
+}
+
+void TileCache::applyMaxCost(int pixmapCost, int compressedCost)
+{
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        m_compressed.setMaxCost(compressedCost);
+    }
+
+    m_pixmaps.setMaxCost(pixmapCost);
+}
+
+void TileCache::onMemorySampled()
+{
+    const MemoryMonitor::Sample& sample = MemoryMonitor::instance()->sample();
+
+    // A tenth of the memory is kept in reserve for the rest of the process and the system.
+    const qint64 headroom = sample.available - sample.limit / 10;
+
+    const bool underPressure = sample.pressure >= highMemoryPressure || headroom < 0;
+
+    const int maxCost = m_pixmaps.maxCost();
+    qint64 cost = maxCost;
+
+    if(underPressure)
+    {
+        cost = maxCost / 2;
+    }
+    else if(sample.pressure < lowMemoryPressure)
+    {
+        // Growing is gradual, by at most a quarter per sample and a quarter of the headroom.
+        cost = qMin(maxCost + qMin(qint64(maxCost / 4), headroom / 4), sample.limit / 4);
+    }
+
+    const auto adaptiveCost = static_cast< int >(qBound(qint64(minimumAdaptiveCost), cost, qint64(maximumAdaptiveCost)));
+
+    // The second tier shrinks along with the first one, but never grows beyond its initial budget.
+    const int initialCost = qMax(1, m_initialMaxCost[PixmapTier]);
+    const int compressedCost = static_cast< int >(qMin(qint64(m_initialMaxCost[CompressedTier]),
+                                                       qint64(m_initialMaxCost[CompressedTier]) * adaptiveCost / initialCost));
+
+    if(!underPressure)
+    {
+        if(adaptiveCost != maxCost)
+        {
+            applyMaxCost(adaptiveCost, compressedCost);
+        }
+
+        return;
+    }
+
+    dropPrefetched();
+
+    // Tiles evicted under pressure are not worth compressing.
+    m_demote = false;
+
+    applyMaxCost(adaptiveCost, compressedCost);
+
+    m_demote = true;
+
+    emit memoryPressure();
+}
+
+void TileCache::dropPrefetched()
+{
+    foreach(const Key& key, m_prefetchedKeys)
+    {
+        if(Entry* entry = m_pixmaps.take(key))
+        {
+            ++m_evictionCount[PixmapTier];
+
+            entry->discard();
+            delete entry;
+        }
+    }
+
+    m_prefetchedKeys.clear();
+}
+
+void TileCache::onEntryDeleted(const Key& key, bool demote)
+{
+    removeFromIndex(m_pixmapIndex, key);
+
+    m_prefetchedKeys.remove(key);
+
+    // Only entries evicted by the cache are demoted.
+    if(demote)
+    {
+        ++m_evictionCount[PixmapTier];
+
+        this->demote(key);
+    }
+    else
+    {
+        QMutexLocker mutexLocker(&m_mutex);
+
+        discardBlob(key);
+    }
+}
+
+void TileCache::demote(const Key& key)
+{
+    QMutexLocker mutexLocker(&m_mutex);
+
+    const auto blob = m_blobs.find(key);
+
+    if(blob == m_blobs.end())
+    {
+        return;
+    }
+
+    if(!m_demote)
+    {
+        discardBlob(key);
+        return;
+    }
+
+    if(blob->object == nullptr)
+    {
+        // The tile is moved into the second tier as soon as it is compressed.
+        blob->demoted = true;
+        return;
+    }
+
+    CompressedObject* compressedObject = blob->object;
+    m_blobs.erase(blob);
+
+    insertCompressed(key, compressedObject);
+}
+
+void TileCache::compressLater(const Key& key, const QImage& image, const QRectF& cropRect, quint64 ticket)
+{
+    // The generations are only modified on the main thread, so they can be read here without locking.
+    const Generation generation = this->generation(key);
+
+    QtConcurrent::run(&m_compressionPool, [this, key, image, cropRect, ticket, generation]()
+    {
+        CompressedObject* compressedObject = compress(image, cropRect);
+
+        QMutexLocker mutexLocker(&m_mutex);
+
+        const auto blob = m_blobs.find(key);
+
+        // The tile was discarded or inserted again meanwhile.
+        if(blob == m_blobs.end() || blob->ticket != ticket)
+        {
+            delete compressedObject;
+            return;
+        }
+
+        if(compressedObject == nullptr || generation != this->generation(key))
+        {
+            delete compressedObject;
+            m_blobs.erase(blob);
+            return;
+        }
+
+        if(!blob->demoted)
+        {
+            blob->object = compressedObject;
+            blob->ticket = 0;
+            return;
+        }
+
+        m_blobs.erase(blob);
+
+        insertCompressed(key, compressedObject);
+    });
+}
+
+void TileCache::discardBlob(const Key& key)
+{
+    // A running compression finds its tile gone.
+    delete m_blobs.take(key).object;
+}
+
+TileCache::Generation TileCache::generation(const Key& key) const
+{
+    return qMakePair(m_generations.value(Key::pageId(key.document(), -1)), m_generations.value(key.pageId()));
+}
+
+void TileCache::onCompressedObjectDeleted(const Key& key)
+{
+    removeFromIndex(m_compressedIndex, key);
+
+    ++m_evictionCount[CompressedTier];
+}
+
+void TileCache::insertCompressed(const Key& key, CompressedObject* compressedObject)
+{
+    const int cost = cacheCost(compressedObject->data);
+
+    // QCache deletes objects exceeding its budget right away.
+    if(cost > m_compressed.maxCost())
+    {
+        delete compressedObject;
+        return;
+    }
+
+    // A replaced object would take the key of its successor out of the index.
+    discardCompressed(key);
+
+    compressedObject->addToIndex(this, key);
+
+    m_compressed.insert(key, compressedObject, cost);
+}
+
+void TileCache::discardCompressed(const Key& key)
+{
+    if(CompressedObject* compressedObject = m_compressed.take(key))
+    {
+        compressedObject->removeFromIndex();
+        delete compressedObject;
+    }
+}
+
+TileCache::CompressedObject* TileCache::compress(const QImage& image, const QRectF& cropRect)
+{
+    // Indexed images would need their color table, but rendered tiles are never converted into them.
+    if(image.isNull() || image.colorCount() != 0)
+    {
+        return nullptr;
+    }
+
+    return new CompressedObject(qCompress(image.constBits(), static_cast< int >(image.sizeInBytes()), compressionLevel),
+                                image, cropRect);
+}
+
+QImage TileCache::decompress(const QByteArray& data, const QSize& size, QImage::Format format, qreal devicePixelRatio)
+{
+    const QByteArray pixels = qUncompress(data);
+
+    QImage image(size, format);
+
+    if(image.isNull() || pixels.size() != image.sizeInBytes())
+    {
+        return {};
+    }
+
+    std::memcpy(image.bits(), pixels.constData(), static_cast< size_t >(pixels.size()));
+
+    image.setDevicePixelRatio(devicePixelRatio);
+
+    return image;
+}
+
+} // qpdfview
@@ -0,0 +1,328 @@
+/*
+
+Copyright 2026 Alvin Ahmadov
+
+This file is part of qpdfview.
+
+qpdfview is free software: you can redistribute it and/or modify
+it under the terms of the GNU General Public License as published by
+the Free Software Foundation, either version 2 of the License, or
+(at your option) any later version.
+
+qpdfview is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef TILECACHE_H
+#define TILECACHE_H
+
+#include <QByteArray>
+#include <QCache>
+#include <QHash>
+#include <QImage>
+#include <QMap>
+#include <QMutex>
+#include <QObject>
+#include <QPair>
+#include <QPixmap>
+#include <QRectF>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
+
+#include "global.h"
+#include "renderparam.h"
+
+namespace qpdfview
+{
+
+// Identifies a tile by its document, page index, render parameters and rectangle.
+// It has a fixed size and its hash is computed once, so that looking up tiles does not allocate.
+class TileCacheKey
+{
+public:
+    TileCacheKey() = default;
+    TileCacheKey(quint32 document, int index, const RenderParam& renderParam, const QRect& rect);
+
+    // the key of no tile as no document is given the key zero
+    DECL_NODISCARD
+    bool isNull() const { return m_document == 0; }
+
+    DECL_NODISCARD
+    quint32 document() const { return m_document; }
+    DECL_NODISCARD
+    int index() const { return m_index; }
+
+    DECL_NODISCARD
+    quint64 pageId() const { return pageId(m_document, m_index); }
+    static quint64 pageId(quint32 document, int index) { return (quint64(document) << 32) | quint32(index); }
+
+    DECL_NODISCARD
+    uint hash() const { return m_hash; }
+
+    DECL_NODISCARD
+    qreal scaleFactor() const { return m_scaleFactor; }
+    DECL_NODISCARD
+    const QRect& rect() const { return m_rect; }
+
+    // the power-of-two resolution level of the scale factor, i.e. its binary logarithm rounded down
+    DECL_NODISCARD
+    int level() const { return m_level; }
+
+    // true if the other key differs at most in its scale factor and rectangle
+    DECL_NODISCARD
+    bool isSameLayer(const TileCacheKey& other) const
+    {
+        return m_document == other.m_document
+                && m_index == other.m_index
+                && m_resolutionX == other.m_resolutionX
+                && m_resolutionY == other.m_resolutionY
+                && m_devicePixelRatio == other.m_devicePixelRatio
+                && m_rotation == other.m_rotation
+                && m_flags == other.m_flags;
+    }
+
+    // the size of the page item in pixels given the size of the page in points
+    DECL_NODISCARD
+    QSizeF itemSize(const QSizeF& pageSize) const;
+
+    bool operator==(const TileCacheKey& other) const
+    {
+        return m_hash == other.m_hash
+                && m_document == other.m_document
+                && m_index == other.m_index
+                && m_resolutionX == other.m_resolutionX
+                && m_resolutionY == other.m_resolutionY
+                && m_devicePixelRatio == other.m_devicePixelRatio
+                && m_scaleFactor == other.m_scaleFactor
+                && m_rotation == other.m_rotation
+                && m_flags == other.m_flags
+                && m_rect == other.m_rect;
+    }
+
+    bool operator!=(const TileCacheKey& other) const { return !operator==(other); }
+
+private:
+    quint32 m_document {};
+    int m_index {};
+
+    int m_resolutionX {};
+    int m_resolutionY {};
+    qreal m_devicePixelRatio {};
+    qreal m_scaleFactor {};
+    int m_rotation {};
+    int m_flags {};
+
+    QRect m_rect;
+
+    int m_level {};
+    uint m_hash {};
+
+};
+
+inline uint qHash(const TileCacheKey& key, uint seed = 0)
+{
+    return key.hash() ^ seed;
+}
+
+// Keeps rendered tiles in two tiers: pixmaps ready to be painted and, behind them,
+// tiles evicted from the first tier which are kept losslessly compressed in memory.
+// Tiles are compressed from their rendered images in the background when they are inserted,
+// so that evicting them only moves their compressed form into the second tier. Render tasks decompress
+// tiles found in the second tier instead of rendering them again and deliver them like rendered ones.
+//
+// In adaptive mode, the budgets follow the samples of the memory monitor: they grow while memory is free
+// and are halved under memory pressure, dropping prefetched tiles which were never painted first.
+class TileCache : public QObject
+{
+    Q_OBJECT
+
+public:
+    typedef TileCacheKey Key;
+
+    struct Object
+    {
+        QPixmap pixmap;
+        QRectF cropRect;
+    };
+
+    enum Tier
+    {
+        PixmapTier = 0,
+        CompressedTier = 1,
+        NumberOfTiers = 2
+    };
+
+    static TileCache* instance();
+    ~TileCache() override;
+
+    // in kilobytes, which are the initial budgets in adaptive mode
+    void setMaxCost(int pixmapCost, int compressedCost);
+
+    DECL_NODISCARD
+    bool isAdaptive() const { return m_adaptive; }
+    void setAdaptive(bool adaptive);
+
+    DECL_NODISCARD
+    int totalCost(Tier tier) const;
+    DECL_NODISCARD
+    int maxCost(Tier tier) const;
+
+    DECL_NODISCARD
+    bool contains(const Key& key) const;
+
+    // The returned object is only valid until the next insertion. Tiles in the second tier are not returned.
+    const Object* object(const Key& key);
+    // The image is the one the pixmap was uploaded from, if it is still at hand, which is compressed in the background.
+    void insert(const Key& key, const QImage& image, const QPixmap& pixmap, const QRectF& cropRect, bool prefetched = false);
+
+    // Decompresses a tile of the second tier. This is thread-safe and done by the render tasks, so that painting never waits for it.
+    bool decompress(const Key& key, QImage& image, QRectF& cropRect);
+
+    // Views showing the same document identity share their tiles. The tiles of a document
+    // are dropped when its last page releases it. Empty identities are never shared.
+    quint32 acquireDocument(const QByteArray& documentId);
+    void releaseDocument(quint32 document);
+
+    // the key of a document identity which is currently acquired or zero
+    DECL_NODISCARD
+    quint32 documentKey(const QByteArray& documentId) const { return documentId.isEmpty() ? 0 : m_documentKeys.value(documentId); }
+
+    void remove(quint32 document, int index);
+
+    struct Fallback
+    {
+        QPixmap pixmap;
+        QRectF normalizedRect;
+        qreal scaleFactor;
+    };
+
+    // Looks for cached tiles of the same page rendered at the nearest other resolution level
+    // which cover the given normalized rectangle, so they can be stretched while the tile is rendered.
+    // The tiles are ordered from the least to the most similar scale factor.
+    DECL_NODISCARD
+    QVector< Fallback > fallbacks(const Key& key, const QRectF& normalizedRect, const QSizeF& pageSize) const;
+
+    DECL_NODISCARD
+    quint64 hitCount(Tier tier) const;
+    DECL_NODISCARD
+    quint64 missCount(Tier tier) const;
+    DECL_NODISCARD
+    quint64 evictionCount(Tier tier) const;
+
+signals:
+    // emitted when the budgets are reduced under memory pressure so that other pixmaps can be released as well
+    void memoryPressure();
+
+protected slots:
+    void onMemorySampled();
+
+private:
+    Q_DISABLE_COPY(TileCache)
+
+    static TileCache* s_instance;
+    explicit TileCache(QObject* parent = nullptr);
+
+    class Entry;
+    friend class Entry;
+
+    struct Document
+    {
+        QByteArray id;
+        int users;
+    };
+
+    QHash< QByteArray, quint32 > m_documentKeys;
+    QHash< quint32, Document > m_documents;
+    quint32 m_nextDocument;
+
+    void remove(quint32 document);
+
+    QCache< Key, Entry > m_pixmaps;
+
+    // tiles which were prefetched and not yet requested
+    QSet< Key > m_prefetchedKeys;
+
+    // The keys of each tier are indexed by page and resolution level,
+    // so that the tiles of a page can be removed and the nearest level can be found without a full scan.
+    typedef QMap< int, QSet< Key > > Pyramid;
+    typedef QHash< quint64, Pyramid > Index;
+
+    Index m_pixmapIndex;
+
+    static void addToIndex(Index& index, const Key& key);
+    static void removeFromIndex(Index& index, const Key& key);
+
+    void applyMaxCost(int pixmapCost, int compressedCost);
+
+    int m_initialMaxCost[NumberOfTiers];
+    bool m_adaptive;
+
+    void dropPrefetched();
+
+    void onEntryDeleted(const Key& key, bool demote);
+    void demote(const Key& key);
+
+    class CompressedObject;
+    friend class CompressedObject;
+
+    static CompressedObject* compress(const QImage& image, const QRectF& cropRect);
+    static QImage decompress(const QByteArray& data, const QSize& size, QImage::Format format, qreal devicePixelRatio);
+
+    void onCompressedObjectDeleted(const Key& key);
+    void insertCompressed(const Key& key, CompressedObject* compressedObject);
+    void discardCompressed(const Key& key);
+
+    // The second tier is filled by the compression pool and read by the render tasks and hence guarded by a mutex.
+    mutable QMutex m_mutex;
+    QCache< Key, CompressedObject > m_compressed;
+    Index m_compressedIndex;
+
+    // the compressed forms of the tiles in the first tier, which are small compared to their pixmaps
+    // and therefore not accounted for
+    struct Blob
+    {
+        CompressedObject* object {};
+
+        // the compression which is still running, if any
+        quint64 ticket {};
+        // whether the tile was evicted while it was compressed
+        bool demoted {};
+
+        DECL_NODISCARD
+        bool isEmpty() const { return object == nullptr && ticket == 0; }
+    };
+
+    QHash< Key, Blob > m_blobs;
+    quint64 m_nextTicket;
+
+    // These are called while holding the mutex.
+    void compressLater(const Key& key, const QImage& image, const QRectF& cropRect, quint64 ticket);
+    void discardBlob(const Key& key);
+
+    // Tiles which are still being compressed when their page or document is removed must not be inserted afterwards.
+    // The generations are counted per page and, using the index -1, per document, so that removing a page
+    // does not affect other pages. They are only modified on the main thread.
+    QHash< quint64, quint64 > m_generations;
+
+    typedef QPair< quint64, quint64 > Generation;
+    Generation generation(const Key& key) const;
+
+    QThreadPool m_compressionPool;
+    bool m_demote;
+
+    quint64 m_hitCount[NumberOfTiers];
+    quint64 m_missCount[NumberOfTiers];
+    quint64 m_evictionCount[NumberOfTiers];
+
+};
+
+} // qpdfview
+
+#endif // TILECACHE_H
@@ -23,8 +23,10 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <QPainter>
 
+#include "disktilecache.h"
 #include "settings.h"
 #include "pageitem.h"
+#include "renderscheduler.h"
 
 namespace qpdfview
 {
@@ -32,25 +34,27 @@ namespace qpdfview
 namespace
 {
 
-inline int cacheCost(const QPixmap& pixmap)
-{
-    return std::max(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
-}
+// The preview is rendered at a quarter of the resolution, i.e. at a sixteenth of the cost.
+const qreal previewScaleFactor = 0.25;
 
 } // anonymous
 
 Settings* TileItem::s_settings = nullptr;
 
-QCache< TileItem::CacheKey, TileItem::CacheObject > TileItem::s_cache;
+TileCache* TileItem::s_cache = nullptr;
+
+DiskTileCache* TileItem::s_diskCache = nullptr;
 
-TileItem::TileItem(PageItem* page) : RenderTaskParent(),
+TileItem::TileItem(PageItem* page, bool preview) : RenderTaskParent(),
     m_page(page),
+    m_preview(preview),
     m_rect(),
     m_cropRect(),
     m_pixmapError(false),
     m_pixmap(),
     m_obsoletePixmap(),
     m_deleteAfterRender(false),
+    m_prerendering(false),
     m_renderTask(m_page->m_page, this)
 {
     if(s_settings == nullptr)
@@ -58,7 +62,20 @@ TileItem::TileItem(PageItem* page) : RenderTaskParent(),
         s_settings = Settings::instance();
     }
 
-    s_cache.setMaxCost(s_settings->pageItem().cacheSize());
+    if(s_cache == nullptr)
+    {
+        s_cache = TileCache::instance();
+    }
+
+    s_cache->setMaxCost(s_settings->pageItem().cacheSize(), s_settings->pageItem().compressedCacheSize());
+    s_cache->setAdaptive(s_settings->pageItem().adaptiveCacheSize());
+
+    if(s_diskCache == nullptr)
+    {
+        s_diskCache = DiskTileCache::instance();
+    }
+
+    s_diskCache->setMaxSize(s_settings->pageItem().diskCacheSize());
 }
 
 TileItem::~TileItem()
@@ -84,16 +101,23 @@ void TileItem::setCropRect(const QRectF& cropRect)
 
 void TileItem::dropCachedPixmaps(PageItem* page)
 {
-    foreach(const CacheKey& key, s_cache.keys())
+    if(s_cache != nullptr)
     {
-        if(key.first == page)
-        {
-            s_cache.remove(key);
-        }
+        s_cache->remove(page->m_documentKey, page->m_index);
     }
 }
 
-bool TileItem::paint(QPainter* painter, QPointF topLeft)
+bool TileItem::isReady() const
+{
+    return m_pixmapError || !m_pixmap.isNull() || s_cache->contains(cacheKey());
+}
+
+bool TileItem::isPrerendered() const
+{
+    return isReady() || (useDiskCache() && s_diskCache->contains(diskCacheKey()));
+}
+
+bool TileItem::paint(QPainter* painter, QPointF topLeft, bool hasPreview)
 {
     const QPixmap& pixmap = takePixmap();
 
@@ -105,6 +129,18 @@ bool TileItem::paint(QPainter* painter, QPointF topLeft)
 
         return true;
     }
+    else if(paintFallback(painter, topLeft))
+    {
+        // pixmaps of other resolution levels
+
+        return false;
+    }
+    else if(hasPreview)
+    {
+        // preview painted by the page
+
+        return false;
+    }
     else if(!m_obsoletePixmap.isNull())
     {
         // obsolete pixmap
@@ -139,14 +175,38 @@ bool TileItem::paint(QPainter* painter, QPointF topLeft)
     }
 }
 
+bool TileItem::paintPreview(QPainter* painter, const QRectF& rect)
+{
+    QPixmap pixmap = takePixmap();
+
+    if(pixmap.isNull())
+    {
+        pixmap = m_obsoletePixmap;
+    }
+
+    if(pixmap.isNull())
+    {
+        return false;
+    }
+
+    painter->save();
+
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+    painter->drawPixmap(rect, pixmap, QRectF());
+
+    painter->restore();
+
+    return true;
+}
+
 void TileItem::refresh(bool keepObsoletePixmaps)
 {
     if(keepObsoletePixmaps && s_settings->pageItem().keepObsoletePixmaps())
     {
-        const auto object = s_cache.object(cacheKey());
+        const auto object = s_cache->object(cacheKey());
         if(object != nullptr)
         {
-            m_obsoletePixmap = object->first;
+            m_obsoletePixmap = object->pixmap;
         }
     }
     else
@@ -165,24 +225,120 @@ void TileItem::refresh(bool keepObsoletePixmaps)
     m_pixmap = QPixmap();
 }
 
+qreal TileItem::previewScale()
+{
+    return previewScaleFactor;
+}
+
+QRect TileItem::previewRect(const QRectF& boundingRect)
+{
+    return QRect(0, 0, static_cast<int>(boundingRect.width()), static_cast<int>(boundingRect.height()));
+}
+
+bool TileItem::isPreviewPrerendered(const QByteArray& documentId, bool persistentDocumentId, int index,
+                                    const RenderParam& pageRenderParam, const QRectF& boundingRect)
+{
+    const RenderParam renderParam = previewRenderParam(pageRenderParam);
+
+    // Without an acquired identity, no tiles of the document can be cached in memory.
+    const quint32 documentKey = TileCache::instance()->documentKey(documentId);
+
+    if(documentKey != 0 && TileCache::instance()->contains(CacheKey(documentKey, index, renderParam, previewRect(boundingRect))))
+    {
+        return true;
+    }
+
+    return persistentDocumentId && DiskTileCache::instance()->contains(DiskTileCache::Key(documentId, index, renderParam, QRect(), Settings::instance()->pageItem().paperColor()));
+}
+
 int TileItem::startRender(bool prefetch)
 {
-    m_page->startLoadInteractiveElements();
+    return startRender(prefetch, renderPriority(prefetch));
+}
 
-    if(m_pixmapError || m_renderTask.isRunning() || (prefetch && s_cache.contains(cacheKey())))
+int TileItem::startPrerender()
+{
+    if(isPrerendered())
     {
         return 0;
     }
 
-    m_renderTask.start(m_page->m_renderParam, m_rect, prefetch);
+    if(startRender(true, RenderPriority(RenderPriority::IdleClass)) == 0)
+    {
+        return 0;
+    }
+
+    m_prerendering = true;
 
     return 1;
 }
 
-void TileItem::cancelRender()
+bool TileItem::cancelPrerender()
 {
+    if(!m_prerendering || !m_renderTask.isRunning())
+    {
+        return false;
+    }
+
+    m_prerendering = false;
+
+    // A task which has not started yet is unscheduled and a running one is aborted.
     m_renderTask.cancel();
 
+    return true;
+}
+
+int TileItem::startRender(bool prefetch, const RenderPriority& priority)
+{
+    // Prerendering far from the viewport does not need the interactive elements,
+    // and loading them would keep the backend pages of the whole document open.
+    if(priority.priorityClass() != RenderPriority::IdleClass)
+    {
+        m_page->startLoadInteractiveElements();
+    }
+
+    if(m_pixmapError || (prefetch && s_cache->contains(cacheKey())))
+    {
+        return 0;
+    }
+
+    if(useDiskCache())
+    {
+        // Prefetching leaves the entry on disk until it is painted.
+        if(prefetch ? s_diskCache->contains(diskCacheKey()) : loadFromDiskCache())
+        {
+            return 0;
+        }
+    }
+
+    if(m_renderTask.isRunning())
+    {
+        // Move a pending task ahead as the viewport moves, but never behind because of a prefetch.
+        // A prerender is moved ahead by any other request and is then not paused by user input anymore.
+        if(!prefetch || (m_prerendering && priority.priorityClass() != RenderPriority::IdleClass))
+        {
+            m_renderTask.reprioritize(priority);
+
+            m_prerendering = false;
+        }
+
+        return 0;
+    }
+
+    m_renderTask.start(renderParam(), renderRect(), prefetch, priority, sharingKey(), cacheKey());
+
+    return 1;
+}
+
+void TileItem::cancelRender()
+{
+    // Tiles which scrolled out of view before their task started are still rendered into the cache,
+    // but only after everything that is visible.
+    if(!m_renderTask.demote(renderPriority(true)))
+    {
+        m_renderTask.cancel();
+    }
+
     m_pixmap = QPixmap();
     m_obsoletePixmap = QPixmap();
 }
@@ -203,9 +359,9 @@ void TileItem::deleteAfterRender()
 
 void TileItem::onFinished(const RenderParam& renderParam,
                           const QRect& rect, bool prefetch,
-                          const QImage& image, const QRectF& cropRect)
+                          const QImage& image, const QPixmap& pixmap, const QRectF& cropRect)
 {
-    if(m_page->m_renderParam != renderParam || m_rect != rect)
+    if(this->renderParam() != renderParam || renderRect() != rect)
     {
         onFinishedOrCanceled();
         return;
@@ -213,7 +369,7 @@ void TileItem::onFinished(const RenderParam& renderParam,
 
     m_obsoletePixmap = QPixmap();
 
-    if(image.isNull())
+    if(pixmap.isNull())
     {
         m_pixmapError = true;
 
@@ -221,17 +377,23 @@ void TileItem::onFinished(const RenderParam& renderParam,
         return;
     }
 
-    if(prefetch && !m_renderTask.wasCanceledForcibly())
+    if(useDiskCache())
     {
-        const QPixmap pixmap = QPixmap::fromImage(image);
+        s_diskCache->store(diskCacheKey(), image, cropRect);
+    }
 
-        s_cache.insert(cacheKey(), new CacheObject(pixmap, cropRect), cacheCost(pixmap));
+    if(prefetch && !m_renderTask.wasCanceledForcibly())
+    {
+        s_cache->insert(cacheKey(), image, pixmap, cropRect, true);
 
         setCropRect(cropRect);
     }
     else if(!m_renderTask.wasCanceled())
     {
-        m_pixmap = QPixmap::fromImage(image);
+        // The image is only at hand now, so the tile is cached right away instead of when it is painted.
+        s_cache->insert(cacheKey(), image, pixmap, cropRect);
+
+        m_pixmap = pixmap;
 
         setCropRect(cropRect);
     }
@@ -245,50 +407,170 @@ void TileItem::onCanceled()
 
 void TileItem::onFinishedOrCanceled()
 {
+    m_prerendering = false;
+
     if(m_deleteAfterRender)
     {
         m_renderTask.deleteParentLater();
     }
-    else if(!m_page->useTiling() || m_page->m_exposedTileItems.contains(this))
+    else if(m_preview || !m_page->useTiling() || m_page->m_exposedTileItems.contains(this))
     {
         m_page->update();
     }
 }
 
+RenderParam TileItem::renderParam() const
+{
+    return m_preview ? previewRenderParam(m_page->m_renderParam) : m_page->m_renderParam;
+}
+
+RenderParam TileItem::previewRenderParam(const RenderParam& pageRenderParam)
+{
+    RenderParam renderParam = pageRenderParam;
+
+    renderParam.setScaleFactor(previewScaleFactor * renderParam.scaleFactor());
+    renderParam.setTrimMargins(false);
+    renderParam.setDisableAntialiasing(true);
+
+    return renderParam;
+}
+
+QRect TileItem::renderRect() const
+{
+    // The preview always covers the whole page.
+    return m_preview ? QRect() : m_rect;
+}
+
+RenderPriority TileItem::renderPriority(bool prefetch) const
+{
+    if(m_preview)
+    {
+        return RenderPriority(prefetch ? RenderPriority::PrefetchClass : RenderPriority::VisibleClass);
+    }
+
+    return m_page->renderPriority(m_rect, prefetch);
+}
+
 inline TileItem::CacheKey TileItem::cacheKey() const
 {
-    QByteArray key;
-    QDataStream stream(&key, QIODevice::WriteOnly);
+    // Only the preview derives its render parameters, the tiles use those of their page as they are.
+    return CacheKey(m_page->m_documentKey, m_page->m_index, m_preview ? renderParam() : m_page->m_renderParam, m_rect);
+}
+
+TileItem::CacheKey TileItem::sharingKey() const
+{
+    // Documents without an identity are never shared.
+    if(m_page->documentId().isEmpty())
+    {
+        return {};
+    }
 
-    stream << m_page->m_renderParam << m_rect;
+    return CacheKey(m_page->m_documentKey, m_page->m_index, renderParam(), renderRect());
+}
 
-    return qMakePair(m_page, key);
+bool TileItem::useDiskCache() const
+{
+    return (m_preview || m_page->m_paintMode == PageItem::ThumbnailMode) && m_page->hasPersistentDocumentId();
+}
+
+DiskTileCacheKey TileItem::diskCacheKey() const
+{
+    return DiskTileCacheKey(m_page->documentId(), m_page->m_index, renderParam(), renderRect(), s_settings->pageItem().paperColor());
+}
+
+bool TileItem::loadFromDiskCache()
+{
+    QImage image;
+    QRectF cropRect;
+
+    if(!s_diskCache->load(diskCacheKey(), image, cropRect))
+    {
+        return false;
+    }
+
+    m_pixmap = QPixmap::fromImage(image);
+
+    if(m_pixmap.isNull())
+    {
+        return false;
+    }
+
+    s_cache->insert(cacheKey(), image, m_pixmap, cropRect);
+
+    m_obsoletePixmap = QPixmap();
+
+    setCropRect(cropRect);
+
+    m_page->update();
+
+    return true;
+}
+
+bool TileItem::paintFallback(QPainter* painter, const QPointF& topLeft) const
+{
+    const QSizeF itemSize = m_page->m_boundingRect.size();
+
+    if(m_preview || itemSize.isEmpty())
+    {
+        return false;
+    }
+
+    const QRectF normalizedRect(m_rect.x() / itemSize.width(), m_rect.y() / itemSize.height(),
+                                m_rect.width() / itemSize.width(), m_rect.height() / itemSize.height());
+
+    const QVector< TileCache::Fallback > fallbacks = s_cache->fallbacks(cacheKey(), normalizedRect, m_page->m_size);
+
+    if(fallbacks.isEmpty())
+    {
+        return false;
+    }
+
+    painter->save();
+
+    painter->setClipRect(QRectF(m_rect).translated(topLeft), Qt::IntersectClip);
+    painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+    foreach(const TileCache::Fallback& fallback, fallbacks)
+    {
+        const QRectF& rect = fallback.normalizedRect;
+
+        painter->drawPixmap(QRectF(topLeft.x() + rect.x() * itemSize.width(), topLeft.y() + rect.y() * itemSize.height(),
+                                   rect.width() * itemSize.width(), rect.height() * itemSize.height()),
+                            fallback.pixmap, QRectF());
+    }
+
+    painter->restore();
+
+    return true;
 }
 
 QPixmap TileItem::takePixmap()
 {
     const CacheKey key = cacheKey();
 
-    if(const CacheObject* object = s_cache.object(key))
+    if(const TileCache::Object* object = s_cache->object(key))
     {
         m_obsoletePixmap = QPixmap();
 
-        setCropRect(object->second);
-        return object->first;
+        setCropRect(object->cropRect);
+        return object->pixmap;
     }
 
+    if(m_pixmap.isNull())
+    {
+        startRender();
+    }
+
+    // The pixmap might have been loaded from disk when starting to render.
     QPixmap pixmap;
 
     if(!m_pixmap.isNull())
     {
-        s_cache.insert(key, new CacheObject(m_pixmap, m_cropRect), cacheCost(m_pixmap));
+        // The tile was evicted meanwhile and is cached again, taking back its compressed form from the second tier.
+        s_cache->insert(key, QImage(), m_pixmap, m_cropRect);
 
         pixmap = m_pixmap;
     }
-    else
-    {
-        startRender();
-    }
 
     return pixmap;
 }
@@ -22,21 +22,23 @@ along with qpdfview.  If not, see <http://www.gnu.org/licenses/>.
 #ifndef TILEITEM_H
 #define TILEITEM_H
 
-#include <QCache>
 #include <QObject>
 #include <QPixmap>
 
 #include "rendertask.h"
+#include "tilecache.h"
 
 namespace qpdfview
 {
 
+class DiskTileCache;
+class DiskTileCacheKey;
 class PageItem;
 
 class TileItem : public RenderTaskParent
 {
 public:
-    explicit TileItem(PageItem* page);
+    explicit TileItem(PageItem* page, bool preview = false);
     ~TileItem() override;
 
     DECL_NODISCARD
@@ -54,13 +56,38 @@ public:
 
     static void dropCachedPixmaps(PageItem* page);
 
+    // the scale of the preview relative to the page
+    static qreal previewScale();
+    // the rectangle of the preview covering a page with the given bounding rectangle
+    static QRect previewRect(const QRectF& boundingRect);
+
+    // true if the preview of a page is ready in the cache or on disk,
+    // so that prerendering can skip pages without creating their items
+    static bool isPreviewPrerendered(const QByteArray& documentId, bool persistentDocumentId, int index,
+                                     const RenderParam& pageRenderParam, const QRectF& boundingRect);
+
+    DECL_NODISCARD
+    bool isRendering() const { return m_renderTask.isRunning(); }
+
+    DECL_NODISCARD
+    bool isReady() const;
+    // true if the pixmap is ready or can be loaded from disk without rendering
+    DECL_NODISCARD
+    bool isPrerendered() const;
+
     DECL_NODISCARD
-    bool paint(QPainter* painter, QPointF topLeft);
+    bool paint(QPainter* painter, QPointF topLeft, bool hasPreview = false);
+    // Paints the low-resolution preview of a whole page scaled to the given rectangle.
+    bool paintPreview(QPainter* painter, const QRectF& rect);
 
 public:
     void refresh(bool keepObsoletePixmaps = false);
 
     int startRender(bool prefetch = false);
+    // Renders into the cache behind all other tasks, e.g. while the application is idle.
+    int startPrerender();
+    // Cancels a prerender which was not requested otherwise meanwhile and returns whether there was one.
+    bool cancelPrerender();
     void cancelRender();
 
     void deleteAfterRender();
@@ -68,7 +95,7 @@ public:
 private:
     void onFinished(const RenderParam& renderParam,
                      const QRect& rect, bool prefetch,
-                     const QImage& image, const QRectF& cropRect) override;
+                     const QImage& image, const QPixmap& pixmap, const QRectF& cropRect) override;
     void onCanceled() override;
     void onFinishedOrCanceled();
 
@@ -77,14 +104,32 @@ private:
 
     static Settings* s_settings;
 
-    typedef QPair< PageItem*, QByteArray > CacheKey;
-    typedef QPair< QPixmap, QRectF > CacheObject;
+    typedef TileCache::Key CacheKey;
 
-    static QCache< CacheKey, CacheObject > s_cache;
+    static TileCache* s_cache;
 
     CacheKey cacheKey() const;
 
+    // identifies identical renders of the same document page in other views
+    CacheKey sharingKey() const;
+
+    static DiskTileCache* s_diskCache;
+
+    // Thumbnails and previews of documents with a persistent identity are kept on disk.
+    bool useDiskCache() const;
+    DiskTileCacheKey diskCacheKey() const;
+
+    bool loadFromDiskCache();
+
     PageItem* m_page;
+    bool m_preview;
+
+    RenderParam renderParam() const;
+    static RenderParam previewRenderParam(const RenderParam& pageRenderParam);
+    QRect renderRect() const;
+    RenderPriority renderPriority(bool prefetch) const;
+
+    int startRender(bool prefetch, const RenderPriority& priority);
 
     QRect m_rect;
     QRectF m_cropRect;
@@ -95,7 +140,11 @@ private:
 
     QPixmap takePixmap();
 
+    // Stretches cached tiles of other resolution levels over the tile until it is rendered.
+    bool paintFallback(QPainter* painter, const QPointF& topLeft) const;
+
     bool m_deleteAfterRender;
+    bool m_prerendering;
     RenderTask m_renderTask;
 
 };